@@ -9,16 +9,34 @@ LOCAL_C_INCLUDES := $(LOCAL_PATH) \
      ../SDL2_image/
 
 LOCAL_SRC_FILES := src/animate.c \
+                   src/arena.c \
                    src/cage.c \
+                   src/draw_queue.c \
                    src/easing.c \
+                   src/entities.c \
+                   src/file.c \
                    src/font.c \
                    src/geometry.c \
                    src/image.c \
+                   src/jobs.c \
                    src/keyboard.c \
+                   src/lightmap.c \
+                   src/memory_stats.c \
                    src/mouse.c \
+                   src/pack.c \
+                   src/particles.c \
+                   src/path.c \
+                   src/render_pass.c \
+                   src/replay.c \
                    src/screen.c \
+                   src/snapshot.c \
                    src/sound.c \
                    src/sprite.c \
+                   src/sprite_batch.c \
+                   src/sprite_sheet.c \
+                   src/tile_animation.c \
+                   src/tile_layer.c \
+                   src/tilemap.c \
                    src/timeline.c
 	
 
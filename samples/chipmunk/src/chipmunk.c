@@ -47,6 +47,7 @@ struct tile {
 /* The game state is the top-level data-structure in this sample.
  * It holds the tiles array, the tile image and the basic
  * Chipmunk2D entities we'll use, primarily the space entity.
+ * The sparks particle emitter trails the tile held by the mouse.
  */
 #define N_WALLS 4
 struct state {
@@ -56,6 +57,7 @@ struct state {
     cpBody* mouse_body;
     cpConstraint* mouse_joint;
     cpShape* walls[N_WALLS];
+    struct particle_emitter* sparks;
 };
 
 #define GRABBABLE_MASK_BIT (1 << 31)
@@ -141,6 +143,28 @@ static void cleanup_walls(struct state* state)
     }
 }
 
+/* Preparing the sparks
+ * --------------------
+ *
+ * Sparks are plain particles rather than Chipmunk2D bodies, since
+ * they never collide with anything. The emitter reuses the tile
+ * image, shrinking and fading each spark from orange to a
+ * transparent red as it falls.
+ */
+static void init_sparks(struct state* state)
+{
+    state->sparks = create_particle_emitter(state->tile_img, 4000);
+    state->sparks->min_speed = 20;
+    state->sparks->max_speed = 80;
+    state->sparks->min_life = 300;
+    state->sparks->max_life = 900;
+    state->sparks->gravity_y = 200;
+    state->sparks->end_scale = 0.25f;
+    state->sparks->start_color = color_from_RGBA(255, 180, 40, 255);
+    state->sparks->end_color = color_from_RGBA(200, 20, 0, 0);
+    state->sparks->alpha_easing = quadratic_ease_in;
+}
+
 /* create_sample is our game state's initialization function
  * and will return a fully ready instance of struct state for us
  * to work with in each frame.
@@ -153,6 +177,7 @@ static void* create_sample(void)
     state->mouse_body = cpBodyNewKinematic();
     init_tiles(state);
     init_walls(state);
+    init_sparks(state);
     return state;
 }
 
@@ -210,6 +235,9 @@ static void apply_mouse_motion(struct state* state)
  * simulation by the 1/1000s fration of a second passed and
  * then drawing any active tile using its up-to-date
  * position.
+ * While a tile is held, the sparks emitter follows the mouse
+ * body and keeps emitting. All sparks are drawn in a single
+ * call on top of the tiles.
  * We then delegate any mouse actions to apply_mouse_motion().
  */
 static void update_sample(void* data, float elapsed_ms)
@@ -225,20 +253,27 @@ static void update_sample(void* data, float elapsed_ms)
                        pos.y - state->tile_img->height / 2, NULL, 0);
         }
     }
+    cpVect mouse_pos = cpBodyGetPosition(state->mouse_body);
+    state->sparks->x = mouse_pos.x;
+    state->sparks->y = mouse_pos.y;
+    state->sparks->rate = state->mouse_joint != NULL ? 1500 : 0;
+    update_particles(state->sparks, elapsed_ms);
+    draw_particles(state->sparks);
     apply_mouse_motion(state);
 }
 
 /* Cleanup
  * -------
  *
- * Clean up is simple enough. Just destroy the tile
- * image and free the state structure memory.
+ * Clean up is simple enough. Just destroy the sparks emitter,
+ * the tile image and free the state structure memory.
  */
 static void destroy_sample(void* data)
 {
     struct state* state = data;
     cleanup_walls(state);
     cleanup_tiles(state);
+    destroy_particle_emitter(state->sparks);
     destroy_image(state->tile_img);
     cpBodyFree(state->mouse_body);
     cpSpaceFree(state->space);
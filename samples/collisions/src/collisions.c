@@ -12,20 +12,19 @@
  * ------------
  *
  * For this demo we will use a star image.
- * Each star will have its own position,
- * motion vector and bounding box.
+ * Each star is an entity in a world, with a position,
+ * a motion vector and a bounding box. Position and
+ * bounding box components are built into the world,
+ * the motion vector is a component type of our own.
  */
 #define MAX_STARS 12
 
-struct star {
-    vec star_pos;
-    vec star_vec;
-    bbox star_bbox;
-};
-
 struct state {
     struct image* star_img;
-    struct star stars[MAX_STARS];
+    struct world* world;
+    struct entity_query* moving;
+    int motion;
+    int stars[MAX_STARS];
 };
 
 /*
@@ -37,12 +36,26 @@ static void* create_sample(void)
     int i;
     struct state* state = malloc(sizeof(struct state));
     state->star_img = create_image("res/star.png");
+    state->world = create_world();
+    state->motion = register_component(state->world, sizeof(vec));
+    state->moving = create_query(state->world,
+                                 COMPONENT(POSITION_COMPONENT) |
+                                 COMPONENT(BBOX_COMPONENT) |
+                                 COMPONENT(state->motion),
+                                 0);
     for (i = 0; i < MAX_STARS; i++) {
-        state->stars[i].star_pos = xy_vec(i * 16, i * 16);
-        state->stars[i].star_vec = xy_vec(2 - rand() % 4, 2 - rand() % 4);
-        state->stars[i].star_bbox.p1 = state->stars[i].star_pos;
-        state->stars[i].star_bbox.p2 =
-        add_vec(state->stars[i].star_pos, xy_vec(16, 16));
+        int star = create_entity(state->world,
+                                 COMPONENT(POSITION_COMPONENT) |
+                                 COMPONENT(BBOX_COMPONENT) |
+                                 COMPONENT(state->motion));
+        vec* pos = get_component(state->world, star, POSITION_COMPONENT);
+        vec* motion = get_component(state->world, star, state->motion);
+        bbox* box = get_component(state->world, star, BBOX_COMPONENT);
+        *pos = xy_vec(i * 16, i * 16);
+        *motion = xy_vec(2 - rand() % 4, 2 - rand() % 4);
+        box->p1 = *pos;
+        box->p2 = add_vec(*pos, xy_vec(16, 16));
+        state->stars[i] = star;
     }
     return state;
 }
@@ -50,21 +63,37 @@ static void* create_sample(void)
 /* Moving the stars
  * ----------------
  *
- * update_star() moves a star on the screen using the star
- * motion vector and tests for screen bounds collisions.
+ * move_stars() is a system. It gets the stars chunk by
+ * chunk, moves each star using its motion vector and
+ * tests for screen bounds collisions.
  */
-static void update_star(struct star* star, float elapsed_ms)
+static void move_stars(struct entity_chunk* chunk, void* data)
 {
+    struct state* state = data;
     bbox screen_bbox = { { 0, 0 }, { 192, 108 } };
-    star->star_pos = add_vec(star->star_pos, star->star_vec);
-    star->star_bbox = translate_bbox(star->star_bbox, star->star_pos);
-    if (bbox_in_bbox(star->star_bbox, screen_bbox) == 0) {
-        if (star->star_bbox.p1.x < screen_bbox.p1.x) star->star_vec.x = 1;
-        if (star->star_bbox.p1.y < screen_bbox.p1.y) star->star_vec.y = 1;
-        if (star->star_bbox.p2.x > screen_bbox.p2.x) star->star_vec.x = -1;
-        if (star->star_bbox.p2.y > screen_bbox.p2.y) star->star_vec.y = -1;
+    vec* pos = get_chunk_components(chunk, POSITION_COMPONENT);
+    vec* motion = get_chunk_components(chunk, state->motion);
+    bbox* box = get_chunk_components(chunk, BBOX_COMPONENT);
+    int i;
+    for (i = 0; i < chunk->count; i++) {
+        pos[i] = add_vec(pos[i], motion[i]);
+        box[i] = translate_bbox(box[i], pos[i]);
+        if (bbox_in_bbox(box[i], screen_bbox) == 0) {
+            if (box[i].p1.x < screen_bbox.p1.x) motion[i].x = 1;
+            if (box[i].p1.y < screen_bbox.p1.y) motion[i].y = 1;
+            if (box[i].p2.x > screen_bbox.p2.x) motion[i].x = -1;
+            if (box[i].p2.y > screen_bbox.p2.y) motion[i].y = -1;
+        }
     }
-    UNUSED(elapsed_ms);
+}
+
+static void draw_stars(struct entity_chunk* chunk, void* data)
+{
+    struct state* state = data;
+    vec* pos = get_chunk_components(chunk, POSITION_COMPONENT);
+    int i;
+    for (i = 0; i < chunk->count; i++)
+        draw_image(state->star_img, VEC_XY(pos[i]), NULL, 0);
 }
 
 /* Collision detection
@@ -77,47 +106,49 @@ static void update_star(struct star* star, float elapsed_ms)
  * If we detect a collision, we swap the star pair
  * motion vectors to create a deflection effect.
  *
- * When done, we update and draw the stars.
+ * When done, we run the systems that move and draw
+ * the stars.
  */
 static void update_sample(void* data, float elapsed_ms)
 {
     struct state* state = data;
-    int visited[MAX_STARS][MAX_STARS] = { { 0 } };
+    struct world* world = state->world;
     int i, j;
     for (i = 0; i < MAX_STARS; i++) {
-        for (j = 0; j < MAX_STARS; j++) {
-            if (i != j && visited[i][j] == 0 && visited[j][i] == 0) {
-                bbox sub;
-                struct star* a = &state->stars[i];
-                struct star* b = &state->stars[j];
-                if (bbox_intersect(a->star_bbox, b->star_bbox, &sub)) {
-                    struct rectangle r1, r2;
-                    r1 = rect_from_sub_bbox(a->star_bbox, sub);
-                    r2 = rect_from_sub_bbox(b->star_bbox, sub);
-                    if (pixels_collide(state->star_img, &r1, state->star_img,
-                                       &r2))
-                        swap_vecs(&a->star_vec, &b->star_vec);
-                }
-                visited[i][j] = 1;
+        for (j = i + 1; j < MAX_STARS; j++) {
+            bbox sub;
+            bbox* a = get_component(world, state->stars[i], BBOX_COMPONENT);
+            bbox* b = get_component(world, state->stars[j], BBOX_COMPONENT);
+            if (bbox_intersect(*a, *b, &sub)) {
+                struct rectangle r1, r2;
+                r1 = rect_from_sub_bbox(*a, sub);
+                r2 = rect_from_sub_bbox(*b, sub);
+                if (pixels_collide(state->star_img, &r1, state->star_img, &r2))
+                    swap_vecs(get_component(world, state->stars[i],
+                                            state->motion),
+                              get_component(world, state->stars[j],
+                                            state->motion));
             }
         }
     }
     screen_color(color_from_RGB(10, 20, 50));
-    for (i = 0; i < MAX_STARS; i++) {
-        update_star(&state->stars[i], elapsed_ms);
-        draw_image(state->star_img, VEC_XY(state->stars[i].star_pos), NULL, 0);
-    }
+    run_system(state->moving, move_stars, state);
+    run_system(state->moving, draw_stars, state);
+    UNUSED(elapsed_ms);
 }
 
 /* Cleanup
  * -------
  *
- * Clean up is simple enough. Just destroy the star
- * image and free the state structure memory.
+ * Clean up is simple enough. Destroy the query, the world
+ * with all of its stars and the star image, and free the
+ * state structure memory.
  */
 static void destroy_sample(void* data)
 {
     struct state* state = data;
+    destroy_query(state->moving);
+    destroy_world(state->world);
     destroy_image(state->star_img);
     free(data);
 }
@@ -0,0 +1,195 @@
+/* samples / pack.c
+ * ================
+ * This sample is a small tool that bundles game assets into a pack,
+ * the file the game loop mounts before setup when it finds one.
+ * Run it from the game directory, with the pack to write followed by
+ * the assets to put in it:
+ *
+ *     pack res.pak res/cage.png res/game.tmx
+ *
+ * Given --bench instead of a pack, it measures how long loading the
+ * same assets takes from loose files and from packs:
+ *
+ *     pack --bench res/cage.png res/game.tmx
+ *
+ */
+#include "cage.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Each loading time is the fastest of a few rounds, so a hiccup of the
+ * system does not skew it. Only the first round may read from the
+ * disk, the others find the files in the operating system cache, like
+ * a game started a second time does.
+ */
+#define ROUNDS 5
+#define STORED_PACK "bench_stored.pak"
+#define LZ4_PACK "bench_lz4.pak"
+
+static const char** assets;
+static int n_assets;
+
+/* Packing
+ * -------
+ *
+ * Assets are looked up in a pack by the path they were packed from,
+ * so packing "res/cage.png" lets create_image("res/cage.png") find it
+ * without touching the file system.
+ */
+static int pack_assets(const char* filepath)
+{
+    if (build_pack(filepath, assets, n_assets) == -1) {
+        fprintf(stderr, "%s\n", get_error_msgs());
+        return 1;
+    }
+    printf("Packed %d assets into %s\n", n_assets, filepath);
+    return 0;
+}
+
+/* Loading
+ * -------
+ *
+ * Loading an asset here is opening it with open_asset(), as every
+ * Cage loader does, and reading it whole.
+ */
+static int load_assets(void)
+{
+    SDL_RWops* rw;
+    Sint64 size;
+    char* buf;
+    int i, ok;
+    for (i = 0; i < n_assets; i++) {
+        rw = open_asset(assets[i]);
+        if (rw == NULL) return -1;
+        size = SDL_RWsize(rw);
+        buf = (char*)malloc(size > 0 ? (size_t)size : 1);
+        ok = buf != NULL && size >= 0 &&
+             (size == 0 || SDL_RWread(rw, buf, (size_t)size, 1) == 1);
+        free(buf);
+        SDL_RWclose(rw);
+        if (!ok) return -1;
+    }
+    return 0;
+}
+
+/* A round mounts the pack, when there is one, preloads every asset in
+ * a single batch when asked to and loads them all. It returns the time
+ * that took in milliseconds, or a negative time on error.
+ */
+static float time_round(const char* pack, bool preload)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    float ms = -1.0f;
+    if (pack != NULL && mount_pack(pack) == -1) return ms;
+    if ((!preload || preload_assets(assets, n_assets) == 0) &&
+        load_assets() == 0)
+        ms = (float)(SDL_GetPerformanceCounter() - start) * 1000.0f /
+             SDL_GetPerformanceFrequency();
+    release_preloaded_assets();
+    unmount_packs();
+    return ms;
+}
+
+static long file_size(const char* filepath)
+{
+    Sint64 size;
+    SDL_RWops* rw = SDL_RWFromFile(filepath, "rb");
+    if (rw == NULL) return -1;
+    size = SDL_RWsize(rw);
+    SDL_RWclose(rw);
+    return (long)size;
+}
+
+static void report(const char* name, const char* pack, bool preload)
+{
+    float best = -1.0f;
+    float ms;
+    int i;
+    for (i = 0; i < ROUNDS; i++) {
+        ms = time_round(pack, preload);
+        if (ms < 0) {
+            printf("%-24s failed\n%s\n", name, get_error_msgs());
+            return;
+        }
+        if (best < 0 || ms < best) best = ms;
+    }
+    printf("%-24s %10.3f ms\n", name, best);
+}
+
+/* Benchmarking
+ * ------------
+ *
+ * The benchmark runs as the create function of a game state, so the
+ * job workers that decompress LZ4 blocks in parallel are started the
+ * same way they are in a game. It builds a pack that stores every
+ * asset as it is and one that compresses them, then times loading the
+ * assets from loose files and from both packs, with and without
+ * preloading them first.
+ *
+ * The game loop mounts res.pak when there is one, so the packs are
+ * unmounted first to load the loose files from the file system.
+ */
+static void* create_bench(void)
+{
+    unmount_packs();
+    if (build_pack_ex(STORED_PACK, assets, n_assets, false) == -1 ||
+        build_pack_ex(LZ4_PACK, assets, n_assets, true) == -1)
+        return NULL;
+    printf("Stored pack %ld bytes, LZ4 pack %ld bytes\n",
+           file_size(STORED_PACK), file_size(LZ4_PACK));
+    printf("Loading %d assets with %d job workers, fastest of %d rounds\n",
+           n_assets, get_worker_count(), ROUNDS);
+    report("loose files", NULL, false);
+    report("stored pack", STORED_PACK, false);
+    report("stored pack, preloaded", STORED_PACK, true);
+    report("LZ4 pack", LZ4_PACK, false);
+    report("LZ4 pack, preloaded", LZ4_PACK, true);
+    return &n_assets;
+}
+
+/* All the work is done by the time the first frame is drawn.
+ */
+static void update_bench(void* data, float elapsed_ms)
+{
+    exit(0);
+    UNUSED(data);
+    UNUSED(elapsed_ms);
+}
+
+static void destroy_bench(void* data)
+{
+    UNUSED(data);
+}
+
+/* Job workers are opt-in, the benchmark asks for one per core.
+ */
+static void setup_bench(struct settings* settings)
+{
+    settings->window_width = 320;
+    settings->window_height = 180;
+    settings->logical_width = 320;
+    settings->logical_height = 180;
+    settings->worker_threads = -1;
+}
+
+/* The main
+ * --------
+ *
+ * Building a pack needs no window, so only the benchmark goes through
+ * the game loop.
+ */
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s PACK ASSET...\n"
+                        "       %s --bench ASSET...\n",
+                argv[0], argv[0]);
+        return 1;
+    }
+    assets = (const char**)(argv + 2);
+    n_assets = argc - 2;
+    if (strcmp(argv[1], "--bench") != 0) return pack_assets(argv[1]);
+    return game_setup_and_loop(setup_bench, create_bench, update_bench,
+                               destroy_bench);
+}
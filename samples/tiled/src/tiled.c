@@ -9,6 +9,11 @@
  */
 #define TILE_SIZE 16
 
+/* Our Tiled map and the binary cache we keep for it.
+ */
+#define MAP_FILE "res/game.tmx"
+#define MAP_CACHE "res/game.map"
+
 /* The hero struct is used to animate and manage our main actor.
  * It contains an actor struct that in turn, makes sure the hero
  * moves properly inside our tilemap.
@@ -34,6 +39,30 @@ struct hero {
  */
 enum map_layer { BASE, FEATURES, OVERLAY, OBJECTS, _NUM_OF_LAYERS };
 
+/* The tile layers we draw. GRASS and GRASS_FEATURES draw the
+ * BASE and FEATURES map layers again using the grass spritemap,
+ * and SHADOWS draws the FEATURES map layer using the shadow map.
+ */
+enum draw_layer {
+    BACKGROUND,
+    GRASS,
+    GRASS_FEATURES,
+    FOREGROUND,
+    SHADOWS,
+    _NUM_OF_DRAW_LAYERS
+};
+
+/* Depths of everything we draw in a frame, back to front.
+ */
+enum depth {
+    GROUND_DEPTH,
+    ACTORS_DEPTH,
+    GRASS_DEPTH,
+    GRASS_FEATURES_DEPTH,
+    EFFECTS_DEPTH,
+    CANOPY_DEPTH
+};
+
 /* The game struct holds everything we need to run the main
  * game state, including our hero,  the Tiled layers we need
  * and the tiles spritemaps.
@@ -46,55 +75,86 @@ struct game {
     struct sprite* tiles;
     struct sprite* grass;
     struct sprite* shadows;
-    struct image* actor_effects;
+    struct render_passes* passes;
+    struct draw_queue* queue;
+    int hero_frame;
     struct map_spec map_spec;
-    tmx_layer* layers[_NUM_OF_LAYERS];
+    struct tile_layer* tile_layers[_NUM_OF_DRAW_LAYERS];
 };
 
-/* We use a straightforward approach to read the Tiled
- * tilemap using libtmx. We assume the existance of
- * exactly 4 layers and we make sure to populate
- * all 4 of them, otherwise we indicate an error
- * by returning -1.
+/* libtmx reads the map through open_asset(), so
+ * the map can come from a pack like any other asset.
  */
-static int read_map(struct game* game, tmx_map* m)
+static int read_map_chunk(void* rw, char* buffer, int len)
 {
-    game->map_spec.rows = m->height;
-    game->map_spec.cols = m->width;
-    game->map_spec.tile_size = TILE_SIZE;
-    game->map_spec.data = m;
-    tmx_layer* l = (l = game->layers[BASE] = m->ly_head) ?
-                   (l = game->layers[FEATURES] = l->next) ?
-                   (l = game->layers[OVERLAY] = l->next) ?
-                   (l = game->layers[OBJECTS] = l->next) : NULL : NULL : NULL;
-    return l == NULL ? -1 : 0;
+    return (int)SDL_RWread((SDL_RWops*)rw, buffer, 1, len);
 }
 
-/* get_tile_id makes it easier to get the int gid value from libtmx
- * for a specific tile_pos.
+/* We use libtmx to read the Tiled tilemap into a cage
+ * tilemap. We assume the existance of exactly 4 layers,
+ * otherwise we indicate an error by returning NULL.
+ * The OBJECTS layer only holds our hero origin, so we
+ * keep it as a single marker tile.
+ * Walls, water and rocks are marked as blocked tiles, so
+ * checking if a tile is walkable is a single bit test.
  */
-static int get_tile_id(tmx_map* m, tmx_layer* l, struct tile_pos tp)
+static struct tilemap* parse_map(void)
 {
-    return l->content.gids[tp.row * m->width + tp.col] & TMX_FLIP_BITS_REMOVAL;
+    static const uint16_t blocked_base[] = { 17 };
+    static const uint16_t blocked_features[] = { 50, 47 };
+    struct tilemap* map = NULL;
+    tmx_layer* layers[_NUM_OF_LAYERS];
+    SDL_RWops* rw = open_asset(MAP_FILE);
+    tmx_map* m = rw != NULL ? tmx_load_callback(read_map_chunk, rw) : NULL;
+    if (rw != NULL) SDL_RWclose(rw);
+    if (m == NULL) {
+        ERROR("Error reading tmx file.");
+        return NULL;
+    }
+    tmx_layer* l = (l = layers[BASE] = m->ly_head) ?
+                   (l = layers[FEATURES] = l->next) ?
+                   (l = layers[OVERLAY] = l->next) ?
+                   (l = layers[OBJECTS] = l->next) : NULL : NULL : NULL;
+    if (l == NULL || l->type != L_OBJGR || l->content.objgr->head == NULL)
+        goto done;
+    map = create_tilemap(m->width, m->height, _NUM_OF_LAYERS, TILE_SIZE,
+                         TILE_SIZE);
+    if (map == NULL) goto done;
+    for (int i = BASE; i < OBJECTS; i++)
+        for (int r = 0; r < map->rows; r++)
+            for (int c = 0; c < map->cols; c++)
+                set_map_tile(map, i, c, r,
+                             layers[i]->content.gids[r * m->width + c] &
+                             TMX_FLIP_BITS_REMOVAL);
+    tmx_object* obj = l->content.objgr->head;
+    set_map_tile(map, OBJECTS, (int)obj->x / TILE_SIZE,
+                 (int)obj->y / TILE_SIZE, 1);
+    block_map_tiles(map, BASE, blocked_base, 1);
+    block_map_tiles(map, FEATURES, blocked_features, 2);
+done:
+    tmx_map_free(m);
+    return map;
 }
 
-/* We use libtmx to load our game's Tiled file and
- * then call read_map to store our required tilemap
- * layers.
+/* Parsing the Tiled XML file gets slow for big maps, so
+ * the first run stores the parsed tilemap in a binary
+ * cache next to it. Later runs read the cache, unless
+ * the Tiled file changed since.
  */
 static int build_tilemap(struct game* game)
 {
-    tmx_map* m;
-    m = tmx_load("res/game.tmx");
-    if (m == NULL) {
-        printf("Error reading tmx file.");
-        goto error;
-    } else {
-        if (read_map(game, m) == -1) goto error;
+    uint32_t hash = hash_map_source(MAP_FILE);
+    struct tilemap* map = load_tilemap(MAP_CACHE, hash);
+    if (map == NULL) {
+        map = parse_map();
+        if (map == NULL) return -1;
+        save_tilemap(map, MAP_CACHE, hash);
     }
+    game->map_spec.rows = map->rows;
+    game->map_spec.cols = map->cols;
+    game->map_spec.tile_size = TILE_SIZE;
+    game->map_spec.data = map;
     return 0;
-error:
-    return -1;
 }
 
 #define CHECK(S,E) if ((S) == NULL) { \
@@ -112,97 +172,72 @@ static int draw_actors(struct game* game)
                        game->hero.actor.pos.y - game->camera.y - TILE_SIZE);
 }
 
-/* Our tiles art are stored as spritemaps. Drawing
- * the tiles means drawing one of the frames in
- * one of the spritemaps we use for each layer.
+/* Our tiles art are stored as spritemaps. Each map layer is
+ * copied into a tile layer that uses one of the spritemaps.
+ * Tile layers pre-render chunks of tiles, so drawing a whole
+ * layer only takes a few draw calls.
  */
-static void draw_tile(struct game* game,
-                      struct sprite* tilemap,
-                      enum map_layer layer_name,
-                      struct tile_pos pos)
+static struct tile_layer* build_tile_layer(struct game* game,
+                                           struct sprite* tilemap,
+                                           enum map_layer layer_name)
 {
-    draw_sprite_frame(tilemap,
-                      TILE_SIZE * (pos.col) - game->camera.x,
-                      TILE_SIZE * (pos.row) - game->camera.y,
-                      get_tile_id(game->map_spec.data,
-                                  game->layers[layer_name], pos) - 1);
-}
-
-/* This high-order function will help us apply a function
- * for each visible tile that we need to draw. It will
- * help us draw the different layers of our tilemap
- * with significantly less lines of code.
- */
-static void foreach_visible_tile(struct game* game,
-                                 void (*callback)(struct game* game,
-                                                  int r,
-                                                  int c))
-{
-    int base_row = game->camera.y / TILE_SIZE - 1;
-    int base_col = game->camera.x / TILE_SIZE - 1;
-    int max_row = game->screen_height / TILE_SIZE + base_row + 3;
-    int max_col = game->screen_width / TILE_SIZE + base_col + 3;
-    for (int r = base_row; r < max_row; r++) {
-        for (int c = base_col; c < max_col; c++) {
-            if (c >= 0 && r >= 0 && c < game->map_spec.cols &&
-                r < game->map_spec.rows)
-                callback(game, r, c);
+    struct tile_layer* layer = create_tile_layer(tilemap,
+                                                 game->map_spec.cols,
+                                                 game->map_spec.rows);
+    if (layer == NULL) return NULL;
+    for (int r = 0; r < game->map_spec.rows; r++) {
+        for (int c = 0; c < game->map_spec.cols; c++) {
+            set_tile(layer, c, r,
+                     get_map_tile(game->map_spec.data, layer_name, c, r) - 1);
         }
     }
+    return layer;
 }
 
-/* The following set of callback functions are defined for
- * use with foreach_visible_tile. Each function is designed
- * to draw one of the layers of our tilemap.
- */
-static void draw_background(struct game* game, int r, int c)
-{
-    draw_tile(game, game->tiles, BASE, (struct tile_pos){ r, c });
-}
-
-static void draw_features(struct game* game, int r, int c)
-{
-    draw_tile(game, game->grass, BASE, (struct tile_pos){ r, c });
-    draw_tile(game, game->grass, FEATURES, (struct tile_pos){ r, c });
-}
-
-static void draw_foreground(struct game* game, int r, int c)
+static void draw_layer(struct game* game, enum draw_layer layer)
 {
-    draw_tile(game, game->tiles, OVERLAY, (struct tile_pos){ r, c });
+    draw_tile_layer(game->tile_layers[layer], game->camera.x, game->camera.y,
+                    game->screen_width, game->screen_height);
 }
 
-static void draw_shadows(struct game* game, int r, int c)
+/* The actor effects render pass creates an overlay image for the
+ * actors sprite effects such as grass transparency and shadows.
+ * The pass target is cleared when it is bound.
+ */
+static void draw_actor_effects(void* data, struct render_pass* pass)
 {
-    draw_tile(game, game->shadows, FEATURES, (struct tile_pos){ r, c });
+    struct game* game = data;
+    draw_sprite_frame(game->hero.mask, game->hero.actor.pos.x - game->camera.x,
+                game->hero.actor.pos.y - game->camera.y - TILE_SIZE,
+                game->hero_frame);
+    draw_layer(game, SHADOWS);
 }
 
-/* The main drawing function carefully draws all the layers
- * of the tilemap and our hero using a nice scheme to help
- * up have shadows and grass overlay effects.
+/* The main drawing function queues all the layers of the
+ * tilemap and our hero, each at its own depth, using a nice
+ * scheme to help us have shadows and grass overlay effects.
+ * The draw queue draws everything back to front once flushed,
+ * so we are free to draw in whatever order suits us.
  */
 static void draw_game(void* data, float elapsed_ms)
 {
     struct game* game = data;
-    foreach_visible_tile(game, draw_background);
-    int f = draw_actors(game);
-    foreach_visible_tile(game, draw_features);
-    /** Creating an overlay image for the actors sprite effects
-     * such as grass transparency and shadows.
-     */
-    set_blend_mode(game->actor_effects, BLEND);
-    clear_image(game->actor_effects, color_from_RGBA(0, 0, 0, 0));
-    draw_on_image(game->actor_effects);
-    draw_sprite_frame(game->hero.mask, game->hero.actor.pos.x - game->camera.x,
-                game->hero.actor.pos.y - game->camera.y - TILE_SIZE, f);
-    set_blend_mode(game->shadows->image, MULTIPLY);
-    foreach_visible_tile(game, draw_shadows);
-    /** Time to render the prepared the effects layer. */
-    draw_on_screen();
-    set_blend_mode(game->actor_effects, BLEND);
-    draw_image(game->actor_effects, 0, 0, NULL, 0);
-    /** Finally, we draw the forground layer, such as tree canopies, bushes,
-     * etc.. */
-    foreach_visible_tile(game, draw_foreground);
+    queue_draws(game->queue, ACTORS_DEPTH);
+    game->hero_frame = draw_actors(game);
+    /** The effects layer uses the hero frame we just drew. Its pass
+     * draws off-screen right away, and only its composite is queued. */
+    queue_draws(game->queue, EFFECTS_DEPTH);
+    run_render_passes(game->passes);
+    queue_draws(game->queue, GROUND_DEPTH);
+    draw_layer(game, BACKGROUND);
+    queue_draws(game->queue, GRASS_DEPTH);
+    draw_layer(game, GRASS);
+    queue_draws(game->queue, GRASS_FEATURES_DEPTH);
+    draw_layer(game, GRASS_FEATURES);
+    /** The forground layer, such as tree canopies, bushes, etc.. */
+    queue_draws(game->queue, CANOPY_DEPTH);
+    draw_layer(game, FOREGROUND);
+    flush_draw_queue(game->queue);
 }
 
 static void read_controller(struct game* game, float elapsed_ms)
@@ -235,11 +270,7 @@ static int is_tile_walkable(struct map_spec* map_spec,
                             struct actor* actor,
                             struct tile_pos pos)
 {
-    tmx_map* map = map_spec->data;
-    int base_tile_id = get_tile_id(map, map->ly_head, pos);
-    int feature_tile_id = get_tile_id(map, map->ly_head->next, pos);
-    return (base_tile_id != 17 && feature_tile_id != 50 &&
-            feature_tile_id != 47);
+    return is_map_walkable(map_spec->data, pos.col, pos.row);
 }
 
 static void cleanup_hero(struct hero* hero)
@@ -307,19 +338,39 @@ static void* create_game(void)
 {
     struct game* game = calloc(1, sizeof(struct game));
     get_screen_size(&game->screen_width, &game->screen_height);
-    game->actor_effects = create_target_image(game->screen_width,
-                                              game->screen_height,
-                                              color_from_RGBA(0,0,0,0));
+    CHECK(game->passes = create_render_passes(1), create_failure);
+    struct render_pass* effects = add_render_pass(game->passes,
+                                                  game->screen_width,
+                                                  game->screen_height,
+                                                  draw_actor_effects, game);
+    effects->clear_on_bind = true;
+    effects->composite = true;
+    CHECK(game->queue = create_draw_queue(64), create_failure);
     CHECK(game->tiles = create_tileset("res/tileset.png"), create_failure);
     CHECK(game->grass = create_tileset("res/overlay.png"), create_failure);
     CHECK(game->shadows = create_tileset("res/shadowmap.png"), create_failure);
     if (init_hero(&game->hero) == -1) goto init_hero_error;
-    build_tilemap(game);
-    if (game->layers[OBJECTS]->type != L_OBJGR) goto invalid_layers;
-    tmx_object* obj = game->layers[OBJECTS]->content.objgr->head;
-    if (obj == NULL) goto invalid_layers;
-    game->hero.actor.pos.x = ((int)obj->x / TILE_SIZE) * TILE_SIZE;
-    game->hero.actor.pos.y = ((int)obj->y / TILE_SIZE) * TILE_SIZE;
+    if (build_tilemap(game) == -1) goto invalid_layers;
+    CHECK(game->tile_layers[BACKGROUND] =
+          build_tile_layer(game, game->tiles, BASE), create_failure);
+    CHECK(game->tile_layers[GRASS] =
+          build_tile_layer(game, game->grass, BASE), create_failure);
+    CHECK(game->tile_layers[GRASS_FEATURES] =
+          build_tile_layer(game, game->grass, FEATURES), create_failure);
+    CHECK(game->tile_layers[FOREGROUND] =
+          build_tile_layer(game, game->tiles, OVERLAY), create_failure);
+    CHECK(game->tile_layers[SHADOWS] =
+          build_tile_layer(game, game->shadows, FEATURES), create_failure);
+    game->tile_layers[SHADOWS]->blend = MULTIPLY;
+    struct tilemap* map = game->map_spec.data;
+    for (int r = 0; r < map->rows; r++) {
+        for (int c = 0; c < map->cols; c++) {
+            if (get_map_tile(map, OBJECTS, c, r) != 0) {
+                game->hero.actor.pos.x = c * TILE_SIZE;
+                game->hero.actor.pos.y = r * TILE_SIZE;
+            }
+        }
+    }
 all_is_well:
     return game;
 create_failure:
@@ -344,9 +395,12 @@ static void destroy_game(void* data)
     destroy_sprite(game->grass);
     destroy_image(game->shadows->image);
     destroy_sprite(game->shadows);
-    destroy_image(game->actor_effects);
+    for (int i = 0; i < _NUM_OF_DRAW_LAYERS; i++)
+        destroy_tile_layer(game->tile_layers[i]);
+    destroy_render_passes(game->passes);
+    destroy_draw_queue(game->queue);
     cleanup_hero(&game->hero);
-    tmx_map_free(game->map_spec.data);
+    destroy_tilemap(game->map_spec.data);
     free(game);
 }
 
@@ -213,16 +213,26 @@ static void animate_wizard(struct wizard* wizard, float elapsed_ms)
 struct game_title {
     struct sprite* sprite;
     struct animation* bling;
-    struct image* mask;
-    struct image* spot;
+    struct lightmap* lights;
+    struct light spot;
 };
 static int prepare_title(struct game_title* title);
 static void cleanup_title(struct game_title* title);
 
+/* The lightmap darkens the whole screen, except for the
+ * spot light. The lights are added again every frame, so
+ * lighting the title takes adding the spot and drawing.
+ */
+static void draw_title_lights(struct game_title* title)
+{
+    add_light(title->lights, &title->spot);
+    draw_lightmap(title->lights);
+}
+
 /* We create a sprite for the title and an animation
  * with 6 frames.
- * We also create a mask image for a spot and fade-in
- * effect.
+ * We also create a lightmap with a single spot light for
+ * a spot and fade-in effect.
  */
 static int prepare_title(struct game_title* title)
 {
@@ -236,12 +246,12 @@ static int prepare_title(struct game_title* title)
         add_frame(title->bling, f, SECOND / 10, NULL);
     title->bling->mode = FREEZE_LAST_FRAME;
 
-    title->mask = create_target_image(192, 108, color_from_RGB(50, 50, 50));
-    if (title->mask == NULL) goto error;
-    set_blend_mode(title->mask, MULTIPLY);
-    title->spot = create_image("res/spot.png");
-    if (title->spot == NULL) goto error;
-    set_blend_mode(title->spot, ADD);
+    title->lights = create_lightmap(192, 108, 4);
+    if (title->lights == NULL) goto error;
+    title->spot.x = 17;
+    title->spot.y = 72;
+    title->spot.radius = 32;
+    title->spot.color = color_from_RGB(255, 255, 255);
 
     return 0;
 
@@ -255,8 +265,7 @@ static void cleanup_title(struct game_title* title)
 {
     destroy_sprite(title->sprite);
     destroy_animation(title->bling);
-    destroy_image(title->spot);
-    destroy_image(title->mask);
+    destroy_lightmap(title->lights);
 }
 
 /* A Decorative Tree
@@ -336,31 +345,21 @@ static void destroy_level_data(struct level_data* ldata);
  */
 static void* before_title_in(void* data, float elapsed_ms, float progress)
 {
-    struct rectangle c = { 0, 0, 192, 108 };
-    struct rectangle r = { 0, 0, 64, 64 };
     struct level_data* ldata = data;
     UNUSED(elapsed_ms);
     UNUSED(progress);
-    clear_image(ldata->title.mask, color_from_RGB(0, 0, 0));
-    draw_on_image(ldata->title.mask);
-    draw_image(ldata->title.spot, -15, 40, &r, 0);
-    draw_on_screen();
-    draw_image(ldata->title.mask, 0, 0, &c, 0);
+    ldata->title.lights->ambient = color_from_RGB(0, 0, 0);
+    draw_title_lights(&ldata->title);
     return NULL;
 }
 
 static void* slide_title_in(void* data, float elapsed_ms, float progress)
 {
-    struct rectangle c = { 0, 0, 192, 108 };
-    struct rectangle r = { 0, 0, 64, 64 };
     struct level_data* ldata = data;
     UNUSED(elapsed_ms);
-    clear_image(ldata->title.mask,
-                color_from_RGB(255 * progress, 255 * progress, 255 * progress));
-    draw_on_image(ldata->title.mask);
-    draw_image(ldata->title.spot, -15, 40, &r, 0);
-    draw_on_screen();
-    draw_image(ldata->title.mask, 0, 0, &c, 0);
+    ldata->title.lights->ambient =
+    color_from_RGB(255 * progress, 255 * progress, 255 * progress);
+    draw_title_lights(&ldata->title);
     draw_sprite(ldata->title.sprite,
                 interpolate(-100, 20, progress, circular_ease_out), 10);
     return NULL;
@@ -42,7 +42,8 @@ class title {
         cage::screen::draw_on();
         _mask.draw(0, 0, &c, 0);
         _sprite.draw(
-            cage_interpolate(-100, 20, progress, cage_circular_ease_out), 10);
+            cage::interpolate<cage::ease::circular_out>(-100, 20, progress),
+            10);
     }
     void bling(float elapsed_ms, float progress) {
         _sprite.draw(20, 10);
@@ -50,8 +51,8 @@ class title {
         _sprite.animate(elapsed_ms);
     }
     void slide_out(float progress) {
-        _sprite.draw(cage_interpolate(20, 200, progress, cage_circular_ease_in),
-                     10);
+        _sprite.draw(
+            cage::interpolate<cage::ease::circular_in>(20, 200, progress), 10);
     }
 };
 
@@ -62,6 +63,7 @@ class wizard {
     cage::animation _walk_right, _walk_left, _stand, _cast;
     point _pos{0, 57};
     float _speed{0};
+    cage::draw_params _params = cage_default_draw_params();
 
   public:
     wizard() {
@@ -80,12 +82,14 @@ class wizard {
             .add_frame(3, 200, &NORMAL_SPEED_R)
             .add_frame(4, 200, &BRAKE_SPEED_R)
             .loop(1, 4);
-        _walk_left.add_frame(15, 200, &PREP_SPEED_L)
-            .add_frame(11, 200, &NORMAL_SPEED_L)
-            .add_frame(10, 200, &NORMAL_SPEED_L)
-            .add_frame(9, 200, &NORMAL_SPEED_L)
-            .add_frame(8, 200, &NORMAL_SPEED_L)
-            .add_frame(15, 200, &BRAKE_SPEED_L)
+        /* Walking left reuses the right-facing frames, mirrored when
+         * drawn. */
+        _walk_left.add_frame(4, 200, &PREP_SPEED_L)
+            .add_frame(0, 200, &NORMAL_SPEED_L)
+            .add_frame(1, 200, &NORMAL_SPEED_L)
+            .add_frame(2, 200, &NORMAL_SPEED_L)
+            .add_frame(3, 200, &NORMAL_SPEED_L)
+            .add_frame(4, 200, &BRAKE_SPEED_L)
             .loop(1, 4);
         _stand.add_frame(5, 100, &NO_SPEED).mode(CAGE_FREEZE_LAST_FRAME);
         _cast.add_frame(5, 200, &NO_SPEED)
@@ -96,9 +100,15 @@ class wizard {
         _sprite.play(_stand);
     }
 
-    void walk_left() { _sprite.play(_walk_left); }
+    void walk_left() {
+        _sprite.play(_walk_left);
+        _params.flip = CAGE_FLIP_HORIZONTAL;
+    }
 
-    void walk_right() { _sprite.play(_walk_right); }
+    void walk_right() {
+        _sprite.play(_walk_right);
+        _params.flip = CAGE_FLIP_NONE;
+    }
 
     void stand() { _sprite.play(_stand); }
 
@@ -124,7 +134,7 @@ class wizard {
             _speed = *((const float*)px);
         }
         _pos.x += _speed;
-        _sprite.draw(_pos.x, _pos.y);
+        _sprite.draw(_pos.x, _pos.y, _params);
     }
 };
 static const char* LEVEL =
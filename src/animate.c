@@ -21,11 +21,13 @@
  */
 #include "animate.h"
 #include <stdlib.h>
+#include "internals.h"
 #include "begin_prefix.h"
 
 struct animation* create_animation(void)
 {
-    struct animation* ret = (struct animation*)calloc(1, sizeof(struct animation));
+    struct animation* ret = (struct animation*)CALLOC(
+    1, sizeof(struct animation), MEMORY_ANIMATIONS);
     if (ret != NULL) {
         ret->mode = LOOP_FRAMES;
         ret->loop_from = -1;
@@ -66,9 +68,37 @@ void add_frames(struct animation* animation, int nframes, struct frame frames[])
     }
 }
 
+int next_animation_frame(const struct animation* animation,
+                         int current,
+                         int* step,
+                         bool finish)
+{
+    switch (animation->mode) {
+        case LOOP_FRAMES:
+            if (finish) {
+                return current <= animation->loop_to ? animation->loop_to + 1
+                                                     : current + 1;
+            }
+            return current == animation->loop_to ? animation->loop_from
+                                                 : current + 1;
+        case FREEZE_LAST_FRAME:
+            if (finish) return current + 1;
+            return current + 1 == animation->n_frames ? current : current + 1;
+        case PINGPONG_FRAMES:
+            if (finish) return *step > 0 ? current + 1 : animation->n_frames;
+            if (animation->n_frames < 2) return current;
+            if (current + *step < 0 || current + *step >= animation->n_frames) {
+                *step = -*step;
+            }
+            return current + *step;
+        default:
+            return current;
+    }
+}
+
 void destroy_animation(struct animation* animation)
 {
-    free(animation);
+    FREE(animation);
 }
 
 #include "end_prefix.h"
@@ -21,6 +21,7 @@
  */
 #ifndef ANIMATE_H_QVL0GFIR
 #define ANIMATE_H_QVL0GFIR
+#include "types.h"
 #include "begin_prefix.h"
 
 #define MAX_FRAMES_PER_ANIMATION 256
@@ -114,5 +115,23 @@ void add_frames(struct animation* animation,
                 int nframes,
                 struct frame frames[]);
 
+/**
+ * Get the index of the frame to play after the current one.
+ * @param animation Animation being played
+ * @param current Index of the frame currently played
+ * @param step Playback direction, 1 or -1. PINGPONG_FRAMES animations
+ *        flip it when they reach either end.
+ * @param finish Set to true when another animation is waiting to be
+ *        played. The animation will then play through to its last frame
+ *        instead of looping.
+ *
+ * @return the next frame index, or n_frames once a finishing
+ * animation is through
+ */
+int next_animation_frame(const struct animation* animation,
+                         int current,
+                         int* step,
+                         bool finish);
+
 #include "end_prefix.h"
 #endif /* end of include guard: ANIMATE_H_QVL0GFIR */
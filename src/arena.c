@@ -0,0 +1,158 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "arena.h"
+#include "internals.h"
+#include "utils.h"
+#include <stdlib.h>
+#include "begin_prefix.h"
+
+#define ARENA_ALIGN 16
+#define ALIGN_UP(n) (((n) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+/* arenas grow in steps of this many bytes */
+#define ARENA_GRAIN 4096
+
+static struct arena* frame_arena = NULL;
+static struct arena* two_frame_arenas[2] = { NULL, NULL };
+static int two_frame_index = 0;
+static struct arena* scratch_arena = NULL;
+
+struct arena* create_arena(size_t size)
+{
+    struct arena* arena = (struct arena*)CALLOC(
+    1, sizeof(struct arena), MEMORY_ARENAS);
+    if (arena == NULL) goto error;
+    arena->memory = (char*)MALLOC(size, MEMORY_ARENAS);
+    if (arena->memory == NULL) goto free_arena;
+    arena->size = size;
+    return arena;
+
+free_arena:
+    FREE(arena);
+error:
+    ERROR("Unable to allocate arena");
+    return NULL;
+}
+
+void destroy_arena(struct arena* arena)
+{
+    FREE(arena->memory);
+    FREE(arena);
+}
+
+void* arena_alloc(struct arena* arena, size_t size)
+{
+    size_t start = ALIGN_UP(arena->used);
+    if (start + size > arena->high_water) arena->high_water = start + size;
+    if (start + size > arena->size) {
+        arena->failed++;
+        return NULL;
+    }
+    arena->used = start + size;
+    return arena->memory + start;
+}
+
+void reset_arena(struct arena* arena)
+{
+    size_t size;
+    char* memory;
+
+    arena->used = 0;
+    if (arena->high_water <= arena->size) return;
+    /* nothing points into the arena, so there is nothing to copy */
+    size = (arena->high_water + ARENA_GRAIN - 1) & ~(size_t)(ARENA_GRAIN - 1);
+    memory = (char*)MALLOC(size, MEMORY_ARENAS);
+    if (memory == NULL) return;
+    FREE(arena->memory);
+    arena->memory = memory;
+    arena->size = size;
+}
+
+size_t mark_arena(struct arena* arena)
+{
+    return arena->used;
+}
+
+void release_arena(struct arena* arena, size_t mark)
+{
+    if (mark < arena->used) arena->used = mark;
+}
+
+void* frame_alloc(size_t size)
+{
+    return arena_alloc(frame_arena, size);
+}
+
+void* two_frame_alloc(size_t size)
+{
+    return arena_alloc(two_frame_arenas[two_frame_index], size);
+}
+
+struct arena* get_frame_arena(void)
+{
+    return frame_arena;
+}
+
+struct arena* get_two_frame_arena(void)
+{
+    return two_frame_arenas[two_frame_index];
+}
+
+struct arena* get_scratch_arena(void)
+{
+    return scratch_arena;
+}
+
+int prepare_arenas(size_t size)
+{
+    if (size == 0) size = DEFAULT_ARENA_SIZE;
+    frame_arena = create_arena(size);
+    two_frame_arenas[0] = create_arena(size);
+    two_frame_arenas[1] = create_arena(size);
+    scratch_arena = create_arena(size);
+    if (frame_arena == NULL || two_frame_arenas[0] == NULL ||
+        two_frame_arenas[1] == NULL || scratch_arena == NULL) {
+        teardown_arenas();
+        return -1;
+    }
+    return 0;
+}
+
+void teardown_arenas(void)
+{
+    if (frame_arena != NULL) destroy_arena(frame_arena);
+    if (two_frame_arenas[0] != NULL) destroy_arena(two_frame_arenas[0]);
+    if (two_frame_arenas[1] != NULL) destroy_arena(two_frame_arenas[1]);
+    if (scratch_arena != NULL) destroy_arena(scratch_arena);
+    frame_arena = NULL;
+    two_frame_arenas[0] = NULL;
+    two_frame_arenas[1] = NULL;
+    scratch_arena = NULL;
+}
+
+void next_frame_arenas(void)
+{
+    reset_arena(frame_arena);
+    two_frame_index = 1 - two_frame_index;
+    reset_arena(two_frame_arenas[two_frame_index]);
+    /* every scratch user released its memory, unless it forgot to */
+    reset_arena(scratch_arena);
+}
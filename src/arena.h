@@ -0,0 +1,158 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#ifndef ARENA_H_C7TQ2MVB
+#define ARENA_H_C7TQ2MVB
+
+#include <stddef.h>
+
+#include "begin_prefix.h"
+/** Size of the engine arenas when \ref settings leaves it at 0 */
+#define DEFAULT_ARENA_SIZE (1024 * 1024)
+
+/**
+ * Arenas hand out memory by moving a pointer forward, and take it all
+ * back at once. They suit data that lives for a known span, like one
+ * frame, where malloc() and free() would cost more than the work.
+ *
+ * Cage owns three arenas. frame_alloc() memory is valid until the
+ * frame is presented:
+ *
+ *     vec* targets = frame_alloc(n_enemies * sizeof(vec));
+ *
+ * two_frame_alloc() memory is valid until the next frame is presented,
+ * so a frame can read what the previous one left:
+ *
+ *     state->last_hits = two_frame_alloc(n_hits * sizeof(struct hit));
+ *
+ * The scratch arena is a stack for temporary buffers inside a function:
+ *
+ *     struct arena* scratch = get_scratch_arena();
+ *     size_t mark = mark_arena(scratch);
+ *     char* line = arena_alloc(scratch, 256);
+ *     ...
+ *     release_arena(scratch, mark);
+ *
+ * When an allocation does not fit, arena_alloc() returns NULL and the
+ * arena grows to its high-water mark the next time it is reset, so
+ * only the first frame that needs more memory goes without.
+ * Arenas are not thread safe, and the Cage arenas are meant for the
+ * main thread.
+ */
+struct arena {
+    /* arena memory */
+    char* memory;
+    /** arena size in bytes */
+    size_t size;
+    /** bytes in use */
+    size_t used;
+    /** most bytes ever requested at once, including failed requests */
+    size_t high_water;
+    /** number of failed allocations */
+    int failed;
+};
+
+/**
+ * Create an arena
+ * @param size arena size in bytes
+ *
+ * @return a new arena or NULL on error
+ */
+struct arena* create_arena(size_t size);
+
+/**
+ * Destroy an arena created using create_arena()
+ * @param arena arena to destroy
+ */
+void destroy_arena(struct arena* arena);
+
+/**
+ * Allocate memory from an arena, aligned to 16 bytes
+ * @param arena arena to allocate from
+ * @param size number of bytes
+ *
+ * @return pointer to the memory or NULL when the arena is full
+ */
+void* arena_alloc(struct arena* arena, size_t size);
+
+/**
+ * Free all the arena allocations at once. When the high-water mark is
+ * above the arena size, the arena grows to fit it.
+ * @param arena arena to reset
+ */
+void reset_arena(struct arena* arena);
+
+/**
+ * Get the current arena position
+ * @param arena arena to mark
+ *
+ * @return a mark for release_arena()
+ */
+size_t mark_arena(struct arena* arena);
+
+/**
+ * Free the arena allocations made since a mark
+ * @param arena arena to release
+ * @param mark mark returned by mark_arena()
+ */
+void release_arena(struct arena* arena, size_t mark);
+
+/**
+ * Allocate memory valid until the current frame is presented
+ * @param size number of bytes
+ *
+ * @return pointer to the memory or NULL when the frame arena is full
+ */
+void* frame_alloc(size_t size);
+
+/**
+ * Allocate memory valid until the next frame is presented
+ * @param size number of bytes
+ *
+ * @return pointer to the memory or NULL when the arena is full
+ */
+void* two_frame_alloc(size_t size);
+
+/**
+ * Get the arena frame_alloc() uses, e.g. to check its high-water mark
+ *
+ * @return the frame arena
+ */
+struct arena* get_frame_arena(void);
+
+/**
+ * Get the arena two_frame_alloc() currently uses. The two arenas of
+ * two_frame_alloc() swap every frame.
+ *
+ * @return the current two frame arena
+ */
+struct arena* get_two_frame_arena(void);
+
+/**
+ * Get the scratch arena. Code using it releases its allocations using
+ * mark_arena() and release_arena() before returning.
+ *
+ * @return the scratch arena
+ */
+struct arena* get_scratch_arena(void);
+
+#include "end_prefix.h"
+#endif /* end of include guard: ARENA_H_C7TQ2MVB */
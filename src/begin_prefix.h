@@ -1,21 +1,40 @@
 #ifdef CAGE_PREFIX
+#define add_component cage_add_component
 #define add_frame cage_add_frame
 #define add_frames cage_add_frames
+#define add_job_dependency cage_add_job_dependency
+#define add_light cage_add_light
+#define add_render_pass cage_add_render_pass
+#define add_tile_animation cage_add_tile_animation
+#define add_to_sprite_batch cage_add_to_sprite_batch
 #define add_vec cage_add_vec
 #define animate_sprite cage_animate_sprite
+#define animate_sprites cage_animate_sprites
+#define animated_tile cage_animated_tile
 #define animation cage_animation
 #define animation_mode cage_animation_mode
 #define append_event cage_append_event
 #define append_events cage_append_events
+#define apply_snapshot_delta cage_apply_snapshot_delta
+#define archetype cage_archetype
+#define arena cage_arena
+#define arena_alloc cage_arena_alloc
 #define back_ease_in cage_back_ease_in
 #define back_ease_in_out cage_back_ease_in_out
 #define back_ease_out cage_back_ease_out
 #define bbox_in_bbox cage_bbox_in_bbox
 #define bbox_intersect cage_bbox_intersect
+#define begin_frame cage_begin_frame
+#define begin_snapshot cage_begin_snapshot
 #define blend_mode cage_blend_mode
+#define block_map_tiles cage_block_map_tiles
 #define bounce_ease_in cage_bounce_ease_in
 #define bounce_ease_in_out cage_bounce_ease_in_out
 #define bounce_ease_out cage_bounce_ease_out
+#define build_flow_field cage_build_flow_field
+#define build_pack cage_build_pack
+#define build_pack_ex cage_build_pack_ex
+#define builtin_component cage_builtin_component
 #define circular_ease_in cage_circular_ease_in
 #define circular_ease_in_out cage_circular_ease_in_out
 #define circular_ease_out cage_circular_ease_out
@@ -25,131 +44,387 @@
 #define cleanup_sprite cage_cleanup_sprite
 #define cleanup_timeline cage_cleanup_timeline
 #define clear_image cage_clear_image
+#define clear_particles cage_clear_particles
 #define color cage_color
 #define color_from_RGB cage_color_from_RGB
 #define color_from_RGBA cage_color_from_RGBA
+#define continue_path_search cage_continue_path_search
 #define coords cage_coords
+#define count_query_entities cage_count_query_entities
 #define create_animation cage_create_animation
+#define create_arena cage_create_arena
 #define create_blank_image cage_create_blank_image
+#define create_draw_queue cage_create_draw_queue
+#define create_entity cage_create_entity
+#define create_flow_field cage_create_flow_field
 #define create_font cage_create_font
 #define create_image cage_create_image
+#define create_job cage_create_job
+#define create_lightmap cage_create_lightmap
+#define create_managed_image cage_create_managed_image
+#define create_particle_emitter cage_create_particle_emitter
+#define create_path_finder cage_create_path_finder
+#define create_query cage_create_query
+#define create_render_passes cage_create_render_passes
+#define create_sheet_sprite cage_create_sheet_sprite
+#define create_snapshot cage_create_snapshot
 #define create_sound cage_create_sound
 #define create_sprite cage_create_sprite
+#define create_sprite_batch cage_create_sprite_batch
+#define create_sprite_sheet cage_create_sprite_sheet
 #define create_target_image cage_create_target_image
+#define create_tile_animator cage_create_tile_animator
+#define create_tile_layer cage_create_tile_layer
+#define create_tilemap cage_create_tilemap
 #define create_timeline cage_create_timeline
+#define create_world cage_create_world
 #define cubic_ease_in cage_cubic_ease_in
 #define cubic_ease_in_out cage_cubic_ease_in_out
 #define cubic_ease_out cage_cubic_ease_out
+#define cull_quad cage_cull_quad
+#define default_draw_params cage_default_draw_params
 #define destroy_animation cage_destroy_animation
+#define destroy_arena cage_destroy_arena
+#define destroy_draw_queue cage_destroy_draw_queue
+#define destroy_entity cage_destroy_entity
+#define destroy_flow_field cage_destroy_flow_field
 #define destroy_font cage_destroy_font
 #define destroy_image cage_destroy_image
+#define destroy_lightmap cage_destroy_lightmap
+#define destroy_particle_emitter cage_destroy_particle_emitter
+#define destroy_path_finder cage_destroy_path_finder
+#define destroy_query cage_destroy_query
+#define destroy_render_passes cage_destroy_render_passes
+#define destroy_snapshot cage_destroy_snapshot
 #define destroy_sound cage_destroy_sound
 #define destroy_sprite cage_destroy_sprite
+#define destroy_sprite_batch cage_destroy_sprite_batch
+#define destroy_sprite_sheet cage_destroy_sprite_sheet
+#define destroy_tile_animator cage_destroy_tile_animator
+#define destroy_tile_layer cage_destroy_tile_layer
+#define destroy_tilemap cage_destroy_tilemap
 #define destroy_timeline cage_destroy_timeline
+#define destroy_world cage_destroy_world
+#define dispatch_file_writes cage_dispatch_file_writes
 #define div_vec cage_div_vec
+#define draw_batch_sprite cage_draw_batch_sprite
+#define draw_batch_sprite_ex cage_draw_batch_sprite_ex
+#define draw_command cage_draw_command
+#define draw_entity_sprites cage_draw_entity_sprites
 #define draw_image cage_draw_image
+#define draw_image_ex cage_draw_image_ex
+#define draw_lightmap cage_draw_lightmap
 #define draw_on_image cage_draw_on_image
 #define draw_on_screen cage_draw_on_screen
+#define draw_params cage_draw_params
+#define draw_particles cage_draw_particles
+#define draw_queue cage_draw_queue
+#define draw_sheet_frame cage_draw_sheet_frame
+#define draw_sheet_frame_ex cage_draw_sheet_frame_ex
 #define draw_sprite cage_draw_sprite
+#define draw_sprite_ex cage_draw_sprite_ex
 #define draw_sprite_frame cage_draw_sprite_frame
+#define draw_sprite_frame_ex cage_draw_sprite_frame_ex
 #define draw_text cage_draw_text
+#define draw_tile_layer cage_draw_tile_layer
+#define dump_memory_snapshot cage_dump_memory_snapshot
 #define elastic_ease_in cage_elastic_ease_in
 #define elastic_ease_in_out cage_elastic_ease_in_out
 #define elastic_ease_out cage_elastic_ease_out
+#define emit_particles cage_emit_particles
+#define end_snapshot cage_end_snapshot
+#define entity_chunk cage_entity_chunk
+#define entity_query cage_entity_query
+#define entity_record cage_entity_record
 #define error_msg cage_error_msg
 #define exit_with_error_msg cage_exit_with_error_msg
 #define exponential_ease_in cage_exponential_ease_in
 #define exponential_ease_in_out cage_exponential_ease_in_out
 #define exponential_ease_out cage_exponential_ease_out
 #define file_spec cage_file_spec
+#define file_view cage_file_view
+#define find_path cage_find_path
+#define find_sheet_frame cage_find_sheet_frame
+#define finish_file_writes cage_finish_file_writes
+#define finish_jobs cage_finish_jobs
+#define flip_mode cage_flip_mode
+#define flow_field cage_flow_field
+#define flush_draw_queue cage_flush_draw_queue
 #define font cage_font
 #define frame cage_frame
+#define frame_alloc cage_frame_alloc
 #define game_loop cage_game_loop
 #define game_setup_and_loop cage_game_setup_and_loop
 #define game_state cage_game_state
+#define get_animated_tile cage_get_animated_tile
+#define get_batch_frame cage_get_batch_frame
+#define get_chunk_components cage_get_chunk_components
+#define get_component cage_get_component
 #define get_error_msgs cage_get_error_msgs
+#define get_flow_direction cage_get_flow_direction
+#define get_frame_arena cage_get_frame_arena
 #define get_image_alpha cage_get_image_alpha
+#define get_map_tile cage_get_map_tile
+#define get_memory_stats cage_get_memory_stats
+#define get_memory_tag_name cage_get_memory_tag_name
+#define get_pack_stats cage_get_pack_stats
+#define get_path cage_get_path
+#define get_render_scale cage_get_render_scale
+#define get_render_stats cage_get_render_stats
+#define get_render_target_size cage_get_render_target_size
+#define get_scratch_arena cage_get_scratch_arena
 #define get_screen_size cage_get_screen_size
+#define get_texture_stats cage_get_texture_stats
+#define get_tile cage_get_tile
+#define get_total_memory_stats cage_get_total_memory_stats
+#define get_two_frame_arena cage_get_two_frame_arena
 #define get_window_size cage_get_window_size
+#define get_worker_count cage_get_worker_count
+#define hash_map_source cage_hash_map_source
 #define hdg_vec cage_hdg_vec
+#define hold_until_flushed cage_hold_until_flushed
 #define image cage_image
 #define init_image_from_file cage_init_image_from_file
 #define init_timeline cage_init_timeline
 #define interpolate cage_interpolate
+#define invalidate_tile_layer cage_invalidate_tile_layer
+#define is_entity_alive cage_is_entity_alive
 #define is_file_exists cage_is_file_exists
+#define is_job_done cage_is_job_done
+#define is_map_walkable cage_is_map_walkable
+#define is_memory_tracked cage_is_memory_tracked
 #define is_playing cage_is_playing
+#define is_replaying_input cage_is_replaying_input
+#define job cage_job
 #define key_down cage_key_down
 #define key_pressed cage_key_pressed
 #define keyboard cage_keyboard
+#define light cage_light
+#define lightmap cage_lightmap
 #define linear_interpolation cage_linear_interpolation
 #define load_font cage_load_font
+#define load_snapshot cage_load_snapshot
 #define load_sound cage_load_sound
+#define load_tilemap cage_load_tilemap
 #define lock_image cage_lock_image
+#define make_snapshot_delta cage_make_snapshot_delta
+#define map_file cage_map_file
+#define map_file_memory cage_map_file_memory
+#define mark_arena cage_mark_arena
 #define measure_text cage_measure_text
+#define memory_stats cage_memory_stats
+#define memory_tag cage_memory_tag
 #define message_box cage_message_box
+#define mount_pack cage_mount_pack
 #define mouse cage_mouse
+#define mouse_state cage_mouse_state
 #define mul_vec cage_mul_vec
+#define next_animation_frame cage_next_animation_frame
+#define next_frame_arenas cage_next_frame_arenas
+#define next_texture_frame cage_next_texture_frame
 #define norm_vec cage_norm_vec
+#define open_asset cage_open_asset
+#define pack_stats cage_pack_stats
+#define parallel_for cage_parallel_for
+#define particle_emitter cage_particle_emitter
+#define path_finder cage_path_finder
+#define path_flags cage_path_flags
+#define path_node cage_path_node
+#define path_status cage_path_status
+#define path_step cage_path_step
 #define pause_timeline cage_pause_timeline
 #define pixels_collide cage_pixels_collide
 #define play_animation cage_play_animation
+#define play_batch_animation cage_play_batch_animation
 #define play_sound cage_play_sound
 #define point_in_bbox cage_point_in_bbox
+#define preload_assets cage_preload_assets
+#define prepare_arenas cage_prepare_arenas
+#define prepare_dynamic_resolution cage_prepare_dynamic_resolution
+#define prepare_replay cage_prepare_replay
+#define prepare_sheet_sprite cage_prepare_sheet_sprite
 #define prepare_sprite cage_prepare_sprite
+#define present_frame cage_present_frame
+#define purge_render_targets cage_purge_render_targets
 #define quadratic_ease_in cage_quadratic_ease_in
 #define quadratic_ease_in_out cage_quadratic_ease_in_out
 #define quadratic_ease_out cage_quadratic_ease_out
 #define quartic_ease_in cage_quartic_ease_in
 #define quartic_ease_in_out cage_quartic_ease_in_out
 #define quartic_ease_out cage_quartic_ease_out
+#define queue_draw_image cage_queue_draw_image
+#define queue_draws cage_queue_draws
+#define queue_render_image_ex cage_queue_render_image_ex
 #define quintic_ease_in cage_quintic_ease_in
 #define quintic_ease_in_out cage_quintic_ease_in_out
 #define quintic_ease_out cage_quintic_ease_out
+#define read_bytes cage_read_bytes
+#define read_double cage_read_double
 #define read_file cage_read_file
+#define read_float cage_read_float
+#define read_i32 cage_read_i32
+#define read_string cage_read_string
+#define read_text_asset cage_read_text_asset
+#define read_u16 cage_read_u16
+#define read_u32 cage_read_u32
+#define read_u64 cage_read_u64
+#define read_u8 cage_read_u8
+#define read_varint cage_read_varint
 #define rect_from_sub_bbox cage_rect_from_sub_bbox
 #define rectangle cage_rectangle
+#define register_component cage_register_component
 #define relax_screen cage_relax_screen
+#define release_arena cage_release_arena
+#define release_preloaded_assets cage_release_preloaded_assets
+#define release_render_target cage_release_render_target
+#define remove_component cage_remove_component
+#define remove_from_sprite_batch cage_remove_from_sprite_batch
+#define render_image_ex cage_render_image_ex
+#define render_pass cage_render_pass
+#define render_passes cage_render_passes
+#define render_stats cage_render_stats
+#define replay_frame cage_replay_frame
+#define reset_arena cage_reset_arena
+#define reset_render_state cage_reset_render_state
+#define reset_render_stats cage_reset_render_stats
 #define reset_timeline cage_reset_timeline
+#define rewind_snapshot cage_rewind_snapshot
+#define run_render_passes cage_run_render_passes
+#define run_system cage_run_system
+#define run_system_parallel cage_run_system_parallel
+#define sample_mouse cage_sample_mouse
+#define save_snapshot cage_save_snapshot
+#define save_tilemap cage_save_tilemap
 #define screen cage_screen
 #define screen_color cage_screen_color
 #define set_blend_mode cage_set_blend_mode
 #define set_image_alpha cage_set_image_alpha
+#define set_map_tile cage_set_map_tile
+#define set_render_draw_color cage_set_render_draw_color
+#define set_render_target cage_set_render_target
 #define set_screen_blend_mode cage_set_screen_blend_mode
 #define set_screen_size cage_set_screen_size
+#define set_snapshot_data cage_set_snapshot_data
+#define set_texture_alpha_mod cage_set_texture_alpha_mod
+#define set_texture_blend_mode cage_set_texture_blend_mode
+#define set_texture_budget cage_set_texture_budget
+#define set_texture_color_mod cage_set_texture_color_mod
+#define set_tile cage_set_tile
+#define set_tile_blocked cage_set_tile_blocked
 #define set_volume cage_set_volume
 #define set_window_size cage_set_window_size
 #define settings cage_settings
 #define shake_screen cage_shake_screen
+#define sheet_frame cage_sheet_frame
 #define sine_ease_in cage_sine_ease_in
 #define sine_ease_in_out cage_sine_ease_in_out
 #define sine_ease_out cage_sine_ease_out
+#define snapshot cage_snapshot
 #define sound cage_sound
 #define sprite cage_sprite
+#define sprite_batch cage_sprite_batch
+#define sprite_event cage_sprite_event
+#define sprite_sheet cage_sprite_sheet
+#define start_job cage_start_job
+#define start_path_search cage_start_path_search
+#define start_workers cage_start_workers
 #define stop_animation cage_stop_animation
+#define stop_batch_animation cage_stop_batch_animation
+#define stop_file_writer cage_stop_file_writer
 #define stop_sound cage_stop_sound
+#define stop_workers cage_stop_workers
 #define sub_vec cage_sub_vec
 #define swap_vecs cage_swap_vecs
+#define teardown_arenas cage_teardown_arenas
+#define teardown_dynamic_resolution cage_teardown_dynamic_resolution
+#define teardown_replay cage_teardown_replay
+#define texture_stats cage_texture_stats
+#define tile_animator cage_tile_animator
+#define tile_chunk cage_tile_chunk
+#define tile_frame cage_tile_frame
+#define tile_layer cage_tile_layer
+#define tilemap cage_tilemap
 #define timeline cage_timeline
 #define timeline_event cage_timeline_event
 #define toolbox cage_toolbox
+#define track_asset cage_track_asset
+#define tracked_calloc cage_tracked_calloc
+#define tracked_free cage_tracked_free
+#define tracked_malloc cage_tracked_malloc
+#define tracked_realloc cage_tracked_realloc
 #define translate_bbox cage_translate_bbox
+#define two_frame_alloc cage_two_frame_alloc
 #define unit_vec cage_unit_vec
 #define unlock_image cage_unlock_image
+#define unmap_file cage_unmap_file
+#define unmap_file_memory cage_unmap_file_memory
+#define unmount_packs cage_unmount_packs
+#define untrack_asset cage_untrack_asset
+#define update_entity_bboxes cage_update_entity_bboxes
 #define update_mouse cage_update_mouse
+#define update_particles cage_update_particles
+#define update_tile_animator cage_update_tile_animator
 #define update_timeline cage_update_timeline
+#define use_image cage_use_image
 #define vec_dist cage_vec_dist
 #define vec_dist_mntn cage_vec_dist_mntn
 #define vec_dist_sqrd cage_vec_dist_sqrd
 #define vec_len cage_vec_len
 #define vec_len_sqrd cage_vec_len_sqrd
+#define wait_job cage_wait_job
+#define world cage_world
+#define write_bytes cage_write_bytes
+#define write_double cage_write_double
 #define write_file cage_write_file
+#define write_file_async cage_write_file_async
+#define write_file_data cage_write_file_data
+#define write_file_data_async cage_write_file_data_async
+#define write_float cage_write_float
+#define write_i32 cage_write_i32
+#define write_string cage_write_string
+#define write_u16 cage_write_u16
+#define write_u32 cage_write_u32
+#define write_u64 cage_write_u64
+#define write_u8 cage_write_u8
+#define write_varint cage_write_varint
 #define xy_vec cage_xy_vec
 #define zero_vec cage_zero_vec
 #define ADD CAGE_ADD
+#define BBOX_COMPONENT CAGE_BBOX_COMPONENT
 #define BLEND CAGE_BLEND
+#define FLIP_HORIZONTAL CAGE_FLIP_HORIZONTAL
+#define FLIP_NONE CAGE_FLIP_NONE
+#define FLIP_VERTICAL CAGE_FLIP_VERTICAL
 #define FREEZE_LAST_FRAME CAGE_FREEZE_LAST_FRAME
 #define LOOP_FRAMES CAGE_LOOP_FRAMES
+#define MEMORY_ANIMATIONS CAGE_MEMORY_ANIMATIONS
+#define MEMORY_ARENAS CAGE_MEMORY_ARENAS
+#define MEMORY_AUDIO CAGE_MEMORY_AUDIO
+#define MEMORY_ENGINE CAGE_MEMORY_ENGINE
+#define MEMORY_ENTITIES CAGE_MEMORY_ENTITIES
+#define MEMORY_FONTS CAGE_MEMORY_FONTS
+#define MEMORY_IMAGES CAGE_MEMORY_IMAGES
+#define MEMORY_JOBS CAGE_MEMORY_JOBS
+#define MEMORY_PACKS CAGE_MEMORY_PACKS
+#define MEMORY_PARTICLES CAGE_MEMORY_PARTICLES
+#define MEMORY_PATHS CAGE_MEMORY_PATHS
+#define MEMORY_RENDER CAGE_MEMORY_RENDER
+#define MEMORY_SNAPSHOTS CAGE_MEMORY_SNAPSHOTS
+#define MEMORY_SOUNDS CAGE_MEMORY_SOUNDS
+#define MEMORY_SPRITES CAGE_MEMORY_SPRITES
+#define MEMORY_TEXTURES CAGE_MEMORY_TEXTURES
+#define MEMORY_TILES CAGE_MEMORY_TILES
+#define MEMORY_TIMELINES CAGE_MEMORY_TIMELINES
 #define MULTIPLY CAGE_MULTIPLY
 #define NONE CAGE_NONE
+#define NUM_OF_MEMORY_TAGS CAGE_NUM_OF_MEMORY_TAGS
+#define PATH_DIAGONAL CAGE_PATH_DIAGONAL
+#define PATH_FOUND CAGE_PATH_FOUND
+#define PATH_JUMP CAGE_PATH_JUMP
+#define PATH_NOT_FOUND CAGE_PATH_NOT_FOUND
+#define PATH_SEARCHING CAGE_PATH_SEARCHING
+#define PATH_STRAIGHT CAGE_PATH_STRAIGHT
 #define PINGPONG_FRAMES CAGE_PINGPONG_FRAMES
+#define POSITION_COMPONENT CAGE_POSITION_COMPONENT
+#define SPRITE_COMPONENT CAGE_SPRITE_COMPONENT
 #endif
@@ -27,6 +27,7 @@
 
 #include "internals.h"
 #include "image.h"
+#include "pack.h"
 #include "sound.h"
 #include "types.h"
 
@@ -49,19 +50,33 @@ struct gamestate {
 static struct gamestate current_state = { NULL, NULL, NULL };
 static struct gamestate next_state = { NULL, NULL, NULL };
 
+/* input recording paths read from the conf file */
+#define MAX_CONF_PATH 256
+static char conf_record_input[MAX_CONF_PATH];
+static char conf_replay_input[MAX_CONF_PATH];
+
+static const char* conf_path(char* path, const char* token)
+{
+    if (strlen(token) >= MAX_CONF_PATH) return NULL;
+    strcpy(path, token);
+    return path;
+}
+
 static int read_conf_file(struct settings* settings)
 {
-    FILE* fp;
     char *token1, *token2, *str;
+    char *conf, *line, *next;
+    size_t length;
 
-    char bufr[1024];
     char empty[1];
     empty[0] = 0;
-    if ((fp = fopen("res/game.conf", "r")) == NULL) return -1;
-    while (fgets(bufr, 1024, fp) != NULL) {
-        if (bufr[0] == '#' || bufr[0] == '\n') continue;
+    conf = read_text_asset("res/game.conf", &length, MEMORY_ENGINE);
+    if (conf == NULL) return -1;
+    for (line = conf; line != NULL; line = next) {
+        if ((next = strchr(line, '\n')) != NULL) *next++ = '\0';
+        if (line[0] == '#' || line[0] == '\0') continue;
         token2 = empty;
-        for (str = bufr; (token1 = strtok(str, " \n\t")) != 0; str = NULL) {
+        for (str = line; (token1 = strtok(str, " \n\t")) != 0; str = NULL) {
             if (strcmp(token2, "window_width") == 0) {
                 settings->window_width = atoi(token1);
             }
@@ -74,11 +89,32 @@ static int read_conf_file(struct settings* settings)
             if (strcmp(token2, "logical_height") == 0) {
                 settings->logical_height = atoi(token1);
             }
+            if (strcmp(token2, "frame_budget_ms") == 0) {
+                settings->frame_budget_ms = (float)atof(token1);
+            }
+            if (strcmp(token2, "min_render_scale") == 0) {
+                settings->min_render_scale = (float)atof(token1);
+            }
+            if (strcmp(token2, "worker_threads") == 0) {
+                settings->worker_threads = atoi(token1);
+            }
+            if (strcmp(token2, "arena_size_kb") == 0) {
+                settings->arena_size_kb = atoi(token1);
+            }
+            if (strcmp(token2, "texture_budget_kb") == 0) {
+                settings->texture_budget_kb = atoi(token1);
+            }
+            if (strcmp(token2, "record_input") == 0) {
+                settings->record_input = conf_path(conf_record_input, token1);
+            }
+            if (strcmp(token2, "replay_input") == 0) {
+                settings->replay_input = conf_path(conf_replay_input, token1);
+            }
             token2 = token1;
             if (str == NULL) break;
         }
     }
-    fclose(fp);
+    FREE(conf);
     return 0;
 }
 
@@ -89,6 +125,14 @@ static void prepare_sdl(void)
     Mix_Init(MIX_INIT_OGG);
 }
 
+static void prepare_packs(void)
+{
+    SDL_RWops* rw = SDL_RWFromFile(DEFAULT_PACK, "rb");
+    if (rw == NULL) return;
+    SDL_RWclose(rw);
+    if (mount_pack(DEFAULT_PACK) == -1) exit_with_error_msg(get_error_msgs());
+}
+
 static void teardown_sdl(void)
 {
     Mix_Quit();
@@ -136,10 +180,22 @@ static void prepare_screen(const struct settings* settings)
     screen->window = window;
     screen->offset_x = 0;
     screen->offset_y = 0;
+    screen->width = settings->logical_width;
+    screen->height = settings->logical_height;
+    screen->background = color_from_RGB(0, 0, 0);
+    screen->queue = NULL;
+    screen->scene = NULL;
+    reset_render_stats();
+    reset_render_state();
+    if (settings->frame_budget_ms > 0 &&
+        prepare_dynamic_resolution(settings->frame_budget_ms,
+                                   settings->min_render_scale) == -1)
+        exit_with_error_msg(get_error_msgs());
 }
 
 static void teardown_screen(void)
 {
+    teardown_dynamic_resolution();
     SDL_DestroyRenderer(screen->impl);
     SDL_DestroyWindow(screen->window);
 }
@@ -168,10 +224,17 @@ void error_msg(const char* msg)
 
 static void cleanup(void)
 {
+    stop_workers();
+    finish_file_writes();
+    teardown_replay();
     toolbox->state->destroy(toolbox->data);
+    teardown_arenas();
     teardown_audio_device();
+    purge_render_targets();
     teardown_screen();
-    free(toolbox);
+    FREE(toolbox);
+    stop_file_writer();
+    unmount_packs();
     teardown_sdl();
 }
 
@@ -207,12 +270,23 @@ int game_setup_and_loop(setup_func_t setup,
     bool quit = false;
     Uint32 start;
     Uint32 now;
+    Uint64 frame_start;
     prepare_sdl();
+    prepare_packs();
     struct settings settings;
+    /* settings the setup function leaves alone stay disabled */
+    memset(&settings, 0, sizeof(settings));
     setup(&settings);
     prepare_screen(&settings);
+    set_texture_budget((size_t)settings.texture_budget_kb * 1024);
     prepare_audio_device();
-    toolbox = (struct toolbox*)malloc(sizeof(struct toolbox));
+    if (start_workers(settings.worker_threads) == -1)
+        exit_with_error_msg(get_error_msgs());
+    if (prepare_arenas((size_t)settings.arena_size_kb * 1024) == -1)
+        exit_with_error_msg(get_error_msgs());
+    if (prepare_replay(settings.record_input, settings.replay_input) == -1)
+        exit_with_error_msg(get_error_msgs());
+    toolbox = (struct toolbox*)MALLOC(sizeof(struct toolbox), MEMORY_ENGINE);
     if (toolbox == NULL) {
         exit(1);
     }
@@ -229,18 +303,29 @@ int game_setup_and_loop(setup_func_t setup,
             quit = true;
             break;
         }
-        SDL_RenderClear(screen->impl);
-        /* limit framerate to ~60FPS */
+        begin_frame();
+        /* limit framerate to ~60FPS, replays run as fast as they can */
         now = SDL_GetTicks();
-        if (now - start < 16) SDL_Delay(16 - (now - start));
+        if (!is_replaying_input() && now - start < 16)
+            SDL_Delay(16 - (now - start));
         now = SDL_GetTicks();
+        frame_start = SDL_GetPerformanceCounter();
 
         toolbox->stopwatch = (float)now - (float)start;
         keyboard->keys = SDL_GetKeyboardState(NULL);
+        sample_mouse();
+        if (replay_frame(&toolbox->stopwatch) == -1) {
+            quit = true;
+            break;
+        }
         toolbox->state->update(toolbox->data, toolbox->stopwatch);
+        finish_jobs();
         if (toolbox->next_state != NULL) set_game_state();
         start = now;
-        SDL_RenderPresent(screen->impl);
+        present_frame(frame_start);
+        next_frame_arenas();
+        next_texture_frame();
+        dispatch_file_writes();
     }
     return 0;
 }
@@ -252,6 +337,9 @@ static void default_setup_callback(struct settings* settings)
     settings->logical_width = 192;
     settings->logical_height = 108;
     settings->fullscreen = false;
+    settings->frame_budget_ms = 0;
+    settings->min_render_scale = 0.5f;
+    settings->worker_threads = 0;
     read_conf_file(settings);
 }
 
@@ -23,11 +23,24 @@
 #define NGX_H_F8WRBKFT
 
 #include "utils.h"
+#include "arena.h"
+#include "memory_stats.h"
 #include "vec.h"
 #include "geometry.h"
 #include "screen.h"
 #include "image.h"
+#include "render_pass.h"
+#include "draw_queue.h"
+#include "lightmap.h"
 #include "sprite.h"
+#include "sprite_batch.h"
+#include "sprite_sheet.h"
+#include "tile_animation.h"
+#include "tile_layer.h"
+#include "tilemap.h"
+#include "particles.h"
+#include "entities.h"
+#include "path.h"
 #include "keyboard.h"
 #include "mouse.h"
 #include "font.h"
@@ -37,6 +50,10 @@
 #include "toolbox.h"
 #include "easing.h"
 #include "file.h"
+#include "pack.h"
+#include "snapshot.h"
+#include "replay.h"
+#include "jobs.h"
 #include "begin_prefix.h"
 
 /**
@@ -109,6 +126,42 @@ struct settings {
     int logical_width;
     int logical_height;
     bool fullscreen;
+    /**
+     * Frame time budget in milliseconds for dynamic resolution, or 0 to
+     * disable it. When enabled, the game is drawn at a fraction of the
+     * logical size that goes down while updating and presenting frames
+     * takes longer than the budget, and back up when there is time to
+     * spare. The result is stretched over the window.
+     */
+    float frame_budget_ms;
+    /** lowest fraction of the logical size dynamic resolution draws at */
+    float min_render_scale;
+    /**
+     * Number of job worker threads beside the main thread, -1 for one
+     * per remaining core, or 0 to run jobs on the main thread only,
+     * which is the default
+     */
+    int worker_threads;
+    /**
+     * Size in KB of each of the frame, two frame and scratch arenas, or
+     * 0 for DEFAULT_ARENA_SIZE, see \ref arena
+     */
+    int arena_size_kb;
+    /**
+     * Texture memory in KB managed images may take, or 0 to never
+     * evict textures, see create_managed_image()
+     */
+    int texture_budget_kb;
+    /**
+     * Path of a file to record the input of every frame to, or NULL,
+     * see is_replaying_input()
+     */
+    const char* record_input;
+    /**
+     * Path of a file recorded using record_input to replay instead of
+     * sampling the keyboard and mouse, or NULL
+     */
+    const char* replay_input;
 };
 
 typedef void (*setup_func_t)(struct settings*);
@@ -43,6 +43,12 @@ void image::draw(int x, int y) {
     cage_rectangle r = {0, 0, _image->width, _image->height};
     cage_draw_image(_image, x, y, &r, 0);
 }
+void image::draw(int x,
+                 int y,
+                 cage_rectangle *clip,
+                 const draw_params &params) {
+    cage_draw_image_ex(_image, x, y, clip, &params);
+}
 void image::draw_off() {
     screen::draw_on();
 }
@@ -103,9 +109,18 @@ sprite::sprite(const image &image, int w, int h) {
 int sprite::draw(int x, int y) const {
     return cage_draw_sprite(_sprite, x, y);
 }
+int sprite::draw(int x, int y, const draw_params &params) const {
+    return cage_draw_sprite_ex(_sprite, x, y, &params);
+}
 void sprite::draw_frame(int x, int y, int frame) const {
     cage_draw_sprite_frame(_sprite, x, y, frame);
 }
+void sprite::draw_frame(int x,
+                        int y,
+                        int frame,
+                        const draw_params &params) const {
+    cage_draw_sprite_frame_ex(_sprite, x, y, frame, &params);
+}
 void *sprite::animate(uint32_t elapsed) {
     return cage_animate_sprite(_sprite, elapsed);
 }
@@ -189,10 +204,13 @@ font::font(std::string filename, int cols, int rows) {
 font::~font() {
     cage_destroy_font(_font);
 }
-void font::draw_text(std::string text, int x, int y) {
+void font::draw_text(const std::string &text, int x, int y) {
     cage_draw_text(_font, text.c_str(), x, y);
 }
-void font::measure_text(std::string text, int *x, int *y) {
+void font::draw_text(const char *text, int x, int y) {
+    cage_draw_text(_font, text, x, y);
+}
+void font::measure_text(const std::string &text, int *x, int *y) {
     cage_measure_text(_font, text.c_str(), x, y);
 }
 
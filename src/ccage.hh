@@ -5,14 +5,17 @@
 #include <stdexcept>
 #include <string>
 #include <iostream>
+#include <new>
 #include <unordered_map>
 #include <vector>
 
 #include "cage.h"
+#include "ccage_easing.hh"
 
 namespace cage {
 
 using rectangle = cage_rectangle;
+using draw_params = cage_draw_params;
 
 //----------------------------------------------------------------------------
 // Color wrapper
@@ -39,6 +42,7 @@ class image {
     void draw_off();
     void draw(int x, int y, cage_rectangle *clip, float angle);
     void draw(int x, int y);
+    void draw(int x, int y, cage_rectangle *clip, const draw_params &params);
     void blend();
     void multiply();
     void add();
@@ -74,7 +78,9 @@ class sprite {
   public:
     sprite(const image &image, int w, int h);
     int draw(int x, int y) const;
+    int draw(int x, int y, const draw_params &params) const;
     void draw_frame(int x, int y, int frame) const;
+    void draw_frame(int x, int y, int frame, const draw_params &params) const;
     void *animate(uint32_t elapsed);
     void play(const animation &animation);
     operator cage_sprite *() const;
@@ -114,6 +120,16 @@ class timeline {
                            uint32_t duration,
                            std::function<void(float, float)>
                                callback);
+    template <typename Ease>
+    timeline &append_tween(uint32_t wait,
+                           uint32_t duration,
+                           float from,
+                           float to,
+                           std::function<void(float)> callback) {
+        return append_event(wait, duration, [=](float, float progress) {
+            callback(interpolate<Ease>(from, to, progress));
+        });
+    }
     void update(float elapsed_ms);
     void reset();
     void pause();
@@ -144,8 +160,9 @@ class font {
   public:
     font(std::string filename, int cols, int rows);
     virtual ~font();
-    void draw_text(std::string text, int x, int y);
-    void measure_text(std::string text, int *x, int *y);
+    void draw_text(const std::string &text, int x, int y);
+    void draw_text(const char *text, int x, int y);
+    void measure_text(const std::string &text, int *x, int *y);
 };
 
 //----------------------------------------------------------------------------
@@ -159,6 +176,44 @@ class screen {
     static void set_blend_mode(cage_blend_mode blend_mode);
 };
 
+//----------------------------------------------------------------------------
+// Frame allocator
+//
+// Standard allocator on top of cage_frame_alloc(), for containers that
+// only live during the current frame. Deallocation is a no-op, the
+// memory comes back once the frame is presented:
+//
+//     cage::frame_vector<vec> targets;
+//     targets.reserve(n_enemies);
+//
+template <typename T>
+struct frame_allocator {
+    using value_type = T;
+    frame_allocator() = default;
+    template <typename U>
+    constexpr frame_allocator(const frame_allocator<U> &) noexcept {}
+    T *allocate(std::size_t n) {
+        void *p = cage_frame_alloc(n * sizeof(T));
+        if (p == nullptr) throw std::bad_alloc();
+        return static_cast<T *>(p);
+    }
+    void deallocate(T *, std::size_t) noexcept {}
+};
+
+template <typename T, typename U>
+constexpr bool operator==(const frame_allocator<T> &,
+                          const frame_allocator<U> &) {
+    return true;
+}
+template <typename T, typename U>
+constexpr bool operator!=(const frame_allocator<T> &,
+                          const frame_allocator<U> &) {
+    return false;
+}
+
+template <typename T>
+using frame_vector = std::vector<T, frame_allocator<T>>;
+
 //----------------------------------------------------------------------------
 // Game wrapper
 class game {
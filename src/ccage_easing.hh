@@ -0,0 +1,368 @@
+#ifndef CCAGE_EASING_HH_INCLUDED
+#define CCAGE_EASING_HH_INCLUDED
+
+#include <array>
+#include <cstddef>
+
+namespace cage {
+
+//----------------------------------------------------------------------------
+// Compile-time math
+//
+// The standard <cmath> functions are not constexpr, so the few curves that
+// need sin(), sqrt() or pow(2, x) use these instead. They are accurate to a
+// few ulps in float over the [0, 1] range the easing curves work in, and they
+// let us build lookup tables while compiling.
+namespace detail {
+
+constexpr double pi = 3.14159265358979323846264338328;
+
+constexpr double floor(double x) {
+    long long i = static_cast<long long>(x);
+    return (x < 0 && static_cast<double>(i) != x) ? i - 1 : i;
+}
+
+constexpr double sin(double x) {
+    // reduce to [-pi, pi] and then to [-pi/2, pi/2]
+    x = x - 2 * pi * floor((x + pi) / (2 * pi));
+    if (x > pi / 2) x = pi - x;
+    if (x < -pi / 2) x = -pi - x;
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 10; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double cos(double x) {
+    return sin(x + pi / 2);
+}
+
+constexpr double sqrt(double x) {
+    if (x <= 0) return 0;
+    double r = x > 1 ? x : 1;
+    for (int i = 0; i < 64; i++) {
+        double n = 0.5 * (r + x / r);
+        if (n == r) break;
+        r = n;
+    }
+    return r;
+}
+
+constexpr double exp2(double x) {
+    double n = floor(x);
+    double f = (x - n) * 0.69314718055994530941723212146;
+    double term = 1;
+    double sum = 1;
+    for (int k = 1; k < 20; k++) {
+        term *= f / k;
+        sum += term;
+    }
+    for (; n > 0; n--) sum *= 2;
+    for (; n < 0; n++) sum /= 2;
+    return sum;
+}
+
+// Same value as Pi_2 in utils.h, so the C++ curves match the C ones.
+constexpr double pi_2 = pi * 2;
+}
+
+//----------------------------------------------------------------------------
+// Easing functors
+//
+// Each functor mirrors one of the C easing functions in easing.h. Pass them
+// as template arguments instead of function pointers and the compiler can
+// inline the curve at the call site:
+//
+//     float x = cage::interpolate<cage::ease::cubic_out>(0, 100, progress);
+//
+namespace ease {
+
+struct linear {
+    constexpr float operator()(float p) const { return p; }
+};
+
+struct quadratic_in {
+    constexpr float operator()(float p) const { return p * p; }
+};
+
+struct quadratic_out {
+    constexpr float operator()(float p) const { return -(p * (p - 2)); }
+};
+
+struct quadratic_in_out {
+    constexpr float operator()(float p) const {
+        return p < 0.5f ? 2 * p * p : (-2 * p * p) + (4 * p) - 1;
+    }
+};
+
+struct cubic_in {
+    constexpr float operator()(float p) const { return p * p * p; }
+};
+
+struct cubic_out {
+    constexpr float operator()(float p) const {
+        float f = p - 1;
+        return f * f * f + 1;
+    }
+};
+
+struct cubic_in_out {
+    constexpr float operator()(float p) const {
+        if (p < 0.5f) return 4 * p * p * p;
+        float f = (2 * p) - 2;
+        return 0.5f * f * f * f + 1;
+    }
+};
+
+struct quartic_in {
+    constexpr float operator()(float p) const { return p * p * p * p; }
+};
+
+struct quartic_out {
+    constexpr float operator()(float p) const {
+        float f = p - 1;
+        return f * f * f * (1 - p) + 1;
+    }
+};
+
+struct quartic_in_out {
+    constexpr float operator()(float p) const {
+        if (p < 0.5f) return 8 * p * p * p * p;
+        float f = p - 1;
+        return -8 * f * f * f * f + 1;
+    }
+};
+
+struct quintic_in {
+    constexpr float operator()(float p) const { return p * p * p * p * p; }
+};
+
+struct quintic_out {
+    constexpr float operator()(float p) const {
+        float f = p - 1;
+        return f * f * f * f * f + 1;
+    }
+};
+
+struct quintic_in_out {
+    constexpr float operator()(float p) const {
+        if (p < 0.5f) return 16 * p * p * p * p * p;
+        float f = (2 * p) - 2;
+        return 0.5f * f * f * f * f * f + 1;
+    }
+};
+
+struct sine_in {
+    constexpr float operator()(float p) const {
+        return detail::sin((p - 1) * detail::pi_2) + 1;
+    }
+};
+
+struct sine_out {
+    constexpr float operator()(float p) const {
+        return detail::sin(p * detail::pi_2);
+    }
+};
+
+struct sine_in_out {
+    constexpr float operator()(float p) const {
+        return 0.5 * (1 - detail::cos(p * detail::pi));
+    }
+};
+
+struct circular_in {
+    constexpr float operator()(float p) const {
+        return 1 - detail::sqrt(1 - (p * p));
+    }
+};
+
+struct circular_out {
+    constexpr float operator()(float p) const {
+        return detail::sqrt((2 - p) * p);
+    }
+};
+
+struct circular_in_out {
+    constexpr float operator()(float p) const {
+        if (p < 0.5f) return 0.5 * (1 - detail::sqrt(1 - 4 * (p * p)));
+        return 0.5 * (detail::sqrt(-((2 * p) - 3) * ((2 * p) - 1)) + 1);
+    }
+};
+
+struct exponential_in {
+    constexpr float operator()(float p) const {
+        return p == 0.0f ? p : detail::exp2(10 * (p - 1));
+    }
+};
+
+struct exponential_out {
+    constexpr float operator()(float p) const {
+        return p == 1.0f ? p : 1 - detail::exp2(-10 * p);
+    }
+};
+
+struct exponential_in_out {
+    constexpr float operator()(float p) const {
+        if (p == 0.0f || p == 1.0f) return p;
+        if (p < 0.5f) return 0.5 * detail::exp2((20 * p) - 10);
+        return -0.5 * detail::exp2((-20 * p) + 10) + 1;
+    }
+};
+
+struct elastic_in {
+    constexpr float operator()(float p) const {
+        return detail::sin(13 * detail::pi_2 * p) * detail::exp2(10 * (p - 1));
+    }
+};
+
+struct elastic_out {
+    constexpr float operator()(float p) const {
+        return detail::sin(-13 * detail::pi_2 * (p + 1)) *
+                   detail::exp2(-10 * p) +
+               1;
+    }
+};
+
+struct elastic_in_out {
+    constexpr float operator()(float p) const {
+        if (p < 0.5f)
+            return 0.5 * detail::sin(13 * detail::pi_2 * (2 * p)) *
+                   detail::exp2(10 * ((2 * p) - 1));
+        return 0.5 * (detail::sin(-13 * detail::pi_2 * ((2 * p - 1) + 1)) *
+                          detail::exp2(-10 * (2 * p - 1)) +
+                      2);
+    }
+};
+
+struct back_in {
+    constexpr float operator()(float p) const {
+        return p * p * p - p * detail::sin(p * detail::pi);
+    }
+};
+
+struct back_out {
+    constexpr float operator()(float p) const {
+        float f = 1 - p;
+        return 1 - (f * f * f - f * detail::sin(f * detail::pi));
+    }
+};
+
+struct back_in_out {
+    constexpr float operator()(float p) const {
+        if (p < 0.5f) {
+            float f = 2 * p;
+            return 0.5 * (f * f * f - f * detail::sin(f * detail::pi));
+        }
+        float f = 1 - (2 * p - 1);
+        return 0.5 * (1 - (f * f * f - f * detail::sin(f * detail::pi))) +
+               0.5;
+    }
+};
+
+struct bounce_out {
+    constexpr float operator()(float p) const {
+        if (p < 4 / 11.0) return (121 * p * p) / 16.0;
+        if (p < 8 / 11.0) return (363 / 40.0 * p * p) - (99 / 10.0 * p) +
+                                 17 / 5.0;
+        if (p < 9 / 10.0) return (4356 / 361.0 * p * p) -
+                                 (35442 / 1805.0 * p) + 16061 / 1805.0;
+        return (54 / 5.0 * p * p) - (513 / 25.0 * p) + 268 / 25.0;
+    }
+};
+
+struct bounce_in {
+    constexpr float operator()(float p) const {
+        return 1 - bounce_out{}(1 - p);
+    }
+};
+
+struct bounce_in_out {
+    constexpr float operator()(float p) const {
+        return p < 0.5f ? 0.5f * bounce_in{}(p * 2)
+                        : 0.5f * bounce_out{}(p * 2 - 1) + 0.5f;
+    }
+};
+
+//----------------------------------------------------------------------------
+// Lookup table curve
+//
+// Wraps any of the functors above with a table of N + 1 samples built at
+// compile time. Evaluating it costs one multiply, one table read and a
+// lerp, which pays off for the sine, exponential and elastic families:
+//
+//     using fast_elastic = cage::ease::lut<cage::ease::elastic_out>;
+//     float x = cage::interpolate<fast_elastic>(0, 100, progress);
+//
+template <typename Ease, std::size_t N = 256>
+struct lut {
+    static_assert(N > 0, "a lookup table needs at least one segment");
+
+    static constexpr std::array<float, N + 1> build() {
+        std::array<float, N + 1> t{};
+        for (std::size_t i = 0; i <= N; i++)
+            t[i] = Ease{}(static_cast<float>(i) / N);
+        return t;
+    }
+
+    static constexpr std::array<float, N + 1> table = build();
+
+    constexpr float operator()(float p) const {
+        if (p <= 0.0f) return table[0];
+        if (p >= 1.0f) return table[N];
+        float x = p * N;
+        std::size_t i = static_cast<std::size_t>(x);
+        float f = x - i;
+        return table[i] + (table[i + 1] - table[i]) * f;
+    }
+};
+}
+
+//----------------------------------------------------------------------------
+// Interpolate two values using an easing functor
+template <typename Ease>
+constexpr float interpolate(float from, float to, float amount) {
+    return from + (to - from) * Ease{}(amount);
+}
+
+//----------------------------------------------------------------------------
+// Tween
+//
+// A self-contained value animation from one value to another over a
+// duration in milliseconds. The easing curve is part of the type, so
+// updating a tween never goes through a function pointer:
+//
+//     cage::tween<cage::ease::back_out> slide{-100, 20, 1000};
+//     ...
+//     sprite.draw(slide.update(elapsed_ms), 10);
+//
+template <typename Ease>
+class tween {
+  private:
+    float _from;
+    float _to;
+    float _duration;
+    float _elapsed{0};
+
+  public:
+    constexpr tween(float from, float to, float duration_ms)
+        : _from(from), _to(to), _duration(duration_ms) {}
+    float update(float elapsed_ms) {
+        _elapsed += elapsed_ms;
+        if (_elapsed > _duration) _elapsed = _duration;
+        return value();
+    }
+    constexpr float progress() const {
+        return _duration > 0 ? _elapsed / _duration : 1.0f;
+    }
+    constexpr float value() const {
+        return interpolate<Ease>(_from, _to, progress());
+    }
+    constexpr bool done() const { return _elapsed >= _duration; }
+    void reset() { _elapsed = 0; }
+};
+}
+
+#endif  // CCAGE_EASING_HH_INCLUDED
@@ -0,0 +1,342 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "draw_queue.h"
+#include "internals.h"
+#include "utils.h"
+#include <stdlib.h>
+#include "begin_prefix.h"
+
+/* Image ids hash table size, a power of two with room to spare */
+#define IMAGE_SLOTS (DRAW_QUEUE_IMAGES * 2)
+
+/* Sort keys hold the biased layer in the high 16 bits, then 3 bits of
+ * blend mode and the image id in the low bits. */
+#define LAYER_SHIFT 16
+#define BLEND_SHIFT 11
+
+static void reset_images(struct draw_queue* queue)
+{
+    int i;
+    for (i = 0; i < IMAGE_SLOTS; i++) queue->image_slots[i] = -1;
+    queue->n_images = 0;
+}
+
+struct draw_queue* create_draw_queue(int capacity)
+{
+    struct draw_queue* queue;
+
+    if (capacity <= 0) {
+        ERROR("Draw queue capacity must be positive");
+        return NULL;
+    }
+    queue = (struct draw_queue*)CALLOC(
+    1, sizeof(struct draw_queue), MEMORY_RENDER);
+    if (queue == NULL) goto error;
+    queue->commands = (struct draw_command*)MALLOC(
+    sizeof(struct draw_command) * capacity, MEMORY_RENDER);
+    if (queue->commands == NULL) goto free_queue;
+    /* keys and the sort buffers: keys, order, and a copy of both */
+    queue->keys = (uint32_t*)MALLOC(
+    sizeof(uint32_t) * 4 * capacity, MEMORY_RENDER);
+    if (queue->keys == NULL) goto free_commands;
+    queue->image_slots = (int*)MALLOC(sizeof(int) * IMAGE_SLOTS, MEMORY_RENDER);
+    if (queue->image_slots == NULL) goto free_keys;
+    queue->capacity = capacity;
+    reset_images(queue);
+    return queue;
+
+free_keys:
+    FREE(queue->keys);
+free_commands:
+    FREE(queue->commands);
+free_queue:
+    FREE(queue);
+error:
+    ERROR("Unable to allocate a draw queue");
+    return NULL;
+}
+
+static void release_held(struct draw_queue* queue)
+{
+    int i;
+    for (i = 0; i < queue->n_held; i++) release_render_target(queue->held[i]);
+    queue->n_held = 0;
+}
+
+void destroy_draw_queue(struct draw_queue* queue)
+{
+    if (queue != NULL) {
+        if (screen->queue == queue) screen->queue = NULL;
+        release_held(queue);
+        FREE(queue->held);
+        FREE(queue->image_slots);
+        FREE(queue->keys);
+        FREE(queue->commands);
+        FREE(queue);
+    }
+}
+
+void queue_draws(struct draw_queue* queue, int layer)
+{
+    if (layer < -32768) layer = -32768;
+    if (layer > 32767) layer = 32767;
+    queue->layer = layer;
+    /* the target is bound to the queue with its first draw */
+    if (queue->count == 0) queue->target = screen->target;
+    screen->queue = queue;
+}
+
+static int grow_queue(struct draw_queue* queue)
+{
+    int capacity = queue->capacity * 2;
+    struct draw_command* commands;
+    uint32_t* keys;
+
+    commands = (struct draw_command*)REALLOC(
+    queue->commands, sizeof(struct draw_command) * capacity, MEMORY_RENDER);
+    if (commands == NULL) goto error;
+    queue->commands = commands;
+    keys = (uint32_t*)REALLOC(
+    queue->keys, sizeof(uint32_t) * 4 * capacity, MEMORY_RENDER);
+    if (keys == NULL) goto error;
+    queue->keys = keys;
+    queue->capacity = capacity;
+    return 0;
+
+error:
+    ERROR("Unable to grow a draw queue");
+    return -1;
+}
+
+static int image_id(struct draw_queue* queue, struct image* image)
+{
+    uint32_t slot = (uint32_t)(((uintptr_t)image >> 4) * 2654435761u);
+    int id;
+
+    slot &= IMAGE_SLOTS - 1;
+    while ((id = queue->image_slots[slot]) != -1) {
+        if (queue->images[id] == image) return id;
+        slot = (slot + 1) & (IMAGE_SLOTS - 1);
+    }
+    /* past the limit, images share the last id and only lose grouping */
+    if (queue->n_images == DRAW_QUEUE_IMAGES) return DRAW_QUEUE_IMAGES - 1;
+    id = queue->n_images++;
+    queue->images[id] = image;
+    queue->image_slots[slot] = id;
+    return id;
+}
+
+static struct draw_command* record_draw(struct image* image)
+{
+    struct draw_queue* queue = screen->queue;
+    struct draw_command* command;
+    uint32_t blend;
+
+    if (queue->target != screen->target) return NULL;
+    if (queue->count == queue->capacity && grow_queue(queue) == -1)
+        return NULL;
+    /* SDL blend modes are 0, 1, 2 and 4, and 7 stands for unknown */
+    blend = image->blend_state < 0 ? 7 : (uint32_t)image->blend_state & 7;
+    queue->keys[queue->count] =
+    ((uint32_t)(queue->layer + 32768) << LAYER_SHIFT) |
+    (blend << BLEND_SHIFT) | (uint32_t)image_id(queue, image);
+    /* the image state may change before the flush */
+    command = &queue->commands[queue->count++];
+    command->alpha = image->alpha;
+    command->blend_state = image->blend_state;
+    return command;
+}
+
+int queue_draw_image(struct image* image,
+                     int x,
+                     int y,
+                     const struct rectangle* clip,
+                     double angle)
+{
+    struct draw_command* command = record_draw(image);
+    if (command == NULL) return 0;
+    command->image = image;
+    command->has_clip = clip != NULL;
+    if (clip != NULL) command->clip = *clip;
+    command->extended = false;
+    command->x = x;
+    command->y = y;
+    command->params.angle = angle;
+    return 1;
+}
+
+int queue_render_image_ex(struct image* image,
+                          const struct rectangle* clip,
+                          float x,
+                          float y,
+                          float offset_x,
+                          float offset_y,
+                          float pivot_x,
+                          float pivot_y,
+                          const struct draw_params* params)
+{
+    struct draw_command* command = record_draw(image);
+    if (command == NULL) return 0;
+    command->image = image;
+    command->has_clip = true;
+    command->clip = *clip;
+    command->extended = true;
+    command->x = x;
+    command->y = y;
+    command->offset_x = offset_x;
+    command->offset_y = offset_y;
+    command->pivot_x = pivot_x;
+    command->pivot_y = pivot_y;
+    command->params = *params;
+    return 1;
+}
+
+int hold_until_flushed(struct image* target)
+{
+    struct draw_queue* queue = screen->queue;
+    if (queue == NULL || queue->target != screen->target) return 0;
+    if (queue->n_held == queue->held_capacity) {
+        int capacity = queue->held_capacity > 0 ? queue->held_capacity * 2 : 4;
+        struct image** held = (struct image**)REALLOC(
+        queue->held, sizeof(struct image*) * capacity, MEMORY_RENDER);
+        if (held == NULL) {
+            /* keep the target out of the pool rather than reuse it */
+            ERROR("Unable to hold a render pass target");
+            return 1;
+        }
+        queue->held = held;
+        queue->held_capacity = capacity;
+    }
+    queue->held[queue->n_held++] = target;
+    return 1;
+}
+
+/* Stable LSD radix sort of the draw keys, one byte per pass. Passes
+ * where every key has the same byte, such as the layer bytes when all
+ * draws share a layer, are skipped.
+ * Returns the draw indices in sorted order. */
+static uint32_t* sort_draws(struct draw_queue* queue)
+{
+    int n = queue->count;
+    uint32_t* keys = queue->keys;
+    uint32_t* order = keys + queue->capacity;
+    uint32_t* sorted_keys = order + queue->capacity;
+    uint32_t* sorted_order = sorted_keys + queue->capacity;
+    uint32_t* swap;
+    unsigned counts[4][256] = {{0}};
+    unsigned offsets[256];
+    unsigned total;
+    int i, pass, digit;
+
+    for (i = 0; i < n; i++) {
+        counts[0][keys[i] & 0xff]++;
+        counts[1][(keys[i] >> 8) & 0xff]++;
+        counts[2][(keys[i] >> 16) & 0xff]++;
+        counts[3][keys[i] >> 24]++;
+        order[i] = i;
+    }
+
+    for (pass = 0; pass < 4; pass++) {
+        int shift = pass * 8;
+        if (counts[pass][(keys[0] >> shift) & 0xff] == (unsigned)n) continue;
+        total = 0;
+        for (digit = 0; digit < 256; digit++) {
+            offsets[digit] = total;
+            total += counts[pass][digit];
+        }
+        for (i = 0; i < n; i++) {
+            unsigned at = offsets[(keys[i] >> shift) & 0xff]++;
+            sorted_keys[at] = keys[i];
+            sorted_order[at] = order[i];
+        }
+        swap = keys;
+        keys = sorted_keys;
+        sorted_keys = swap;
+        swap = order;
+        order = sorted_order;
+        sorted_order = swap;
+    }
+    return order;
+}
+
+/* Give an image back the alpha and blend mode it had before a run of
+ * its draws was flushed */
+static void restore_image(struct image* image, uint8_t alpha, int blend_state)
+{
+    image->alpha = alpha;
+    if (blend_state != -1)
+        set_texture_blend_mode(image, (SDL_BlendMode)blend_state);
+}
+
+void flush_draw_queue(struct draw_queue* queue)
+{
+    struct image* previous = screen->target;
+    struct image* last = NULL;
+    struct draw_command* command;
+    uint32_t* order;
+    uint8_t alpha = 0;
+    int blend_state = -1;
+    int i;
+
+    if (screen->queue == queue) screen->queue = NULL;
+    queue->batches = 0;
+    if (queue->count == 0) {
+        release_held(queue);
+        return;
+    }
+    order = sort_draws(queue);
+    if (set_render_target(queue->target) != 0) {
+        ERROR("Unable to bind the draw queue target");
+        goto clear;
+    }
+    for (i = 0; i < queue->count; i++) {
+        command = &queue->commands[order[i]];
+        if (command->image != last) {
+            if (last != NULL) restore_image(last, alpha, blend_state);
+            queue->batches++;
+            last = command->image;
+            alpha = last->alpha;
+            blend_state = last->blend_state;
+        }
+        /* draw with the state the image had when the draw was recorded */
+        last->alpha = command->alpha;
+        if (command->blend_state != -1)
+            set_texture_blend_mode(last, (SDL_BlendMode)command->blend_state);
+        if (command->extended) {
+            render_image_ex(command->image, &command->clip, command->x,
+                            command->y, command->offset_x, command->offset_y,
+                            command->pivot_x, command->pivot_y,
+                            &command->params);
+        } else {
+            draw_image(command->image, (int)command->x, (int)command->y,
+                       command->has_clip ? &command->clip : NULL,
+                       command->params.angle);
+        }
+    }
+    restore_image(last, alpha, blend_state);
+    set_render_target(previous);
+
+clear:
+    queue->count = 0;
+    reset_images(queue);
+    release_held(queue);
+}
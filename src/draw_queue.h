@@ -0,0 +1,145 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#ifndef DRAW_QUEUE_H_P3VK8ZRM
+#define DRAW_QUEUE_H_P3VK8ZRM
+
+#include <stdint.h>
+#include "image.h"
+#include "types.h"
+
+#include "begin_prefix.h"
+/** Number of distinct images a draw queue can group per flush */
+#define DRAW_QUEUE_IMAGES 2048
+
+/**
+ * A single draw recorded by a \ref draw_queue.
+ */
+struct draw_command {
+    /** image to draw */
+    struct image* image;
+    /** image area to draw */
+    struct rectangle clip;
+    /** false when the whole image is drawn */
+    bool has_clip;
+    /** true for draws going through the extended draw functions */
+    bool extended;
+    /** image alpha when the draw was recorded */
+    uint8_t alpha;
+    /* image blend mode when the draw was recorded, as in blend_state */
+    int blend_state;
+    /* render_image_ex() arguments, only x, y and params.angle are used
+     * by plain draws */
+    float x;
+    float y;
+    float offset_x;
+    float offset_y;
+    float pivot_x;
+    float pivot_y;
+    struct draw_params params;
+};
+
+/**
+ * Draw queues let you draw in any order and still get the layering you
+ * want. While a queue is active, images, sprites, text and tile layers
+ * drawn on the current target are recorded with the current layer
+ * instead of being drawn:
+ *
+ *     queue_draws(queue, 10);
+ *     draw_sprite(hero, x, y);
+ *     queue_draws(queue, 0);
+ *     draw_tile_layer(ground, camera_x, camera_y, width, height);
+ *     flush_draw_queue(queue);
+ *
+ * flush_draw_queue() sorts the recorded draws by layer, lowest first, and
+ * within a layer by blend mode and image, so draws that share an image
+ * end up next to each other and need no renderer state changes between
+ * them. The sort is stable: draws with the same layer and image keep the
+ * order they were made in. Draws that must overlap in a given order on
+ * the same layer should use different layers.
+ *
+ * Draws are made at flush time, so the recorded images must stay alive
+ * until then, and their alpha and blend mode are read when they are
+ * drawn. Drawing on another target, such as a render pass or a tile
+ * layer pre-rendering its chunks, is never queued. Particle emitters
+ * draw right away.
+ */
+struct draw_queue {
+    /** number of draws recorded since the last flush */
+    int count;
+    /** allocated size of the commands array */
+    int capacity;
+    /** recorded draws, in submission order */
+    struct draw_command* commands;
+    /** layer given to recorded draws */
+    int layer;
+    /** number of runs of draws sharing an image in the last flush */
+    int batches;
+    /* render target the queue records draws for */
+    struct image* target;
+    /* render pass targets to release once the queue is flushed */
+    struct image** held;
+    int n_held;
+    int held_capacity;
+    /* sort keys of the recorded draws, followed by the sort buffers */
+    uint32_t* keys;
+    /* image ids assigned since the last flush, through a hash table
+     * of indices in images */
+    struct image* images[DRAW_QUEUE_IMAGES];
+    int n_images;
+    int* image_slots;
+};
+
+/**
+ * Allocate a new draw queue
+ * @param capacity initial number of draws the queue can hold. The queue
+ * grows as needed.
+ *
+ * @return a new draw queue or NULL on error
+ */
+struct draw_queue* create_draw_queue(int capacity);
+
+/**
+ * Destroy a draw queue created using create_draw_queue()
+ * @param queue queue to destroy. Draws that were not flushed are dropped.
+ */
+void destroy_draw_queue(struct draw_queue* queue);
+
+/**
+ * Start recording draws made on the current target, or change the layer
+ * of the following draws
+ * @param queue queue to record to
+ * @param layer layer of the following draws, from -32768 to 32767
+ *
+ * Only one queue records at a time. Activating a queue stops any other
+ * queue from recording, without flushing it.
+ */
+void queue_draws(struct draw_queue* queue, int layer);
+
+/**
+ * Stop recording, then make all recorded draws sorted by layer, blend
+ * mode and image
+ * @param queue queue to flush
+ */
+void flush_draw_queue(struct draw_queue* queue);
+
+#include "end_prefix.h"
+#endif /* end of include guard: DRAW_QUEUE_H_P3VK8ZRM */
@@ -1,28 +1,78 @@
 #ifdef CAGE_PREFIX
 #undef ADD
+#undef BBOX_COMPONENT
 #undef BLEND
+#undef FLIP_HORIZONTAL
+#undef FLIP_NONE
+#undef FLIP_VERTICAL
 #undef FREEZE_LAST_FRAME
 #undef LOOP_FRAMES
+#undef MEMORY_ANIMATIONS
+#undef MEMORY_ARENAS
+#undef MEMORY_AUDIO
+#undef MEMORY_ENGINE
+#undef MEMORY_ENTITIES
+#undef MEMORY_FONTS
+#undef MEMORY_IMAGES
+#undef MEMORY_JOBS
+#undef MEMORY_PACKS
+#undef MEMORY_PARTICLES
+#undef MEMORY_PATHS
+#undef MEMORY_RENDER
+#undef MEMORY_SNAPSHOTS
+#undef MEMORY_SOUNDS
+#undef MEMORY_SPRITES
+#undef MEMORY_TEXTURES
+#undef MEMORY_TILES
+#undef MEMORY_TIMELINES
 #undef MULTIPLY
 #undef NONE
+#undef NUM_OF_MEMORY_TAGS
+#undef PATH_DIAGONAL
+#undef PATH_FOUND
+#undef PATH_JUMP
+#undef PATH_NOT_FOUND
+#undef PATH_SEARCHING
+#undef PATH_STRAIGHT
 #undef PINGPONG_FRAMES
+#undef POSITION_COMPONENT
+#undef SPRITE_COMPONENT
+#undef add_component
 #undef add_frame
 #undef add_frames
+#undef add_job_dependency
+#undef add_light
+#undef add_render_pass
+#undef add_tile_animation
+#undef add_to_sprite_batch
 #undef add_vec
 #undef animate_sprite
+#undef animate_sprites
+#undef animated_tile
 #undef animation
 #undef animation_mode
 #undef append_event
 #undef append_events
+#undef apply_snapshot_delta
+#undef archetype
+#undef arena
+#undef arena_alloc
 #undef back_ease_in
 #undef back_ease_in_out
 #undef back_ease_out
 #undef bbox_in_bbox
 #undef bbox_intersect
+#undef begin_frame
+#undef begin_snapshot
 #undef blend_mode
+#undef block_map_tiles
 #undef bounce_ease_in
 #undef bounce_ease_in_out
 #undef bounce_ease_out
+#undef build_flow_field
+#undef build_pack
+#undef build_pack_ex
+#undef builtin_component
 #undef circular_ease_in
 #undef circular_ease_in_out
 #undef circular_ease_out
@@ -32,124 +82,349 @@
 #undef cleanup_sprite
 #undef cleanup_timeline
 #undef clear_image
+#undef clear_particles
 #undef color
 #undef color_from_RGB
 #undef color_from_RGBA
+#undef continue_path_search
 #undef coords
+#undef count_query_entities
 #undef create_animation
+#undef create_arena
 #undef create_blank_image
+#undef create_draw_queue
+#undef create_entity
+#undef create_flow_field
 #undef create_font
 #undef create_image
+#undef create_job
+#undef create_lightmap
+#undef create_managed_image
+#undef create_particle_emitter
+#undef create_path_finder
+#undef create_query
+#undef create_render_passes
+#undef create_sheet_sprite
+#undef create_snapshot
 #undef create_sound
 #undef create_sprite
+#undef create_sprite_batch
+#undef create_sprite_sheet
 #undef create_target_image
+#undef create_tile_animator
+#undef create_tile_layer
+#undef create_tilemap
 #undef create_timeline
+#undef create_world
 #undef cubic_ease_in
 #undef cubic_ease_in_out
 #undef cubic_ease_out
+#undef cull_quad
+#undef default_draw_params
 #undef destroy_animation
+#undef destroy_arena
+#undef destroy_draw_queue
+#undef destroy_entity
+#undef destroy_flow_field
 #undef destroy_font
 #undef destroy_image
+#undef destroy_lightmap
+#undef destroy_particle_emitter
+#undef destroy_path_finder
+#undef destroy_query
+#undef destroy_render_passes
+#undef destroy_snapshot
 #undef destroy_sound
 #undef destroy_sprite
+#undef destroy_sprite_batch
+#undef destroy_sprite_sheet
+#undef destroy_tile_animator
+#undef destroy_tile_layer
+#undef destroy_tilemap
 #undef destroy_timeline
+#undef destroy_world
+#undef dispatch_file_writes
 #undef div_vec
+#undef draw_batch_sprite
+#undef draw_batch_sprite_ex
+#undef draw_command
+#undef draw_entity_sprites
 #undef draw_image
+#undef draw_image_ex
+#undef draw_lightmap
 #undef draw_on_image
 #undef draw_on_screen
+#undef draw_params
+#undef draw_particles
+#undef draw_queue
+#undef draw_sheet_frame
+#undef draw_sheet_frame_ex
 #undef draw_sprite
+#undef draw_sprite_ex
 #undef draw_sprite_frame
+#undef draw_sprite_frame_ex
 #undef draw_text
+#undef draw_tile_layer
+#undef dump_memory_snapshot
 #undef elastic_ease_in
 #undef elastic_ease_in_out
 #undef elastic_ease_out
+#undef emit_particles
+#undef end_snapshot
+#undef entity_chunk
+#undef entity_query
+#undef entity_record
 #undef error_msg
 #undef exit_with_error_msg
 #undef exponential_ease_in
 #undef exponential_ease_in_out
 #undef exponential_ease_out
 #undef file_spec
+#undef file_view
+#undef find_path
+#undef find_sheet_frame
+#undef finish_file_writes
+#undef finish_jobs
+#undef flip_mode
+#undef flow_field
+#undef flush_draw_queue
 #undef font
 #undef frame
+#undef frame_alloc
 #undef game_loop
 #undef game_setup_and_loop
 #undef game_state
+#undef get_animated_tile
+#undef get_batch_frame
+#undef get_chunk_components
+#undef get_component
 #undef get_error_msgs
+#undef get_flow_direction
+#undef get_frame_arena
 #undef get_image_alpha
+#undef get_map_tile
+#undef get_memory_stats
+#undef get_memory_tag_name
+#undef get_pack_stats
+#undef get_path
+#undef get_render_scale
+#undef get_render_stats
+#undef get_render_target_size
+#undef get_scratch_arena
 #undef get_screen_size
+#undef get_texture_stats
+#undef get_tile
+#undef get_total_memory_stats
+#undef get_two_frame_arena
 #undef get_window_size
+#undef get_worker_count
+#undef hash_map_source
 #undef hdg_vec
+#undef hold_until_flushed
 #undef image
 #undef init_image_from_file
 #undef init_timeline
 #undef interpolate
+#undef invalidate_tile_layer
+#undef is_entity_alive
 #undef is_file_exists
+#undef is_job_done
+#undef is_map_walkable
+#undef is_memory_tracked
 #undef is_playing
+#undef is_replaying_input
+#undef job
 #undef key_down
 #undef key_pressed
 #undef keyboard
+#undef light
+#undef lightmap
 #undef linear_interpolation
 #undef load_font
+#undef load_snapshot
 #undef load_sound
+#undef load_tilemap
 #undef lock_image
+#undef make_snapshot_delta
+#undef map_file
+#undef map_file_memory
+#undef mark_arena
 #undef measure_text
+#undef memory_stats
+#undef memory_tag
 #undef message_box
+#undef mount_pack
 #undef mouse
+#undef mouse_state
 #undef mul_vec
+#undef next_animation_frame
+#undef next_frame_arenas
+#undef next_texture_frame
 #undef norm_vec
+#undef open_asset
+#undef pack_stats
+#undef parallel_for
+#undef particle_emitter
+#undef path_finder
+#undef path_flags
+#undef path_node
+#undef path_status
+#undef path_step
 #undef pause_timeline
 #undef pixels_collide
 #undef play_animation
+#undef play_batch_animation
 #undef play_sound
 #undef point_in_bbox
+#undef preload_assets
+#undef prepare_arenas
+#undef prepare_dynamic_resolution
+#undef prepare_replay
+#undef prepare_sheet_sprite
 #undef prepare_sprite
+#undef present_frame
+#undef purge_render_targets
 #undef quadratic_ease_in
 #undef quadratic_ease_in_out
 #undef quadratic_ease_out
 #undef quartic_ease_in
 #undef quartic_ease_in_out
 #undef quartic_ease_out
+#undef queue_draw_image
+#undef queue_draws
+#undef queue_render_image_ex
 #undef quintic_ease_in
 #undef quintic_ease_in_out
 #undef quintic_ease_out
+#undef read_bytes
+#undef read_double
 #undef read_file
+#undef read_float
+#undef read_i32
+#undef read_string
+#undef read_text_asset
+#undef read_u16
+#undef read_u32
+#undef read_u64
+#undef read_u8
+#undef read_varint
 #undef rect_from_sub_bbox
 #undef rectangle
+#undef register_component
 #undef relax_screen
+#undef release_arena
+#undef release_preloaded_assets
+#undef release_render_target
+#undef remove_component
+#undef remove_from_sprite_batch
+#undef render_image_ex
+#undef render_pass
+#undef render_passes
+#undef render_stats
+#undef replay_frame
+#undef reset_arena
+#undef reset_render_state
+#undef reset_render_stats
 #undef reset_timeline
+#undef rewind_snapshot
+#undef run_render_passes
+#undef run_system
+#undef run_system_parallel
+#undef sample_mouse
+#undef save_snapshot
+#undef save_tilemap
 #undef screen
 #undef screen_color
 #undef set_blend_mode
 #undef set_image_alpha
+#undef set_map_tile
+#undef set_render_draw_color
+#undef set_render_target
 #undef set_screen_blend_mode
 #undef set_screen_size
+#undef set_snapshot_data
+#undef set_texture_alpha_mod
+#undef set_texture_blend_mode
+#undef set_texture_budget
+#undef set_texture_color_mod
+#undef set_tile
+#undef set_tile_blocked
 #undef set_volume
 #undef set_window_size
 #undef settings
 #undef shake_screen
+#undef sheet_frame
 #undef sine_ease_in
 #undef sine_ease_in_out
 #undef sine_ease_out
+#undef snapshot
 #undef sound
 #undef sprite
+#undef sprite_batch
+#undef sprite_event
+#undef sprite_sheet
+#undef start_job
+#undef start_path_search
+#undef start_workers
 #undef stop_animation
+#undef stop_batch_animation
+#undef stop_file_writer
 #undef stop_sound
+#undef stop_workers
 #undef sub_vec
 #undef swap_vecs
+#undef teardown_arenas
+#undef teardown_dynamic_resolution
+#undef teardown_replay
+#undef texture_stats
+#undef tile_animator
+#undef tile_chunk
+#undef tile_frame
+#undef tile_layer
+#undef tilemap
 #undef timeline
 #undef timeline_event
 #undef toolbox
+#undef track_asset
+#undef tracked_calloc
+#undef tracked_free
+#undef tracked_malloc
+#undef tracked_realloc
 #undef translate_bbox
+#undef two_frame_alloc
 #undef unit_vec
 #undef unlock_image
+#undef unmap_file
+#undef unmap_file_memory
+#undef unmount_packs
+#undef untrack_asset
+#undef update_entity_bboxes
 #undef update_mouse
+#undef update_particles
+#undef update_tile_animator
 #undef update_timeline
+#undef use_image
 #undef vec_dist
 #undef vec_dist_mntn
 #undef vec_dist_sqrd
 #undef vec_len
 #undef vec_len_sqrd
+#undef wait_job
+#undef world
+#undef write_bytes
+#undef write_double
 #undef write_file
+#undef write_file_async
+#undef write_file_data
+#undef write_file_data_async
+#undef write_float
+#undef write_i32
+#undef write_string
+#undef write_u16
+#undef write_u32
+#undef write_u64
+#undef write_u8
+#undef write_varint
 #undef xy_vec
 #undef zero_vec
 #endif
@@ -0,0 +1,588 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "entities.h"
+#include "jobs.h"
+#include "internals.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include "begin_prefix.h"
+
+/* Entity handles keep the record index in the low bits and the record
+ * generation in the next ones, so handles of destroyed entities never
+ * match the record again until the generation wraps around. */
+#define INDEX_BITS 20
+#define INDEX_MASK ((1 << INDEX_BITS) - 1)
+#define GENERATION_MASK 0x3ff
+
+/* alignment of the component arrays in a chunk */
+#define ARRAY_ALIGN 16
+#define ALIGN_UP(n) (((n) + ARRAY_ALIGN - 1) & ~(size_t)(ARRAY_ALIGN - 1))
+
+struct archetype {
+    uint64_t mask;
+    /* component types, and the chunk offset of each type array or -1 */
+    int components[MAX_COMPONENTS];
+    int n_components;
+    int offsets[MAX_COMPONENTS];
+    int entities_offset;
+    int chunk_capacity;
+    size_t chunk_bytes;
+    /* every chunk but the last one is full */
+    struct entity_chunk** chunks;
+    int n_chunks;
+    int chunks_capacity;
+};
+
+struct entity_record {
+    /* NULL when the record is unused */
+    struct entity_chunk* chunk;
+    int row;
+    int generation;
+};
+
+static size_t layout_chunk(struct archetype* archetype,
+                           const size_t* sizes,
+                           int capacity)
+{
+    size_t offset = ALIGN_UP(sizeof(struct entity_chunk));
+    int i, c;
+    archetype->entities_offset = (int)offset;
+    offset += capacity * sizeof(int);
+    for (i = 0; i < archetype->n_components; i++) {
+        c = archetype->components[i];
+        offset = ALIGN_UP(offset);
+        archetype->offsets[c] = (int)offset;
+        offset += capacity * sizes[c];
+    }
+    return offset;
+}
+
+static struct archetype* create_archetype(struct world* world, uint64_t mask)
+{
+    struct archetype* archetype;
+    size_t row_size = sizeof(int);
+    int c, capacity;
+
+    archetype = (struct archetype*)CALLOC(
+    1, sizeof(struct archetype), MEMORY_ENTITIES);
+    if (archetype == NULL) return NULL;
+    archetype->mask = mask;
+    for (c = 0; c < MAX_COMPONENTS; c++) {
+        archetype->offsets[c] = -1;
+        if (mask & COMPONENT(c)) {
+            archetype->components[archetype->n_components++] = c;
+            row_size += world->sizes[c];
+        }
+    }
+    /* as many rows as fit, but at least one for huge components */
+    capacity = (int)((ENTITY_CHUNK_SIZE - sizeof(struct entity_chunk)) /
+                     row_size);
+    if (capacity < 1) capacity = 1;
+    while (capacity > 1 &&
+           layout_chunk(archetype, world->sizes, capacity) >
+           ENTITY_CHUNK_SIZE)
+        capacity--;
+    archetype->chunk_capacity = capacity;
+    archetype->chunk_bytes = layout_chunk(archetype, world->sizes, capacity);
+    return archetype;
+}
+
+static void destroy_archetype(struct archetype* archetype)
+{
+    int i;
+    for (i = 0; i < archetype->n_chunks; i++) FREE(archetype->chunks[i]);
+    FREE(archetype->chunks);
+    FREE(archetype);
+}
+
+static struct archetype* find_archetype(struct world* world, uint64_t mask)
+{
+    struct archetype* archetype;
+    struct archetype** archetypes;
+    uint64_t registered;
+    int i, capacity;
+
+    for (i = 0; i < world->n_archetypes; i++)
+        if (world->archetypes[i]->mask == mask) return world->archetypes[i];
+
+    registered = world->n_components == MAX_COMPONENTS
+                 ? ~(uint64_t)0
+                 : COMPONENT(world->n_components) - 1;
+    if (mask & ~registered) {
+        ERROR("Unregistered component type");
+        return NULL;
+    }
+    if (world->n_archetypes == world->archetypes_capacity) {
+        capacity = world->archetypes_capacity * 2;
+        if (capacity == 0) capacity = 16;
+        archetypes = (struct archetype**)REALLOC(
+        world->archetypes, capacity * sizeof(struct archetype*),
+        MEMORY_ENTITIES);
+        if (archetypes == NULL) goto error;
+        world->archetypes = archetypes;
+        world->archetypes_capacity = capacity;
+    }
+    archetype = create_archetype(world, mask);
+    if (archetype == NULL) goto error;
+    world->archetypes[world->n_archetypes++] = archetype;
+    return archetype;
+
+error:
+    ERROR("Unable to allocate an archetype");
+    return NULL;
+}
+
+static void* component_at(struct entity_chunk* chunk,
+                          const size_t* sizes,
+                          int component,
+                          int row)
+{
+    return (char*)chunk + chunk->archetype->offsets[component] +
+           row * sizes[component];
+}
+
+/* Take a zeroed row from the last chunk of an archetype */
+static struct entity_chunk* alloc_row(struct world* world,
+                                      struct archetype* archetype,
+                                      int* row)
+{
+    struct entity_chunk* chunk = NULL;
+    struct entity_chunk** chunks;
+    int i, c, capacity;
+
+    if (archetype->n_chunks > 0)
+        chunk = archetype->chunks[archetype->n_chunks - 1];
+    if (chunk == NULL || chunk->count == archetype->chunk_capacity) {
+        if (archetype->n_chunks == archetype->chunks_capacity) {
+            capacity = archetype->chunks_capacity * 2;
+            if (capacity == 0) capacity = 4;
+            chunks = (struct entity_chunk**)REALLOC(
+            archetype->chunks, capacity * sizeof(struct entity_chunk*),
+            MEMORY_ENTITIES);
+            if (chunks == NULL) goto error;
+            archetype->chunks = chunks;
+            archetype->chunks_capacity = capacity;
+        }
+        chunk = (struct entity_chunk*)MALLOC(
+        archetype->chunk_bytes, MEMORY_ENTITIES);
+        if (chunk == NULL) goto error;
+        chunk->archetype = archetype;
+        chunk->count = 0;
+        chunk->entities = (int*)((char*)chunk + archetype->entities_offset);
+        archetype->chunks[archetype->n_chunks++] = chunk;
+    }
+    *row = chunk->count++;
+    for (i = 0; i < archetype->n_components; i++) {
+        c = archetype->components[i];
+        memset(component_at(chunk, world->sizes, c, *row), 0,
+               world->sizes[c]);
+    }
+    return chunk;
+
+error:
+    ERROR("Unable to allocate an entity chunk");
+    return NULL;
+}
+
+/* Fill a row with the last row of the archetype, keeping chunks dense */
+static void free_row(struct world* world, struct entity_chunk* chunk, int row)
+{
+    struct archetype* archetype = chunk->archetype;
+    struct entity_chunk* last = archetype->chunks[archetype->n_chunks - 1];
+    int last_row = last->count - 1;
+    int i, c, moved;
+
+    if (last != chunk || last_row != row) {
+        for (i = 0; i < archetype->n_components; i++) {
+            c = archetype->components[i];
+            memcpy(component_at(chunk, world->sizes, c, row),
+                   component_at(last, world->sizes, c, last_row),
+                   world->sizes[c]);
+        }
+        moved = last->entities[last_row];
+        chunk->entities[row] = moved;
+        world->records[moved & INDEX_MASK].chunk = chunk;
+        world->records[moved & INDEX_MASK].row = row;
+    }
+    if (--last->count == 0) {
+        FREE(last);
+        archetype->n_chunks--;
+    }
+}
+
+static struct entity_record* find_record(struct world* world, int entity)
+{
+    struct entity_record* record;
+    int index = entity & INDEX_MASK;
+    if (entity < 0 || index >= world->n_records) return NULL;
+    record = &world->records[index];
+    if (record->chunk == NULL ||
+        record->generation != (entity >> INDEX_BITS))
+        return NULL;
+    return record;
+}
+
+struct world* create_world(void)
+{
+    struct world* world = (struct world*)CALLOC(
+    1, sizeof(struct world), MEMORY_ENTITIES);
+    if (world == NULL) goto error;
+    register_component(world, sizeof(vec));
+    register_component(world, sizeof(struct sprite*));
+    register_component(world, sizeof(bbox));
+    world->bbox_query =
+    create_query(world,
+                 COMPONENT(POSITION_COMPONENT) | COMPONENT(BBOX_COMPONENT), 0);
+    if (world->bbox_query == NULL) goto destroy;
+    world->sprite_query = create_query(
+    world, COMPONENT(POSITION_COMPONENT) | COMPONENT(SPRITE_COMPONENT), 0);
+    if (world->sprite_query == NULL) goto destroy;
+    return world;
+
+destroy:
+    destroy_world(world);
+error:
+    ERROR("Unable to create world");
+    return NULL;
+}
+
+void destroy_world(struct world* world)
+{
+    int i;
+    if (world->bbox_query != NULL) destroy_query(world->bbox_query);
+    if (world->sprite_query != NULL) destroy_query(world->sprite_query);
+    for (i = 0; i < world->n_archetypes; i++)
+        destroy_archetype(world->archetypes[i]);
+    FREE(world->archetypes);
+    FREE(world->records);
+    FREE(world->free_records);
+    FREE(world);
+}
+
+int register_component(struct world* world, size_t size)
+{
+    if (world->n_components == MAX_COMPONENTS) {
+        ERROR("Too many component types");
+        return -1;
+    }
+    world->sizes[world->n_components] = size;
+    return world->n_components++;
+}
+
+static int take_record(struct world* world)
+{
+    struct entity_record* records;
+    int* free_records;
+    int capacity;
+
+    if (world->n_free > 0) return world->free_records[--world->n_free];
+    if (world->n_records > INDEX_MASK) {
+        ERROR("Too many entities");
+        return -1;
+    }
+    if (world->n_records == world->records_capacity) {
+        capacity = world->records_capacity * 2;
+        if (capacity == 0) capacity = 256;
+        records = (struct entity_record*)REALLOC(
+        world->records, capacity * sizeof(struct entity_record),
+        MEMORY_ENTITIES);
+        if (records == NULL) goto error;
+        world->records = records;
+        /* a free stack as large as the records never overflows */
+        free_records =
+        (int*)REALLOC(
+        world->free_records, capacity * sizeof(int), MEMORY_ENTITIES);
+        if (free_records == NULL) goto error;
+        world->free_records = free_records;
+        world->records_capacity = capacity;
+    }
+    world->records[world->n_records].chunk = NULL;
+    world->records[world->n_records].generation = 0;
+    return world->n_records++;
+
+error:
+    ERROR("Unable to allocate entity records");
+    return -1;
+}
+
+int create_entity(struct world* world, uint64_t mask)
+{
+    struct archetype* archetype;
+    struct entity_record* record;
+    int index, entity;
+
+    archetype = find_archetype(world, mask);
+    if (archetype == NULL) return -1;
+    index = take_record(world);
+    if (index == -1) return -1;
+    record = &world->records[index];
+    record->chunk = alloc_row(world, archetype, &record->row);
+    if (record->chunk == NULL) {
+        world->free_records[world->n_free++] = index;
+        return -1;
+    }
+    entity = index | (record->generation << INDEX_BITS);
+    record->chunk->entities[record->row] = entity;
+    world->count++;
+    return entity;
+}
+
+void destroy_entity(struct world* world, int entity)
+{
+    struct entity_record* record = find_record(world, entity);
+    if (record == NULL) return;
+    free_row(world, record->chunk, record->row);
+    record->chunk = NULL;
+    record->generation = (record->generation + 1) & GENERATION_MASK;
+    world->free_records[world->n_free++] = entity & INDEX_MASK;
+    world->count--;
+}
+
+bool is_entity_alive(struct world* world, int entity)
+{
+    return find_record(world, entity) != NULL;
+}
+
+void* get_component(struct world* world, int entity, int component)
+{
+    struct entity_record* record = find_record(world, entity);
+    if (record == NULL || component < 0 || component >= MAX_COMPONENTS ||
+        record->chunk->archetype->offsets[component] == -1)
+        return NULL;
+    return component_at(record->chunk, world->sizes, component, record->row);
+}
+
+/* Move an entity to the archetype of another component mask */
+static int move_entity(struct world* world, int entity, uint64_t mask)
+{
+    struct entity_record* record = find_record(world, entity);
+    struct archetype *from, *to;
+    struct entity_chunk* chunk;
+    int row, i, c;
+
+    if (record == NULL) return -1;
+    from = record->chunk->archetype;
+    if (from->mask == mask) return 0;
+    to = find_archetype(world, mask);
+    if (to == NULL) return -1;
+    chunk = alloc_row(world, to, &row);
+    if (chunk == NULL) return -1;
+    for (i = 0; i < to->n_components; i++) {
+        c = to->components[i];
+        if (from->offsets[c] != -1)
+            memcpy(component_at(chunk, world->sizes, c, row),
+                   component_at(record->chunk, world->sizes, c, record->row),
+                   world->sizes[c]);
+    }
+    chunk->entities[row] = entity;
+    free_row(world, record->chunk, record->row);
+    record->chunk = chunk;
+    record->row = row;
+    return 0;
+}
+
+int add_component(struct world* world, int entity, int component)
+{
+    struct entity_record* record = find_record(world, entity);
+    if (record == NULL || component < 0 || component >= MAX_COMPONENTS)
+        return -1;
+    return move_entity(world, entity,
+                       record->chunk->archetype->mask | COMPONENT(component));
+}
+
+int remove_component(struct world* world, int entity, int component)
+{
+    struct entity_record* record = find_record(world, entity);
+    if (record == NULL || component < 0 || component >= MAX_COMPONENTS)
+        return -1;
+    return move_entity(world, entity,
+                       record->chunk->archetype->mask & ~COMPONENT(component));
+}
+
+struct entity_query* create_query(struct world* world,
+                                  uint64_t all,
+                                  uint64_t none)
+{
+    struct entity_query* query;
+    query = (struct entity_query*)CALLOC(
+    1, sizeof(struct entity_query), MEMORY_ENTITIES);
+    if (query == NULL) {
+        ERROR("Unable to allocate query");
+        return NULL;
+    }
+    query->world = world;
+    query->all = all;
+    query->none = none;
+    return query;
+}
+
+void destroy_query(struct entity_query* query)
+{
+    FREE(query->archetypes);
+    FREE(query->chunks);
+    FREE(query);
+}
+
+/* Add the matching archetypes created since the last refresh */
+static int refresh_query(struct entity_query* query)
+{
+    struct world* world = query->world;
+    struct archetype** archetypes;
+    struct archetype* archetype;
+    int capacity;
+
+    for (; query->n_checked < world->n_archetypes; query->n_checked++) {
+        archetype = world->archetypes[query->n_checked];
+        if ((archetype->mask & query->all) != query->all ||
+            (archetype->mask & query->none) != 0)
+            continue;
+        if (query->n_archetypes == query->archetypes_capacity) {
+            capacity = query->archetypes_capacity * 2;
+            if (capacity == 0) capacity = 8;
+            archetypes = (struct archetype**)REALLOC(
+            query->archetypes, capacity * sizeof(struct archetype*),
+            MEMORY_ENTITIES);
+            if (archetypes == NULL) {
+                ERROR("Unable to allocate query archetypes");
+                return -1;
+            }
+            query->archetypes = archetypes;
+            query->archetypes_capacity = capacity;
+        }
+        query->archetypes[query->n_archetypes++] = archetype;
+    }
+    return 0;
+}
+
+int count_query_entities(struct entity_query* query)
+{
+    struct archetype* archetype;
+    int i, j, count = 0;
+    refresh_query(query);
+    for (i = 0; i < query->n_archetypes; i++) {
+        archetype = query->archetypes[i];
+        for (j = 0; j < archetype->n_chunks; j++)
+            count += archetype->chunks[j]->count;
+    }
+    return count;
+}
+
+void* get_chunk_components(struct entity_chunk* chunk, int component)
+{
+    if (component < 0 || component >= MAX_COMPONENTS ||
+        chunk->archetype->offsets[component] == -1)
+        return NULL;
+    return (char*)chunk + chunk->archetype->offsets[component];
+}
+
+void run_system(struct entity_query* query, system_func_t func, void* data)
+{
+    struct archetype* archetype;
+    int i, j;
+    refresh_query(query);
+    for (i = 0; i < query->n_archetypes; i++) {
+        archetype = query->archetypes[i];
+        for (j = 0; j < archetype->n_chunks; j++)
+            func(archetype->chunks[j], data);
+    }
+}
+
+struct system_run {
+    struct entity_chunk** chunks;
+    system_func_t func;
+    void* data;
+};
+
+static void run_chunks(void* data, int begin, int end)
+{
+    struct system_run* run = (struct system_run*)data;
+    int i;
+    for (i = begin; i < end; i++) run->func(run->chunks[i], run->data);
+}
+
+void run_system_parallel(struct entity_query* query,
+                         system_func_t func,
+                         void* data)
+{
+    struct archetype* archetype;
+    struct entity_chunk** chunks;
+    struct system_run run;
+    int i, j, n = 0;
+
+    refresh_query(query);
+    for (i = 0; i < query->n_archetypes; i++)
+        n += query->archetypes[i]->n_chunks;
+    if (n > query->chunks_capacity) {
+        chunks = (struct entity_chunk**)REALLOC(
+        query->chunks, n * 2 * sizeof(struct entity_chunk*), MEMORY_ENTITIES);
+        if (chunks == NULL) {
+            /* still correct, only slower */
+            run_system(query, func, data);
+            return;
+        }
+        query->chunks = chunks;
+        query->chunks_capacity = n * 2;
+    }
+    n = 0;
+    for (i = 0; i < query->n_archetypes; i++) {
+        archetype = query->archetypes[i];
+        for (j = 0; j < archetype->n_chunks; j++)
+            query->chunks[n++] = archetype->chunks[j];
+    }
+    run.chunks = query->chunks;
+    run.func = func;
+    run.data = data;
+    parallel_for(n, 1, run_chunks, &run);
+}
+
+static void move_bboxes(struct entity_chunk* chunk, void* data)
+{
+    vec* positions = (vec*)get_chunk_components(chunk, POSITION_COMPONENT);
+    bbox* bboxes = (bbox*)get_chunk_components(chunk, BBOX_COMPONENT);
+    int i;
+    UNUSED(data);
+    for (i = 0; i < chunk->count; i++)
+        bboxes[i] = translate_bbox(bboxes[i], positions[i]);
+}
+
+void update_entity_bboxes(struct world* world)
+{
+    run_system_parallel(world->bbox_query, move_bboxes, NULL);
+}
+
+static void draw_sprites(struct entity_chunk* chunk, void* data)
+{
+    vec* positions = (vec*)get_chunk_components(chunk, POSITION_COMPONENT);
+    struct sprite** sprites =
+    (struct sprite**)get_chunk_components(chunk, SPRITE_COMPONENT);
+    int i;
+    UNUSED(data);
+    for (i = 0; i < chunk->count; i++)
+        if (sprites[i] != NULL)
+            draw_sprite(sprites[i], (int)positions[i].x, (int)positions[i].y);
+}
+
+void draw_entity_sprites(struct world* world)
+{
+    run_system(world->sprite_query, draw_sprites, NULL);
+}
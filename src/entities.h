@@ -0,0 +1,303 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#ifndef ENTITIES_H_W8PD3KZE
+#define ENTITIES_H_W8PD3KZE
+
+#include <stddef.h>
+#include <stdint.h>
+#include "types.h"
+#include "geometry.h"
+#include "sprite.h"
+
+#include "begin_prefix.h"
+/** Maximum number of component types in a world */
+#define MAX_COMPONENTS 64
+/** Size in bytes of a chunk of entities */
+#define ENTITY_CHUNK_SIZE 16384
+/** Component mask bit of a component type, see create_entity() */
+#define COMPONENT(id) ((uint64_t)1 << (id))
+
+/**
+ * Component types every world registers. Position components hold a
+ * vec, sprite components a struct sprite pointer, and bbox components
+ * a bbox.
+ */
+enum builtin_component {
+    POSITION_COMPONENT,
+    SPRITE_COMPONENT,
+    BBOX_COMPONENT
+};
+
+/**
+ * A chunk holds up to ENTITY_CHUNK_SIZE bytes worth of entities that
+ * have exactly the same component types, one array per component
+ * type. Systems receive chunks and walk the arrays from start to end:
+ *
+ *     static void move(struct entity_chunk* chunk, void* data)
+ *     {
+ *         vec* position = get_chunk_components(chunk, POSITION_COMPONENT);
+ *         vec* velocity = get_chunk_components(chunk, VELOCITY);
+ *         int i;
+ *         for (i = 0; i < chunk->count; i++)
+ *             position[i] = add_vec(position[i], velocity[i]);
+ *     }
+ */
+struct entity_chunk {
+    /* the archetype, the set of component types, of the chunk */
+    struct archetype* archetype;
+    /** number of entities in the chunk */
+    int count;
+    /** entity handles, in the order of the component arrays */
+    int* entities;
+};
+
+/**
+ * Entities are handles to a set of components living in a world.
+ * Create a world, register your own component types and create
+ * entities using a mask of their component types:
+ *
+ *     struct world* world = create_world();
+ *     int VELOCITY = register_component(world, sizeof(vec));
+ *     int star = create_entity(world, COMPONENT(POSITION_COMPONENT) |
+ *                                     COMPONENT(VELOCITY));
+ *     *(vec*)get_component(world, star, VELOCITY) = xy_vec(1, 1);
+ *
+ * Entities sharing the same component types are packed together in
+ * chunks. Systems run on the chunks matching a \ref entity_query,
+ * see run_system().
+ *
+ * Entity handles stay valid until the entity is destroyed, and
+ * is_entity_alive() tells stale handles apart.
+ */
+struct world {
+    /* component sizes, by type */
+    size_t sizes[MAX_COMPONENTS];
+    int n_components;
+    /* archetypes, created on demand and kept until the world is gone */
+    struct archetype** archetypes;
+    int n_archetypes;
+    int archetypes_capacity;
+    /* entity handle index to chunk and row */
+    struct entity_record* records;
+    int n_records;
+    int records_capacity;
+    /* unused record indices */
+    int* free_records;
+    int n_free;
+    /** number of live entities */
+    int count;
+    /* queries of the built-in systems */
+    struct entity_query* bbox_query;
+    struct entity_query* sprite_query;
+};
+
+/**
+ * Queries match the entities having all of a set of component types
+ * and none of another set. The matching archetypes are cached, and
+ * only archetypes created since the last run are checked again.
+ */
+struct entity_query {
+    /** world to query */
+    struct world* world;
+    /** components an entity must have */
+    uint64_t all;
+    /** components an entity must not have */
+    uint64_t none;
+    /* cached matching archetypes */
+    struct archetype** archetypes;
+    int n_archetypes;
+    int archetypes_capacity;
+    /* number of world archetypes checked so far */
+    int n_checked;
+    /* chunk list handed to run_system_parallel() */
+    struct entity_chunk** chunks;
+    int chunks_capacity;
+};
+
+/**
+ * This is the prototype of a system function. It is called with each
+ * chunk of entities matching a query.
+ */
+typedef void (*system_func_t)(struct entity_chunk* chunk, void* data);
+
+/**
+ * Create an empty world with the built-in components registered
+ *
+ * @return a new world or NULL on error
+ */
+struct world* create_world(void);
+
+/**
+ * Destroy a world created using create_world(), and all its entities.
+ * Sprites referenced by sprite components are not destroyed.
+ * @param world world to destroy
+ */
+void destroy_world(struct world* world);
+
+/**
+ * Register a component type
+ * @param world world to register the component in
+ * @param size component size in bytes
+ *
+ * @return the component type id or -1 when MAX_COMPONENTS are already
+ * registered
+ */
+int register_component(struct world* world, size_t size);
+
+/**
+ * Create an entity with zeroed components
+ * @param world world to create the entity in
+ * @param mask component types of the entity, COMPONENT() bits or-ed
+ * together
+ *
+ * @return the new entity handle or -1 on error
+ */
+int create_entity(struct world* world, uint64_t mask);
+
+/**
+ * Destroy an entity
+ * @param world world holding the entity
+ * @param entity entity handle
+ */
+void destroy_entity(struct world* world, int entity);
+
+/**
+ * Check if an entity handle refers to a live entity
+ * @param world world holding the entity
+ * @param entity entity handle
+ *
+ * @return true unless the entity was destroyed
+ */
+bool is_entity_alive(struct world* world, int entity);
+
+/**
+ * Get an entity component
+ * @param world world holding the entity
+ * @param entity entity handle
+ * @param component component type
+ *
+ * @return pointer to the component, valid until entities are created,
+ * destroyed or change their component types, or NULL when the entity
+ * has no such component
+ */
+void* get_component(struct world* world, int entity, int component);
+
+/**
+ * Add a zeroed component to an entity
+ * @param world world holding the entity
+ * @param entity entity handle
+ * @param component component type to add
+ *
+ * @return 0 on success or -1 on error
+ */
+int add_component(struct world* world, int entity, int component);
+
+/**
+ * Remove a component from an entity
+ * @param world world holding the entity
+ * @param entity entity handle
+ * @param component component type to remove
+ *
+ * @return 0 on success or -1 on error
+ */
+int remove_component(struct world* world, int entity, int component);
+
+/**
+ * Create a query
+ * @param world world to query
+ * @param all components an entity must have, COMPONENT() bits or-ed
+ * together
+ * @param none components an entity must not have
+ *
+ * @return a new query or NULL on error
+ */
+struct entity_query* create_query(struct world* world,
+                                  uint64_t all,
+                                  uint64_t none);
+
+/**
+ * Destroy a query created using create_query()
+ * @param query query to destroy
+ */
+void destroy_query(struct entity_query* query);
+
+/**
+ * Count the entities matching a query
+ * @param query query to count
+ *
+ * @return number of matching entities
+ */
+int count_query_entities(struct entity_query* query);
+
+/**
+ * Get the component array of a chunk
+ * @param chunk chunk passed to a system
+ * @param component component type
+ *
+ * @return the chunk array of the component type, or NULL when the
+ * chunk entities do not have it
+ */
+void* get_chunk_components(struct entity_chunk* chunk, int component);
+
+/**
+ * Run a system on the chunks matching a query
+ * @param query query selecting the entities
+ * @param func system function
+ * @param data data passed to the system function
+ *
+ * Systems must not create or destroy entities, nor add or remove
+ * components. Collect the changes and apply them once the system is
+ * done.
+ */
+void run_system(struct entity_query* query, system_func_t func, void* data);
+
+/**
+ * Run a system on the chunks matching a query, on all the job workers
+ * @param query query selecting the entities
+ * @param func system function, called from several threads at once
+ * @param data data passed to the system function
+ *
+ * Every chunk is passed to a single call, so a system may write to the
+ * chunk components without locking. Systems running in parallel must
+ * not draw.
+ */
+void run_system_parallel(struct entity_query* query,
+                         system_func_t func,
+                         void* data);
+
+/**
+ * Move entities having a bbox component and a position component so
+ * the bbox top-left corner is at the position
+ * @param world world holding the entities
+ */
+void update_entity_bboxes(struct world* world);
+
+/**
+ * Draw entities having a sprite component and a position component
+ * @param world world holding the entities
+ *
+ * Entities whose sprite is NULL are skipped.
+ */
+void draw_entity_sprites(struct world* world);
+
+#include "end_prefix.h"
+#endif /* end of include guard: ENTITIES_H_W8PD3KZE */
@@ -20,25 +20,70 @@
  *    distribution.
  */
 #include "file.h"
+#include "internals.h"
+#include "utils.h"
+#include <stdio.h>
+#include <string.h>
 #include "SDL.h"
 
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#define FILE_MMAP
+#define FILE_POSIX
+#endif
+
 #define MAX_PATH_LEN 1024
+#define MAX_NAME_LEN 256
 
 #include "begin_prefix.h"
-static void make_game_path(char* full_path, struct file_spec file_spec)
+/* SDL_GetPrefPath() allocates and creates the folder on every call,
+ * so the path is kept for the last company and game asked for */
+static struct {
+    char company[MAX_NAME_LEN];
+    char game[MAX_NAME_LEN];
+    char path[MAX_PATH_LEN + 1];
+} pref_path;
+
+static int make_game_path(char* full_path, struct file_spec file_spec)
 {
-    char* perf_path = SDL_GetPrefPath(file_spec.company, file_spec.game);
-    strncat(full_path, perf_path, MAX_PATH_LEN);
-    strncat(full_path, "/", MAX_PATH_LEN);
-    strncat(full_path, file_spec.filename, MAX_PATH_LEN);
-    SDL_free(perf_path);
+    char* path;
+    if (pref_path.path[0] == '\0' ||
+        strcmp(pref_path.company, file_spec.company) != 0 ||
+        strcmp(pref_path.game, file_spec.game) != 0) {
+        pref_path.path[0] = '\0';
+        if (strlen(file_spec.company) >= MAX_NAME_LEN ||
+            strlen(file_spec.game) >= MAX_NAME_LEN)
+            return -1;
+        path = SDL_GetPrefPath(file_spec.company, file_spec.game);
+        if (path == NULL) return -1;
+        if (strlen(path) <= MAX_PATH_LEN) {
+            strcpy(pref_path.company, file_spec.company);
+            strcpy(pref_path.game, file_spec.game);
+            strcpy(pref_path.path, path);
+        }
+        SDL_free(path);
+        if (pref_path.path[0] == '\0') return -1;
+    }
+    /* the pref path ends with a path separator */
+    if (strlen(pref_path.path) + strlen(file_spec.filename) > MAX_PATH_LEN)
+        return -1;
+    strcpy(full_path, pref_path.path);
+    strcat(full_path, file_spec.filename);
+    return 0;
 }
 
 bool is_file_exists(struct file_spec file_spec)
 {
-    char full_path[MAX_PATH_LEN + 1] = "";
-    make_game_path(full_path, file_spec);
-    SDL_RWops* rw = SDL_RWFromFile(full_path, "r");
+    char full_path[MAX_PATH_LEN + 1];
+    SDL_RWops* rw;
+    if (make_game_path(full_path, file_spec) == -1) return false;
+    rw = SDL_RWFromFile(full_path, "rb");
     if (rw == NULL) return false;
     SDL_RWclose(rw);
     return true;
@@ -46,45 +91,372 @@ bool is_file_exists(struct file_spec file_spec)
 
 int read_file(char** buf, struct file_spec file_spec)
 {
-    char full_path[MAX_PATH_LEN + 1] = "";
-    make_game_path(full_path, file_spec);
-    SDL_RWops* rw = SDL_RWFromFile(full_path, "r");
+    char full_path[MAX_PATH_LEN + 1];
+    SDL_RWops* rw;
+    Sint64 size;
+    if (make_game_path(full_path, file_spec) == -1) return -1;
+    rw = SDL_RWFromFile(full_path, "rb");
     if (rw == NULL) return -1;
 
-    Sint64 res_size = SDL_RWsize(rw);
-    *buf = (char*)malloc(res_size + 1);
-
-    Sint64 nb_read_total = 0, nb_read = 1;
-    char* buf_ = *buf;
-    while (nb_read_total < res_size && nb_read != 0) {
-        nb_read = SDL_RWread(rw, buf_, 1, (res_size - nb_read_total));
-        nb_read_total += nb_read;
-        buf_ += nb_read;
+    size = SDL_RWsize(rw);
+    *buf = size < 0 || size > 0x7FFFFFFE ? NULL
+                                         : (char*)malloc((size_t)size + 1);
+    if (*buf != NULL && size > 0 &&
+        SDL_RWread(rw, *buf, (size_t)size, 1) != 1) {
+        free(*buf);
+        *buf = NULL;
     }
     SDL_RWclose(rw);
-    if (nb_read_total != res_size) {
-        free(*buf);
+    if (*buf == NULL) return -1;
+    (*buf)[size] = '\0';
+    return (int)size;
+}
+
+/* ----------------------------------------------------------------
+ * Mapped files
+ * ---------------------------------------------------------------- */
+
+int map_file_memory(const char* path, void** memory, size_t* size)
+{
+#if defined(FILE_MMAP)
+    struct stat st;
+    void* view;
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return -1;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return -1;
+    }
+    view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (view == MAP_FAILED) return -1;
+    *memory = view;
+    *size = (size_t)st.st_size;
+    return 0;
+#elif defined(_WIN32)
+    LARGE_INTEGER file_size;
+    HANDLE mapping;
+    void* view;
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return -1;
+    if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file);
         return -1;
     }
+    /* the view keeps the mapping and the file open */
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL) return -1;
+    view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == NULL) return -1;
+    *memory = view;
+    *size = (size_t)file_size.QuadPart;
+    return 0;
+#else
+    return -1;
+#endif
+}
 
-    *buf[nb_read_total] = '\0';
-    return nb_read_total;
+void unmap_file_memory(void* memory, size_t size)
+{
+#if defined(FILE_MMAP)
+    munmap(memory, size);
+#elif defined(_WIN32)
+    UnmapViewOfFile(memory);
+#endif
 }
 
-int write_file(struct file_spec file_spec, const char* buf)
+int map_file(struct file_view* view, struct file_spec file_spec)
 {
-    char full_path[MAX_PATH_LEN + 1] = "";
-    make_game_path(full_path, file_spec);
-    SDL_RWops* rw = SDL_RWFromFile(full_path, "w");
-    if (rw != NULL) {
-        size_t len = SDL_strlen(buf);
-        if (SDL_RWwrite(rw, buf, 1, len) != len) {
-            SDL_RWclose(rw);
-            return -1;
+    char full_path[MAX_PATH_LEN + 1];
+    char* buf;
+    void* memory;
+    int size;
+    view->data = NULL;
+    view->size = 0;
+    view->mapped = 0;
+    if (make_game_path(full_path, file_spec) == -1) return -1;
+    if (map_file_memory(full_path, &memory, &view->size) == 0) {
+        view->data = (const char*)memory;
+        view->mapped = 1;
+        return 0;
+    }
+    /* empty files, and platforms without mappings, are read */
+    if ((size = read_file(&buf, file_spec)) == -1) return -1;
+    view->data = buf;
+    view->size = (size_t)size;
+    return 0;
+}
+
+void unmap_file(struct file_view* view)
+{
+    if (view->data == NULL) return;
+    if (view->mapped)
+        unmap_file_memory((void*)view->data, view->size);
+    else
+        free((void*)view->data);
+    view->data = NULL;
+    view->size = 0;
+}
+
+/* ----------------------------------------------------------------
+ * Atomic and asynchronous writes
+ * ---------------------------------------------------------------- */
+
+static int replace_file(const char* from, const char* to)
+{
+#if defined(_WIN32)
+    return MoveFileExA(from, to,
+                       MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)
+           ? 0
+           : -1;
+#else
+    return rename(from, to) == 0 ? 0 : -1;
+#endif
+}
+
+/* Write a whole file and flush it to disk, so the rename that follows
+ * can not reach the disk before the data does */
+static int write_synced(const char* path, const char* buf, size_t size)
+{
+#if defined(_WIN32)
+    DWORD written;
+    int ok;
+    HANDLE file = CreateFileA(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                              FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) return -1;
+    ok = size == 0 || (WriteFile(file, buf, (DWORD)size, &written, NULL) &&
+                       written == size);
+    if (!FlushFileBuffers(file)) ok = 0;
+    if (!CloseHandle(file)) ok = 0;
+    return ok ? 0 : -1;
+#elif defined(FILE_POSIX)
+    size_t done = 0;
+    ssize_t n;
+    int ok = 1;
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) return -1;
+    while (done < size) {
+        n = write(fd, buf + done, size - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            ok = 0;
+            break;
         }
-        SDL_RWclose(rw);
-        return len;
-    } else
+        done += (size_t)n;
+    }
+    if (fsync(fd) != 0) ok = 0;
+    if (close(fd) != 0) ok = 0;
+    return ok ? 0 : -1;
+#else
+    SDL_RWops* rw = SDL_RWFromFile(path, "wb");
+    int ok;
+    if (rw == NULL) return -1;
+    ok = size == 0 || SDL_RWwrite(rw, buf, size, 1) == 1;
+    if (SDL_RWclose(rw) != 0) ok = 0;
+    return ok ? 0 : -1;
+#endif
+}
+
+/* Write to a temporary file next to the file and rename it over the
+ * file, so the file holds either the old or the new content */
+static int write_atomically(const char* path, const char* buf, size_t size)
+{
+    char tmp_path[MAX_PATH_LEN + 5];
+    strcpy(tmp_path, path);
+    strcat(tmp_path, ".tmp");
+    if (write_synced(tmp_path, buf, size) == -1 ||
+        replace_file(tmp_path, path) == -1) {
+        remove(tmp_path);
         return -1;
+    }
+    return (int)size;
+}
+
+int write_file(struct file_spec file_spec, const char* buf)
+{
+    return write_file_data(file_spec, buf, strlen(buf));
+}
+
+int write_file_data(struct file_spec file_spec, const void* buf, size_t size)
+{
+    char full_path[MAX_PATH_LEN + 1];
+    if (size > 0x7FFFFFFF || make_game_path(full_path, file_spec) == -1)
+        return -1;
+    return write_atomically(full_path, (const char*)buf, size);
+}
+
+struct file_write {
+    char path[MAX_PATH_LEN + 1];
+    char* buf;
+    size_t size;
+    int result;
+    write_func_t callback;
+    void* userdata;
+    struct file_write* next;
+};
+
+/* Writes queued for the writer thread, and writes done waiting for
+ * their callbacks, oldest first */
+static struct {
+    SDL_Thread* thread;
+    SDL_mutex* mutex;
+    SDL_cond* wake;
+    SDL_cond* written;
+    struct file_write* pending;
+    struct file_write* pending_tail;
+    struct file_write* done;
+    struct file_write* done_tail;
+    int busy;
+    int quit;
+} writer;
+
+static int writer_main(void* data)
+{
+    struct file_write* w;
+    UNUSED(data);
+    SDL_LockMutex(writer.mutex);
+    for (;;) {
+        while (writer.pending == NULL && !writer.quit)
+            SDL_CondWait(writer.wake, writer.mutex);
+        if (writer.pending == NULL) break;
+        w = writer.pending;
+        writer.pending = w->next;
+        if (writer.pending == NULL) writer.pending_tail = NULL;
+        SDL_UnlockMutex(writer.mutex);
+
+        w->result = write_atomically(w->path, w->buf, w->size);
+
+        SDL_LockMutex(writer.mutex);
+        w->next = NULL;
+        if (writer.done_tail != NULL)
+            writer.done_tail->next = w;
+        else
+            writer.done = w;
+        writer.done_tail = w;
+        writer.busy--;
+        SDL_CondBroadcast(writer.written);
+    }
+    SDL_UnlockMutex(writer.mutex);
+    return 0;
+}
+
+static int start_writer(void)
+{
+    if (writer.thread != NULL) return 0;
+    writer.mutex = SDL_CreateMutex();
+    if (writer.mutex == NULL) goto error;
+    writer.wake = SDL_CreateCond();
+    if (writer.wake == NULL) goto free_mutex;
+    writer.written = SDL_CreateCond();
+    if (writer.written == NULL) goto free_wake;
+    writer.quit = 0;
+    writer.thread = SDL_CreateThread(writer_main, "cage writer", NULL);
+    if (writer.thread == NULL) goto free_written;
+    return 0;
+
+free_written:
+    SDL_DestroyCond(writer.written);
+free_wake:
+    SDL_DestroyCond(writer.wake);
+free_mutex:
+    SDL_DestroyMutex(writer.mutex);
+error:
+    ERROR("Unable to start the file writer thread");
+    return -1;
+}
+
+int write_file_async(struct file_spec file_spec,
+                     const char* buf,
+                     write_func_t callback,
+                     void* userdata)
+{
+    return write_file_data_async(file_spec, buf, strlen(buf), callback,
+                                 userdata);
+}
+
+int write_file_data_async(struct file_spec file_spec,
+                          const void* buf,
+                          size_t size,
+                          write_func_t callback,
+                          void* userdata)
+{
+    struct file_write* w = (struct file_write*)MALLOC(
+    sizeof(struct file_write), MEMORY_ENGINE);
+    if (w == NULL || size > 0x7FFFFFFF) {
+        FREE(w);
+        return -1;
+    }
+    w->buf = (char*)MALLOC(size + 1, MEMORY_ENGINE);
+    if (w->buf == NULL || make_game_path(w->path, file_spec) == -1 ||
+        start_writer() == -1) {
+        FREE(w->buf);
+        FREE(w);
+        return -1;
+    }
+    memcpy(w->buf, buf, size);
+    w->size = size;
+    w->result = -1;
+    w->callback = callback;
+    w->userdata = userdata;
+    w->next = NULL;
+    SDL_LockMutex(writer.mutex);
+    if (writer.pending_tail != NULL)
+        writer.pending_tail->next = w;
+    else
+        writer.pending = w;
+    writer.pending_tail = w;
+    writer.busy++;
+    SDL_CondSignal(writer.wake);
+    SDL_UnlockMutex(writer.mutex);
+    return 0;
+}
+
+/* Free the writes done, calling their callbacks when call is set */
+static void drain_file_writes(int call)
+{
+    struct file_write* w;
+    struct file_write* next;
+    SDL_LockMutex(writer.mutex);
+    w = writer.done;
+    writer.done = writer.done_tail = NULL;
+    SDL_UnlockMutex(writer.mutex);
+    for (; w != NULL; w = next) {
+        next = w->next;
+        if (call && w->callback != NULL) w->callback(w->result, w->userdata);
+        FREE(w->buf);
+        FREE(w);
+    }
+}
+
+void dispatch_file_writes(void)
+{
+    if (writer.thread != NULL) drain_file_writes(1);
+}
+
+void finish_file_writes(void)
+{
+    if (writer.thread == NULL) return;
+    SDL_LockMutex(writer.mutex);
+    while (writer.busy > 0) SDL_CondWait(writer.written, writer.mutex);
+    SDL_UnlockMutex(writer.mutex);
+    drain_file_writes(1);
+}
+
+void stop_file_writer(void)
+{
+    if (writer.thread == NULL) return;
+    SDL_LockMutex(writer.mutex);
+    writer.quit = 1;
+    SDL_CondSignal(writer.wake);
+    SDL_UnlockMutex(writer.mutex);
+    SDL_WaitThread(writer.thread, NULL);
+    writer.thread = NULL;
+    drain_file_writes(0);
+    SDL_DestroyCond(writer.written);
+    SDL_DestroyCond(writer.wake);
+    SDL_DestroyMutex(writer.mutex);
 }
 #include "end_prefix.h"
@@ -21,6 +21,7 @@
  */
 #ifndef FILE_H_KV23ASZC
 #define FILE_H_KV23ASZC
+#include <stddef.h>
 #include "types.h"
 #include "begin_prefix.h"
 /**
@@ -40,6 +41,25 @@ struct file_spec
     const char* filename;
 };
 
+/**
+ * A read-only view of a whole file, see map_file()
+ */
+struct file_view {
+    /** file content */
+    const char* data;
+    /** file size in bytes */
+    size_t size;
+    /* 1 when data maps the file, 0 when it was read into memory */
+    int mapped;
+};
+
+/**
+ * This is the prototype of a write_file_async() completion function.
+ * It is called with the number of bytes written, or -1 on error, and
+ * the user data passed to write_file_async().
+ */
+typedef void (*write_func_t)(int result, void* userdata);
+
 /**
  * Read the full file content and store in a new buffer. Buffer is allocated
  * by the read_file and must be freed by the caller.
@@ -52,8 +72,27 @@ struct file_spec
 int read_file(char** buf,
               struct file_spec file_spec);
 
+/**
+ * Map the full file content into memory, without reading or copying
+ * it, where the platform supports it. This suits big files, like
+ * saved levels, that are parsed once and thrown away.
+ * @param view \ref file_view to fill. Unmap it using unmap_file().
+ * @param file_spec the file specifier to use for reading.
+ *
+ * @return 0 on success or -1 on error.
+ */
+int map_file(struct file_view* view, struct file_spec file_spec);
+
+/**
+ * Unmap a file mapped using map_file()
+ * @param view the file view to unmap.
+ */
+void unmap_file(struct file_view* view);
+
 /**
  * Write the full content of buf to a file. File will be rewritten.
+ * The content is written to a temporary file, which then replaces the
+ * file, so a crash while writing leaves the previous content intact.
  * @param file_spec file specifier to use for writing.
  * @param buf buf with the content to write.
  *
@@ -62,6 +101,71 @@ int read_file(char** buf,
 int write_file(struct file_spec file_spec,
                const char* buf);
 
+/**
+ * Write binary data to a file, the same way write_file() writes text.
+ * @param file_spec file specifier to use for writing.
+ * @param buf data to write.
+ * @param size number of bytes to write.
+ *
+ * @return number of bytes written or -1 on error.
+ */
+int write_file_data(struct file_spec file_spec, const void* buf, size_t size);
+
+/**
+ * Write the full content of buf to a file on a background thread, so
+ * saving never stalls a frame. Writes are made in order, just like
+ * write_file() makes them:
+ *
+ *     static void saved(int result, void* userdata)
+ *     {
+ *         struct game* game = userdata;
+ *         game->saving = false;
+ *     }
+ *     ...
+ *     game->saving = true;
+ *     write_file_async(save_spec, state, saved, game);
+ *
+ * The game loop calls the completion functions on the main thread,
+ * after the update of the frame the write is done in.
+ * @param file_spec file specifier to use for writing.
+ * @param buf buf with the content to write. It is copied, so it can be
+ * freed once write_file_async() returns.
+ * @param callback function called once the write is done, or NULL.
+ * @param userdata data passed to callback.
+ *
+ * @return 0 if the write is queued or -1 on error.
+ */
+int write_file_async(struct file_spec file_spec,
+                     const char* buf,
+                     write_func_t callback,
+                     void* userdata);
+
+/**
+ * Write binary data to a file on a background thread, the same way
+ * write_file_async() writes text.
+ * @param file_spec file specifier to use for writing.
+ * @param buf data to write. It is copied, so it can be freed once
+ * write_file_data_async() returns.
+ * @param size number of bytes to write.
+ * @param callback function called once the write is done, or NULL.
+ * @param userdata data passed to callback.
+ *
+ * @return 0 if the write is queued or -1 on error.
+ */
+int write_file_data_async(struct file_spec file_spec,
+                          const void* buf,
+                          size_t size,
+                          write_func_t callback,
+                          void* userdata);
+
+/**
+ * Wait for all writes queued using write_file_async() and call their
+ * completion functions. The game loop calls it before destroying the
+ * game state when quitting. Writes queued after that are still made,
+ * but their completion functions are not called.
+ */
+void finish_file_writes(void);
+
 /**
  * Check is a file already exists.
  * @param file_spec file specifier to check.
@@ -27,6 +27,7 @@
 #include "SDL_image.h"
 #include "SDL_surface.h"
 
+#include "internals.h"
 #include "begin_prefix.h"
 /* -----------------------------------------------
  * Thanks to the Lazy Foo' Production tutorial at
@@ -151,9 +152,9 @@ int load_font(struct font* font, const char* filepath, int ncols, int nrows)
 
 struct font* create_font(const char* filepath, int cols, int rows)
 {
-    struct font* f = (struct font*)malloc(sizeof(*f));
+    struct font* f = (struct font*)MALLOC(sizeof(*f), MEMORY_FONTS);
     if (f != NULL && load_font(f, filepath, cols, rows) == -1) {
-        free(f);
+        FREE(f);
         return NULL;
     }
     return f;
@@ -168,7 +169,7 @@ void destroy_font(struct font* font)
 {
     if (font != NULL) {
         cleanup_font(font);
-        free(font);
+        FREE(font);
     }
 }
 
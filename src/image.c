@@ -23,14 +23,46 @@
 #include "screen.h"
 #include "utils.h"
 #include "internals.h"
+#include "pack.h"
+#include "types.h"
+#include <math.h>
 #include <memory.h>
 #include <stdlib.h>
+#include <string.h>
 #include "SDL.h"
 #include "SDL_image.h"
 #include "SDL_surface.h"
 
 #include "begin_prefix.h"
-int init_image_from_file(struct image* image, const char* filepath)
+/* Managed textures budget, and the least recently drawn list of
+ * resident managed images, most recent first */
+static struct {
+    struct texture_stats stats;
+    struct image* head;
+    struct image* tail;
+    unsigned long frame;
+} textures = { { 0, 0, 0, 0, 0, 0 }, NULL, NULL, 1 };
+
+/* RGBA8888 texture size, as the GPU driver keeps it */
+static size_t texture_bytes(struct image* image)
+{
+    return (size_t)image->width * image->height * 4;
+}
+
+static void init_image_state(struct image* image)
+{
+    image->alpha = 255;
+    image->blend_state = -1;
+    image->alpha_state = -1;
+    image->tint_state = -1;
+    image->source = NULL;
+    image->drawn_frame = 0;
+    image->lru_prev = NULL;
+    image->lru_next = NULL;
+}
+
+/* Create the image texture from a file, leaving the image state be */
+static int load_texture(struct image* image, const char* filepath)
 {
     int ret = -1;
     SDL_Surface* s = NULL;
@@ -42,7 +74,7 @@ int init_image_from_file(struct image* image, const char* filepath)
     uint32_t transparent;
     int i;
 
-    s = IMG_Load(filepath);
+    s = IMG_Load_RW(open_asset(filepath), 1);
     if (s == NULL) {
         ERROR("Unable to load image into an SDL surface");
         goto exit;
@@ -63,10 +95,12 @@ int init_image_from_file(struct image* image, const char* filepath)
 
     image->width = fs->w;
     image->height = fs->h;
+    TRACK_ASSET(image->impl, MEMORY_TEXTURES, filepath, texture_bytes(image));
 
-    SDL_SetTextureBlendMode(image->impl, SDL_BLENDMODE_BLEND);
-
-    lock_image(image, (void**)&pixels, &pitch);
+    if (SDL_LockTexture(image->impl, NULL, (void**)&pixels, &pitch) != 0) {
+        ERROR("Unable to lock the image texture");
+        goto free_fs;
+    }
     memcpy((void*)pixels, fs->pixels, fs->pitch * fs->h);
 
     npixels = (pitch / 4) * fs->h;
@@ -80,7 +114,7 @@ int init_image_from_file(struct image* image, const char* filepath)
         }
     }
 
-    unlock_image(image);
+    SDL_UnlockTexture(image->impl);
     ret = 0;
 
 free_fs:
@@ -91,9 +125,131 @@ exit:
     return ret;
 }
 
+int init_image_from_file(struct image* image, const char* filepath)
+{
+    if (load_texture(image, filepath) == -1) return -1;
+    init_image_state(image);
+    set_texture_blend_mode(image, SDL_BLENDMODE_BLEND);
+    return 0;
+}
+
+static void unlink_texture(struct image* image)
+{
+    if (image->lru_prev != NULL)
+        image->lru_prev->lru_next = image->lru_next;
+    else
+        textures.head = image->lru_next;
+    if (image->lru_next != NULL)
+        image->lru_next->lru_prev = image->lru_prev;
+    else
+        textures.tail = image->lru_prev;
+    image->lru_prev = NULL;
+    image->lru_next = NULL;
+}
+
+static void link_texture(struct image* image)
+{
+    image->lru_prev = NULL;
+    image->lru_next = textures.head;
+    if (textures.head != NULL) textures.head->lru_prev = image;
+    textures.head = image;
+    if (textures.tail == NULL) textures.tail = image;
+}
+
+static void evict_texture(struct image* image)
+{
+    unlink_texture(image);
+    UNTRACK_ASSET(image->impl, MEMORY_TEXTURES, texture_bytes(image));
+    SDL_DestroyTexture(image->impl);
+    image->impl = NULL;
+    textures.stats.resident_bytes -= texture_bytes(image);
+    textures.stats.resident_images--;
+    textures.stats.evictions++;
+}
+
+/* Evict the least recently drawn textures, but not the ones drawn in
+ * the current frame, until the budget is met */
+static void fit_texture_budget(void)
+{
+    struct image* image;
+    if (textures.stats.budget == 0) return;
+    while (textures.stats.resident_bytes > textures.stats.budget) {
+        image = textures.tail;
+        if (image == NULL || image->drawn_frame == textures.frame) break;
+        evict_texture(image);
+    }
+}
+
+static int reload_texture(struct image* image)
+{
+    Uint64 start = SDL_GetPerformanceCounter();
+    int blend = image->blend_state;
+
+    if (load_texture(image, image->source) == -1) {
+        ERROR("Unable to reload an evicted image");
+        return -1;
+    }
+    /* the new texture has the SDL defaults, only the blend mode is
+     * not set again by the draw functions */
+    image->blend_state = -1;
+    image->alpha_state = -1;
+    image->tint_state = -1;
+    if (blend != -1) set_texture_blend_mode(image, (SDL_BlendMode)blend);
+    textures.stats.resident_bytes += texture_bytes(image);
+    textures.stats.resident_images++;
+    textures.stats.reloads++;
+    textures.stats.reload_ms += (float)(SDL_GetPerformanceCounter() - start) *
+                                1000.0f / SDL_GetPerformanceFrequency();
+    link_texture(image);
+    return 0;
+}
+
+int use_image(struct image* image)
+{
+    if (image->source == NULL) return 0;
+    image->drawn_frame = textures.frame;
+    if (image->impl == NULL) {
+        if (reload_texture(image) == -1) return -1;
+        fit_texture_budget();
+    } else if (textures.head != image) {
+        unlink_texture(image);
+        link_texture(image);
+    }
+    return 0;
+}
+
+void next_texture_frame(void)
+{
+    textures.frame++;
+}
+
+void set_texture_budget(size_t bytes)
+{
+    textures.stats.budget = bytes;
+    fit_texture_budget();
+}
+
+void get_texture_stats(struct texture_stats* stats)
+{
+    *stats = textures.stats;
+}
+
 int cleanup_image(struct image* image)
 {
+    if (image->source != NULL) {
+        if (image->impl != NULL) {
+            unlink_texture(image);
+            textures.stats.resident_bytes -= texture_bytes(image);
+            textures.stats.resident_images--;
+        }
+        FREE(image->source);
+        image->source = NULL;
+    }
     if (image->impl != NULL) {
+        /* SDL would fall back to the window, which is not the screen
+         * when the scene target of dynamic resolution stands in for it */
+        if (screen->target == image) set_render_target(NULL);
+        UNTRACK_ASSET(image->impl, MEMORY_TEXTURES, texture_bytes(image));
         SDL_DestroyTexture(image->impl);
         image->impl = NULL;
     }
@@ -102,6 +258,7 @@ int cleanup_image(struct image* image)
 
 int lock_image(struct image* image, void** pixels, int* pitch)
 {
+    if (use_image(image) == -1) return -1;
     if (SDL_LockTexture(image->impl, NULL, pixels, pitch) != 0) return -1;
     return 0;
 }
@@ -112,16 +269,41 @@ int unlock_image(struct image* image)
     return 0;
 }
 
+/* Cull a quad rotated by angle around center, given relative to the
+ * quad top-left corner. */
+static int cull_render_quad(const SDL_Rect* quad,
+                            int center_x,
+                            int center_y,
+                            double angle)
+{
+    int dx, dy;
+    float radius;
+    if (angle == 0)
+        return cull_quad(quad->x, quad->y, quad->x + quad->w,
+                         quad->y + quad->h);
+    /* whatever the angle, the quad stays inside the circle that goes
+     * through its corner farthest from the center */
+    dx = center_x > quad->w - center_x ? center_x : quad->w - center_x;
+    dy = center_y > quad->h - center_y ? center_y : quad->h - center_y;
+    radius = (float)sqrt((double)dx * dx + (double)dy * dy);
+    return cull_quad(quad->x + center_x - radius, quad->y + center_y - radius,
+                     quad->x + center_x + radius, quad->y + center_y + radius);
+}
+
 void draw_image(struct image* image,
                 int x,
                 int y,
-                struct rectangle* clip,
+                const struct rectangle* clip,
                 double angle)
 {
     SDL_Rect render_quad;
     SDL_Rect sdl_clip;
     SDL_Rect* sdl_clip_ref = NULL;
 
+    if (use_image(image) == -1) return;
+    if (screen->queue != NULL && queue_draw_image(image, x, y, clip, angle))
+        return;
+
     x += screen->offset_x;
     y += screen->offset_y;
 
@@ -140,23 +322,143 @@ void draw_image(struct image* image,
         sdl_clip_ref = &sdl_clip;
     }
 
+    if (cull_render_quad(&render_quad, render_quad.w / 2, render_quad.h / 2,
+                         angle))
+        return;
+
+    set_texture_color_mod(image, 255, 255, 255);
+    set_texture_alpha_mod(image, image->alpha);
     SDL_RenderCopyEx(screen->impl, image->impl, sdl_clip_ref, &render_quad,
                      angle, NULL, SDL_FLIP_NONE);
 }
 
+struct draw_params default_draw_params(void)
+{
+    struct draw_params params;
+    params.flip = FLIP_NONE;
+    params.scale_x = 1.0f;
+    params.scale_y = 1.0f;
+    params.pivot_x = 0.5f;
+    params.pivot_y = 0.5f;
+    params.angle = 0.0;
+    params.color = color_from_RGBA(255, 255, 255, 255);
+    return params;
+}
+
+void render_image_ex(struct image* image,
+                     const struct rectangle* clip,
+                     float x,
+                     float y,
+                     float offset_x,
+                     float offset_y,
+                     float pivot_x,
+                     float pivot_y,
+                     const struct draw_params* params)
+{
+    SDL_Rect render_quad;
+    SDL_Rect sdl_clip;
+    SDL_Point center;
+    int flip = params->flip;
+    float scale_x = params->scale_x;
+    float scale_y = params->scale_y;
+    float left, top;
+
+    if (use_image(image) == -1) return;
+    if (screen->queue != NULL &&
+        queue_render_image_ex(image, clip, x, y, offset_x, offset_y, pivot_x,
+                              pivot_y, params))
+        return;
+
+    if (scale_x < 0) {
+        scale_x = -scale_x;
+        flip ^= FLIP_HORIZONTAL;
+    }
+    if (scale_y < 0) {
+        scale_y = -scale_y;
+        flip ^= FLIP_VERTICAL;
+    }
+
+    /* mirroring is done around the pivot, so a flipped clip area
+     * lands on the other side of it */
+    left = (flip & FLIP_HORIZONTAL) ? pivot_x - offset_x - clip->w
+                                    : offset_x - pivot_x;
+    top = (flip & FLIP_VERTICAL) ? pivot_y - offset_y - clip->h
+                                 : offset_y - pivot_y;
+    x += screen->offset_x + pivot_x;
+    y += screen->offset_y + pivot_y;
+
+    render_quad.x = (int)floor(x + left * scale_x + 0.5);
+    render_quad.y = (int)floor(y + top * scale_y + 0.5);
+    render_quad.w = (int)(clip->w * scale_x + 0.5f);
+    render_quad.h = (int)(clip->h * scale_y + 0.5f);
+    center.x = (int)floor(x - render_quad.x + 0.5);
+    center.y = (int)floor(y - render_quad.y + 0.5);
+    sdl_clip.x = clip->x;
+    sdl_clip.y = clip->y;
+    sdl_clip.w = clip->w;
+    sdl_clip.h = clip->h;
+
+    if (cull_render_quad(&render_quad, center.x, center.y, params->angle))
+        return;
+
+    set_texture_color_mod(image, params->color.red, params->color.green,
+                          params->color.blue);
+    set_texture_alpha_mod(image, image->alpha * params->color.alpha / 255);
+    SDL_RenderCopyEx(screen->impl, image->impl, &sdl_clip, &render_quad,
+                     params->angle, &center, (SDL_RendererFlip)flip);
+}
+
+void draw_image_ex(struct image* image,
+                   int x,
+                   int y,
+                   const struct rectangle* clip,
+                   const struct draw_params* params)
+{
+    struct rectangle whole;
+    if (clip == NULL) {
+        whole.x = 0;
+        whole.y = 0;
+        whole.w = image->width;
+        whole.h = image->height;
+        clip = &whole;
+    }
+    render_image_ex(image, clip, x, y, 0, 0, params->pivot_x * clip->w,
+                    params->pivot_y * clip->h, params);
+}
+
 struct image* create_image(const char* filepath)
 {
-    struct image* image = (struct image*)malloc(sizeof(struct image));
+    struct image* image = (struct image*)MALLOC(
+    sizeof(struct image), MEMORY_IMAGES);
     if (image != NULL && init_image_from_file(image, filepath) == -1) {
-        free(image);
+        FREE(image);
         image = NULL;
     }
     return image;
 }
 
+struct image* create_managed_image(const char* filepath)
+{
+    struct image* image = create_image(filepath);
+    if (image == NULL) return NULL;
+    image->source = (char*)MALLOC(strlen(filepath) + 1, MEMORY_IMAGES);
+    if (image->source == NULL) {
+        ERROR("Unable to allocate the managed image source");
+        destroy_image(image);
+        return NULL;
+    }
+    strcpy(image->source, filepath);
+    link_texture(image);
+    textures.stats.resident_bytes += texture_bytes(image);
+    textures.stats.resident_images++;
+    fit_texture_budget();
+    return image;
+}
+
 static struct image* _create_image(int w, int h, int access)
 {
-    struct image* image = (struct image*)malloc(sizeof(struct image));
+    struct image* image = (struct image*)MALLOC(
+    sizeof(struct image), MEMORY_IMAGES);
     if (image != NULL) {
         image->impl = SDL_CreateTexture(screen->impl,
                                         SDL_PIXELFORMAT_RGBA8888,
@@ -164,12 +466,17 @@ static struct image* _create_image(int w, int h, int access)
                                         w,
                                         h);
         if (image->impl == NULL) {
-            free(image);
+            FREE(image);
             image = NULL;
             ERROR("Unable to create SDL texture for blank image");
         } else {
             image->width = w;
             image->height = h;
+            init_image_state(image);
+            TRACK_ASSET(image->impl, MEMORY_TEXTURES,
+                        access == SDL_TEXTUREACCESS_TARGET ? "(target image)"
+                                                           : "(blank image)",
+                        texture_bytes(image));
         }
     }
     return image;
@@ -186,11 +493,11 @@ struct image* create_target_image(int w, int h, struct color color)
 
     image = _create_image(w, h, SDL_TEXTUREACCESS_TARGET);
     if (image != NULL) {
-        SDL_SetRenderTarget(screen->impl, image->impl);
-        SDL_SetRenderDrawColor(screen->impl, color.red, color.green, color.blue,
-                               color.alpha);
+        struct image* target = screen->target;
+        set_render_target(image);
+        set_render_draw_color(color);
         SDL_RenderClear(screen->impl);
-        SDL_SetRenderTarget(screen->impl, NULL);
+        set_render_target(target);
     }
 
     return image;
@@ -198,7 +505,7 @@ struct image* create_target_image(int w, int h, struct color color)
 
 void draw_on_image(struct image* image)
 {
-    int ret = SDL_SetRenderTarget(screen->impl, image->impl);
+    int ret = set_render_target(image);
     if (ret != 0) exit(1);
 }
 
@@ -219,7 +526,7 @@ void set_blend_mode(struct image* image, enum blend_mode blend_mode)
             sdl_mode = SDL_BLENDMODE_MOD;
             break;
     }
-    SDL_SetTextureBlendMode(image->impl, sdl_mode);
+    set_texture_blend_mode(image, sdl_mode);
 }
 
 void set_screen_blend_mode(enum blend_mode blend_mode)
@@ -239,40 +546,80 @@ void set_screen_blend_mode(enum blend_mode blend_mode)
             sdl_mode = SDL_BLENDMODE_MOD;
             break;
     }
-    SDL_SetTextureBlendMode(SDL_GetRenderTarget(screen->impl), sdl_mode);
+    if (screen->target != NULL)
+        set_texture_blend_mode(screen->target, sdl_mode);
 }
+
 void clear_image(struct image* image, struct color color)
 {
     int ret;
-    Uint8 r, g, b, a;
     SDL_Rect rect;
+    struct image* target = screen->target;
     rect.x = 0; rect.y = 0; rect.w = image->width; rect.h = image->height;
-    SDL_GetRenderDrawColor(screen->impl, &r, &g, &b, &a);
-    SDL_SetRenderDrawColor(screen->impl, color.red, color.green, color.blue,
-                           color.alpha);
     draw_on_image(image);
+    set_render_draw_color(color);
     ret = SDL_RenderFillRect(screen->impl, &rect);
     if (ret != 0) exit(1);
-    draw_on_screen();
-    SDL_SetRenderDrawColor(screen->impl, r, g, b, a);
+    ret = set_render_target(target);
+    if (ret != 0) exit(1);
 }
 
 void set_image_alpha(struct image* image, uint8_t alpha)
 {
-    SDL_SetTextureAlphaMod(image->impl, alpha);
+    image->alpha = alpha;
 }
 
 uint8_t get_image_alpha(struct image* image)
 {
-    Uint8 a;
-    SDL_GetTextureAlphaMod(image->impl, &a);
-    return a;
+    return image->alpha;
+}
+
+void set_texture_blend_mode(struct image* image, SDL_BlendMode mode)
+{
+    if (image->blend_state == (int)mode) {
+        screen->stats.elided++;
+        return;
+    }
+    /* an evicted managed image gets the mode when it is reloaded */
+    if (image->impl == NULL && image->source != NULL) {
+        image->blend_state = mode;
+        return;
+    }
+    screen->stats.issued++;
+    if (SDL_SetTextureBlendMode(image->impl, mode) == 0)
+        image->blend_state = mode;
+}
+
+void set_texture_alpha_mod(struct image* image, uint8_t alpha)
+{
+    if (image->alpha_state == alpha) {
+        screen->stats.elided++;
+        return;
+    }
+    screen->stats.issued++;
+    if (SDL_SetTextureAlphaMod(image->impl, alpha) == 0)
+        image->alpha_state = alpha;
+}
+
+void set_texture_color_mod(struct image* image,
+                           uint8_t red,
+                           uint8_t green,
+                           uint8_t blue)
+{
+    int tint = (red << 16) | (green << 8) | blue;
+    if (image->tint_state == tint) {
+        screen->stats.elided++;
+        return;
+    }
+    screen->stats.issued++;
+    if (SDL_SetTextureColorMod(image->impl, red, green, blue) == 0)
+        image->tint_state = tint;
 }
 
 void destroy_image(struct image* image)
 {
     cleanup_image(image);
-    free(image);
+    FREE(image);
 }
 
 static uint32_t get_pixel32(uint32_t* pixels, int pitch, int x, int y)
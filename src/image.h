@@ -62,6 +62,39 @@ struct image {
     int width;
     /** Image height in pixels */
     int height;
+    /** Image alpha value set using set_image_alpha() */
+    uint8_t alpha;
+    /* Texture state last set on impl, or -1 if unknown. Kept by the
+     * renderer state cache so unchanged state is not sent to SDL again. */
+    int blend_state;
+    int alpha_state;
+    int tint_state;
+    /* Managed images: the file the texture is loaded from, or NULL when
+     * the texture is never evicted, the frame the image was last drawn
+     * in and the links of the least recently drawn list of resident
+     * managed textures */
+    char* source;
+    unsigned long drawn_frame;
+    struct image* lru_prev;
+    struct image* lru_next;
+};
+
+/**
+ * Texture budget counters, see create_managed_image()
+ */
+struct texture_stats {
+    /** texture budget in bytes, or 0 for no budget */
+    size_t budget;
+    /** bytes of managed textures currently uploaded */
+    size_t resident_bytes;
+    /** number of managed textures currently uploaded */
+    int resident_images;
+    /** textures evicted to stay within the budget */
+    unsigned long evictions;
+    /** evicted textures uploaded again when drawn */
+    unsigned long reloads;
+    /** milliseconds spent drawing frames stalled on reloads */
+    float reload_ms;
 };
 
 /**
@@ -76,6 +109,46 @@ enum blend_mode {
     MULTIPLY,
 };
 
+/**
+ * Mirroring flags for draw_image_ex(). Combine them with a bitwise or
+ * to flip both ways.
+ */
+enum flip_mode {
+    FLIP_NONE = 0,
+    FLIP_HORIZONTAL = 1,
+    FLIP_VERTICAL = 2,
+};
+
+/**
+ * Draw parameters describe how draw_image_ex() and the other extended
+ * draw functions place an image. Start from default_draw_params() and
+ * change what you need:
+ *
+ *     struct draw_params params = default_draw_params();
+ *     params.flip = FLIP_HORIZONTAL;
+ *     params.scale_x = 2.0f;
+ *     draw_image_ex(image, x, y, NULL, &params);
+ *
+ * Draw parameters are plain values, so you can keep them with your game
+ * objects or queue them for later drawing.
+ */
+struct draw_params {
+    /** \ref flip_mode flags */
+    int flip;
+    /** horizontal scale, a negative value also flips horizontally */
+    float scale_x;
+    /** vertical scale, a negative value also flips vertically */
+    float scale_y;
+    /** pivot x position, 0.0 is the left edge and 1.0 the right edge */
+    float pivot_x;
+    /** pivot y position, 0.0 is the top edge and 1.0 the bottom edge */
+    float pivot_y;
+    /** rotation around the pivot in degrees */
+    double angle;
+    /** color and alpha to multiply the image pixels with */
+    struct color color;
+};
+
 /**
  * Create and load an image using a PNG file
  * @param filepath File path to the image file
@@ -84,6 +157,38 @@ enum blend_mode {
  */
 struct image* create_image(const char* filepath);
 
+/**
+ * Create an image whose texture may be evicted to fit the texture
+ * budget. Managed images remember the file they were loaded from.
+ * When the textures of managed images take more than the budget set
+ * using set_texture_budget(), those drawn least recently are dropped,
+ * and loaded again the next time they are drawn:
+ *
+ *     set_texture_budget(64 * 1024 * 1024);
+ *     level->background = create_managed_image("res/level1.png");
+ *
+ * Images drawn in the current frame are never evicted, so the budget
+ * may be exceeded when a single frame draws more than it allows.
+ * Pixels written to a managed image using lock_image() are lost when
+ * its texture is evicted.
+ * @param filepath File path to the image file
+ *
+ * @return \ref image pointer or NULL on failure
+ */
+struct image* create_managed_image(const char* filepath);
+
+/**
+ * Set the texture memory managed images may take
+ * @param bytes texture budget in bytes, or 0 to never evict textures
+ */
+void set_texture_budget(size_t bytes);
+
+/**
+ * Get the texture budget counters
+ * @param stats \ref texture_stats to fill
+ */
+void get_texture_stats(struct texture_stats* stats);
+
 /**
  * Create a blank image for direct pixel manipulation
  * @param width The width of the blank image
@@ -165,9 +270,33 @@ int unlock_image(struct image* image);
 void draw_image(struct image* image,
                 int x,
                 int y,
-                struct rectangle* clip,
+                const struct rectangle* clip,
                 double angle);
 
+/**
+ * Get the draw parameters that draw an image as draw_image() does:
+ * no flipping, no scaling or rotation, a centered pivot and no color
+ * modulation.
+ *
+ * @return \ref draw_params by value
+ */
+struct draw_params default_draw_params(void);
+
+/**
+ * Draw an image with flipping, scaling, rotation and color modulation
+ * @param image Image to draw
+ * @param x X position of the unscaled image top-left corner
+ * @param y Y position of the unscaled image top-left corner
+ * @param clip Rectangle to draw or NULL for the entire image
+ * @param params \ref draw_params to apply. Scaling, flipping and rotation
+ * are all done around the pivot, which stays in place.
+ */
+void draw_image_ex(struct image* image,
+                   int x,
+                   int y,
+                   const struct rectangle* clip,
+                   const struct draw_params* params);
+
 /**
  * Switch to draw on an image instead of the actual screen
  * @param image Image to draw on to
@@ -1,7 +1,11 @@
 #ifndef INTERNALS_H_G9CYEQL6
 #define INTERNALS_H_G9CYEQL6
 
+#include <stdlib.h>
 #include "SDL.h"
+#include "color.h"
+#include "memory_stats.h"
+#include "screen.h"
 
 #include "begin_prefix.h"
 /* The game drawing surface
@@ -20,6 +24,31 @@ struct screen {
     float offset_x;
     /* Rendering Y offset, for scrolling or shaking */
     float offset_y;
+    /* Color used to clear the screen every frame */
+    struct color background;
+    /* Renderer state cache: the current target image (NULL for the
+     * screen) and the current draw color, when draw_color_known is set */
+    struct image* target;
+    struct color draw_color;
+    int draw_color_known;
+    /* Logical screen size, or 0 when the renderer output size is used */
+    int width;
+    int height;
+    /* Renderer state changes issued and elided by the cache, and quads
+     * submitted and culled by the draw functions */
+    struct render_stats stats;
+    /* Draw queue recording draws, or NULL to draw right away */
+    struct draw_queue* queue;
+    /* Dynamic resolution: the scene target standing in for the screen,
+     * or NULL, the fraction of its size in use, the lowest fraction
+     * allowed, the frame time budget in milliseconds, the rolling
+     * average frame time and the frames since the last adjustment */
+    struct image* scene;
+    float render_scale;
+    float min_render_scale;
+    float frame_budget;
+    float frame_time;
+    int scale_frames;
 };
 extern struct screen* screen;
 
@@ -29,5 +58,201 @@ struct keyboard {
 };
 extern struct keyboard* keyboard;
 
+/* Mouse state sampled by sample_mouse() once per frame and handed out
+ * by update_mouse() */
+struct mouse;
+extern struct mouse* mouse_state;
+void sample_mouse(void);
+
+struct image;
+struct rectangle;
+struct draw_params;
+struct draw_queue;
+
+/* Draw the clip area of an image, where the clip area sits at
+ * offset_x, offset_y inside a frame whose top-left corner is at x, y.
+ * The frame is scaled, flipped and rotated around pivot_x, pivot_y,
+ * given in pixels inside the frame. draw_image_ex() and trimmed sprite
+ * sheet frames share this.
+ */
+void render_image_ex(struct image* image,
+                     const struct rectangle* clip,
+                     float x,
+                     float y,
+                     float offset_x,
+                     float offset_y,
+                     float pivot_x,
+                     float pivot_y,
+                     const struct draw_params* params);
+
+/* Renderer state cache
+ *
+ * Renderer and texture state changes go through these instead of
+ * calling SDL directly. A change that matches the state the cache
+ * last set is skipped and counted in screen->stats.elided. Users of a
+ * piece of state set it before drawing rather than restoring it after,
+ * so repeated draws with the same state cost no SDL calls.
+ */
+void reset_render_state(void);
+int set_render_target(struct image* target);
+void set_render_draw_color(struct color color);
+void set_texture_blend_mode(struct image* image, SDL_BlendMode mode);
+void set_texture_alpha_mod(struct image* image, uint8_t alpha);
+void set_texture_color_mod(struct image* image,
+                           uint8_t red,
+                           uint8_t green,
+                           uint8_t blue);
+
+/* Draw queue recording
+ *
+ * draw_image() and render_image_ex() pass their arguments to these
+ * while screen->queue is set. They return 1 when the draw was recorded
+ * and 0 when it should be made right away, e.g. when drawing on
+ * another target than the queue one.
+ *
+ * A render pass target drawn while a queue records draws for the
+ * current target may only go back to the pool once the queue is
+ * flushed. hold_until_flushed() hands it to that queue, which calls
+ * release_render_target() when flushed or destroyed, and returns 0
+ * when no queue records draws for the current target.
+ */
+int hold_until_flushed(struct image* target);
+void release_render_target(struct image* target);
+int queue_draw_image(struct image* image,
+                     int x,
+                     int y,
+                     const struct rectangle* clip,
+                     double angle);
+int queue_render_image_ex(struct image* image,
+                          const struct rectangle* clip,
+                          float x,
+                          float y,
+                          float offset_x,
+                          float offset_y,
+                          float pivot_x,
+                          float pivot_y,
+                          const struct draw_params* params);
+
+/* Dynamic resolution
+ *
+ * When enabled, the screen is a scene target image the size of the
+ * logical screen, drawn to at render_scale and stretched over the
+ * window by present_frame(). set_render_target(NULL) binds the scene.
+ * present_frame() takes the performance counter value the frame
+ * started at and adjusts render_scale to fit the frame time budget.
+ */
+int prepare_dynamic_resolution(float frame_budget, float min_render_scale);
+void teardown_dynamic_resolution(void);
+void begin_frame(void);
+void present_frame(uint64_t frame_start);
+
+/* Job workers
+ *
+ * start_workers() starts n_workers job threads, or one per core beside
+ * the main thread when n_workers is negative. stop_workers() finishes
+ * started jobs and joins the threads.
+ */
+int start_workers(int n_workers);
+void stop_workers(void);
+
+/* Managed images
+ *
+ * Draw functions call use_image() before drawing an image. It reloads
+ * the texture of an evicted managed image and marks the image as drawn
+ * in the current frame, returning -1 when the texture can not be
+ * reloaded. The game loop calls next_texture_frame() once a frame is
+ * presented.
+ */
+int use_image(struct image* image);
+void next_texture_frame(void);
+
+/* Engine arenas
+ *
+ * prepare_arenas() creates the frame, two frame and scratch arenas,
+ * size bytes each or DEFAULT_ARENA_SIZE when size is 0. The game loop
+ * calls next_frame_arenas() once a frame is presented.
+ */
+int prepare_arenas(size_t size);
+void teardown_arenas(void);
+void next_frame_arenas(void);
+
+/* Files
+ *
+ * map_file_memory() maps a whole file for reading, returning -1 when
+ * the file is empty or the platform can not map it. The game loop
+ * calls dispatch_file_writes() once a frame to call the completion
+ * functions of asynchronous writes, and stop_file_writer() when
+ * quitting.
+ */
+int map_file_memory(const char* path, void** memory, size_t* size);
+void unmap_file_memory(void* memory, size_t size);
+void dispatch_file_writes(void);
+void stop_file_writer(void);
+
+/* Input replay
+ *
+ * prepare_replay() starts recording input to record_path and replaying
+ * it from replay_path, either may be NULL. The game loop calls
+ * replay_frame() once the keyboard, mouse and stopwatch are sampled. It
+ * records them, or replaces them with the next recorded frame and
+ * returns -1 once the replay is over. teardown_replay() writes the
+ * recording.
+ */
+int prepare_replay(const char* record_path, const char* replay_path);
+int replay_frame(float* stopwatch);
+void teardown_replay(void);
+
+/* Assets
+ *
+ * read_text_asset() reads a whole asset, opened using open_asset(),
+ * into a NUL terminated buffer allocated with the given memory tag,
+ * and stores its length. The game loop unmounts the packs in its
+ * cleanup, using unmount_packs().
+ */
+char* read_text_asset(const char* path, size_t* length, int tag);
+
+/* Viewport culling
+ *
+ * Draw functions check the destination of every quad, after adding
+ * the screen offset, against the bounds of the current render target.
+ * cull_quad() returns 1, counting the quad in screen->stats.culled,
+ * when it lands completely outside, and 0, counting it in
+ * screen->stats.submitted, otherwise.
+ */
+void get_render_target_size(int* width, int* height);
+int cull_quad(float left, float top, float right, float bottom);
+
+/* Memory tracking
+ *
+ * Cage allocates through these macros, with the memory_tag of the
+ * allocating subsystem. Memory allocated using them must be freed
+ * using FREE(), and memory handed to the user, who frees it, must come
+ * from plain malloc(). TRACK_ASSET() and UNTRACK_ASSET() account
+ * memory SDL allocates for textures and sounds, keyed by the SDL
+ * object. Unless CAGE_TRACK_MEMORY is defined, they all compile down
+ * to the plain C library calls.
+ */
+#ifdef CAGE_TRACK_MEMORY
+void* tracked_malloc(size_t size, int tag);
+void* tracked_calloc(size_t count, size_t size, int tag);
+void* tracked_realloc(void* memory, size_t size, int tag);
+void tracked_free(void* memory);
+void track_asset(const void* key, int tag, const char* path, size_t bytes);
+void untrack_asset(const void* key, int tag, size_t bytes);
+#define MALLOC(size, tag) tracked_malloc(size, tag)
+#define CALLOC(count, size, tag) tracked_calloc(count, size, tag)
+#define REALLOC(memory, size, tag) tracked_realloc(memory, size, tag)
+#define FREE(memory) tracked_free(memory)
+#define TRACK_ASSET(key, tag, path, bytes) track_asset(key, tag, path, bytes)
+#define UNTRACK_ASSET(key, tag, bytes) untrack_asset(key, tag, bytes)
+#else
+#define MALLOC(size, tag) malloc(size)
+#define CALLOC(count, size, tag) calloc(count, size)
+#define REALLOC(memory, size, tag) realloc(memory, size)
+#define FREE(memory) free(memory)
+#define TRACK_ASSET(key, tag, path, bytes) ((void)0)
+#define UNTRACK_ASSET(key, tag, bytes) ((void)0)
+#endif
+
 #include "end_prefix.h"
 #endif /* end of include guard: INTERNALS_H_G9CYEQL6 */
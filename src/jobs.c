@@ -0,0 +1,378 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "jobs.h"
+#include "internals.h"
+#include "utils.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include "begin_prefix.h"
+
+/* per-worker queue size, a power of two */
+#define QUEUE_SIZE 1024
+#define MAX_WORKERS 64
+
+/* A worker queue. The owner pushes and pops jobs at the bottom, LIFO,
+ * which keeps the data it just touched hot, and other workers steal
+ * from the top, taking the oldest and usually largest jobs. The lock
+ * is only held for a few instructions. */
+struct job_queue {
+    SDL_SpinLock lock;
+    unsigned top;
+    unsigned bottom;
+    struct job* jobs[QUEUE_SIZE];
+};
+
+struct job_system {
+    /* queue 0 belongs to the main thread, queue i to worker i */
+    struct job_queue queues[MAX_WORKERS + 1];
+    SDL_Thread* threads[MAX_WORKERS + 1];
+    int n_threads;
+    /* set before the threads start, so the queues of threads that
+     * failed to start stay empty */
+    int n_workers;
+    SDL_TLSID worker_id;
+    /* idle workers sleep on wake until jobs are queued or quit is set */
+    SDL_mutex* mutex;
+    SDL_cond* wake;
+    SDL_atomic_t queued;
+    SDL_atomic_t sleeping;
+    SDL_atomic_t quit;
+    /* started and not yet done jobs */
+    SDL_atomic_t unfinished;
+    /* job pool, recycled by finish_jobs() */
+    SDL_atomic_t n_jobs;
+    struct job jobs[JOB_POOL_SIZE];
+};
+
+static struct job_system* jobs = NULL;
+
+static int current_queue(void)
+{
+    /* the main thread, and any thread cage did not start, has no id */
+    if (jobs->worker_id == 0) return 0;
+    return (int)(intptr_t)SDL_TLSGet(jobs->worker_id);
+}
+
+static int push_job(struct job* job)
+{
+    struct job_queue* queue = &jobs->queues[current_queue()];
+    int pushed = 0;
+    SDL_AtomicLock(&queue->lock);
+    if (queue->bottom - queue->top < QUEUE_SIZE) {
+        queue->jobs[queue->bottom++ & (QUEUE_SIZE - 1)] = job;
+        pushed = 1;
+    }
+    SDL_AtomicUnlock(&queue->lock);
+    if (!pushed) return 0;
+    SDL_AtomicAdd(&jobs->queued, 1);
+    if (SDL_AtomicGet(&jobs->sleeping) > 0) {
+        SDL_LockMutex(jobs->mutex);
+        SDL_CondSignal(jobs->wake);
+        SDL_UnlockMutex(jobs->mutex);
+    }
+    return 1;
+}
+
+static struct job* pop_job(struct job_queue* queue)
+{
+    struct job* job = NULL;
+    SDL_AtomicLock(&queue->lock);
+    if (queue->bottom != queue->top)
+        job = queue->jobs[--queue->bottom & (QUEUE_SIZE - 1)];
+    SDL_AtomicUnlock(&queue->lock);
+    return job;
+}
+
+static struct job* steal_job(struct job_queue* queue)
+{
+    struct job* job = NULL;
+    SDL_AtomicLock(&queue->lock);
+    if (queue->bottom != queue->top)
+        job = queue->jobs[queue->top++ & (QUEUE_SIZE - 1)];
+    SDL_AtomicUnlock(&queue->lock);
+    return job;
+}
+
+/* Take a job from the own queue first, then from the others, starting
+ * with the next queue so thieves spread over the victims. */
+static struct job* find_job(int self)
+{
+    int n = jobs->n_workers + 1;
+    int i;
+    struct job* job;
+
+    if (SDL_AtomicGet(&jobs->queued) == 0) return NULL;
+    job = pop_job(&jobs->queues[self]);
+    for (i = 1; job == NULL && i < n; i++)
+        job = steal_job(&jobs->queues[(self + i) % n]);
+    if (job != NULL) SDL_AtomicAdd(&jobs->queued, -1);
+    return job;
+}
+
+static void ready_job(struct job* job);
+
+static void run_job(struct job* job)
+{
+    struct job* dependents[JOB_MAX_DEPENDENTS];
+    int n, i;
+
+    if (job->range_func != NULL)
+        job->range_func(job->data, job->begin, job->end);
+    else
+        job->func(job->data);
+
+    /* once done is set, no dependent can be added */
+    SDL_AtomicLock(&job->lock);
+    SDL_AtomicSet(&job->done, 1);
+    n = job->n_dependents;
+    for (i = 0; i < n; i++) dependents[i] = job->dependents[i];
+    SDL_AtomicUnlock(&job->lock);
+    for (i = 0; i < n; i++)
+        if (SDL_AtomicAdd(&dependents[i]->pending, -1) == 1)
+            ready_job(dependents[i]);
+    SDL_AtomicAdd(&jobs->unfinished, -1);
+}
+
+/* Queue a job whose dependencies are done, or run it right away when
+ * the queue is full. */
+static void ready_job(struct job* job)
+{
+    if (!push_job(job)) run_job(job);
+}
+
+static int worker_main(void* data)
+{
+    int self = (int)(intptr_t)data;
+    struct job* job;
+
+    SDL_TLSSet(jobs->worker_id, data, NULL);
+    while (!SDL_AtomicGet(&jobs->quit)) {
+        job = find_job(self);
+        if (job != NULL) {
+            run_job(job);
+            continue;
+        }
+        SDL_LockMutex(jobs->mutex);
+        SDL_AtomicAdd(&jobs->sleeping, 1);
+        while (SDL_AtomicGet(&jobs->queued) == 0 &&
+               !SDL_AtomicGet(&jobs->quit))
+            SDL_CondWait(jobs->wake, jobs->mutex);
+        SDL_AtomicAdd(&jobs->sleeping, -1);
+        SDL_UnlockMutex(jobs->mutex);
+    }
+    return 0;
+}
+
+int start_workers(int n_workers)
+{
+    int i;
+
+    if (n_workers < 0) n_workers = SDL_GetCPUCount() - 1;
+    if (n_workers > MAX_WORKERS) n_workers = MAX_WORKERS;
+    jobs = (struct job_system*)CALLOC(
+    1, sizeof(struct job_system), MEMORY_JOBS);
+    if (jobs == NULL) goto error;
+    jobs->mutex = SDL_CreateMutex();
+    if (jobs->mutex == NULL) goto free_jobs;
+    jobs->wake = SDL_CreateCond();
+    if (jobs->wake == NULL) goto free_mutex;
+    if (n_workers > 0) {
+        jobs->worker_id = SDL_TLSCreate();
+        if (jobs->worker_id == 0) goto free_cond;
+    }
+    jobs->n_workers = n_workers;
+    for (i = 1; i <= n_workers; i++) {
+        jobs->threads[i] =
+        SDL_CreateThread(worker_main, "cage worker", (void*)(intptr_t)i);
+        if (jobs->threads[i] == NULL) {
+            ERROR("Unable to start a worker thread");
+            break;
+        }
+        jobs->n_threads = i;
+    }
+    return 0;
+
+free_cond:
+    SDL_DestroyCond(jobs->wake);
+free_mutex:
+    SDL_DestroyMutex(jobs->mutex);
+free_jobs:
+    FREE(jobs);
+    jobs = NULL;
+error:
+    ERROR("Unable to start the job system");
+    return -1;
+}
+
+void stop_workers(void)
+{
+    int i;
+    if (jobs == NULL) return;
+    finish_jobs();
+    SDL_LockMutex(jobs->mutex);
+    SDL_AtomicSet(&jobs->quit, 1);
+    SDL_CondBroadcast(jobs->wake);
+    SDL_UnlockMutex(jobs->mutex);
+    for (i = 1; i <= jobs->n_threads; i++)
+        SDL_WaitThread(jobs->threads[i], NULL);
+    SDL_DestroyCond(jobs->wake);
+    SDL_DestroyMutex(jobs->mutex);
+    FREE(jobs);
+    jobs = NULL;
+}
+
+int get_worker_count(void)
+{
+    return jobs != NULL ? jobs->n_threads : 0;
+}
+
+static struct job* take_pool_job(void)
+{
+    int index = SDL_AtomicAdd(&jobs->n_jobs, 1);
+    struct job* job;
+    if (index >= JOB_POOL_SIZE) {
+        SDL_AtomicAdd(&jobs->n_jobs, -1);
+        return NULL;
+    }
+    job = &jobs->jobs[index];
+    job->func = NULL;
+    job->range_func = NULL;
+    SDL_AtomicSet(&job->pending, 1);
+    SDL_AtomicSet(&job->done, 0);
+    job->lock = 0;
+    job->n_dependents = 0;
+    return job;
+}
+
+struct job* create_job(job_func_t func, void* data)
+{
+    struct job* job;
+    if (jobs == NULL) return NULL;
+    job = take_pool_job();
+    if (job == NULL) {
+        ERROR("Job pool exhausted");
+        return NULL;
+    }
+    job->func = func;
+    job->data = data;
+    return job;
+}
+
+int add_job_dependency(struct job* job, struct job* dependency)
+{
+    int ret = 0;
+    SDL_AtomicLock(&dependency->lock);
+    if (!SDL_AtomicGet(&dependency->done)) {
+        if (dependency->n_dependents < JOB_MAX_DEPENDENTS) {
+            dependency->dependents[dependency->n_dependents++] = job;
+            SDL_AtomicAdd(&job->pending, 1);
+        } else {
+            ret = -1;
+        }
+    }
+    SDL_AtomicUnlock(&dependency->lock);
+    if (ret == -1) ERROR("Too many jobs depend on a single job");
+    return ret;
+}
+
+void start_job(struct job* job)
+{
+    SDL_AtomicAdd(&jobs->unfinished, 1);
+    if (SDL_AtomicAdd(&job->pending, -1) == 1) ready_job(job);
+}
+
+bool is_job_done(struct job* job)
+{
+    return SDL_AtomicGet(&job->done) != 0;
+}
+
+/* Run queued jobs until done returns true */
+static void help_until(bool (*done)(void*), void* data)
+{
+    int self = current_queue();
+    struct job* job;
+    while (!done(data)) {
+        job = find_job(self);
+        if (job != NULL)
+            run_job(job);
+        else
+            SDL_Delay(0);
+    }
+}
+
+static bool job_done(void* data)
+{
+    return is_job_done((struct job*)data);
+}
+
+void wait_job(struct job* job)
+{
+    help_until(job_done, job);
+}
+
+void parallel_for(int count, int grain, parallel_func_t func, void* data)
+{
+    struct job* ranges[MAX_WORKERS * 4];
+    int n_ranges, size, begin, i;
+
+    if (count <= 0) return;
+    if (grain < 1) grain = 1;
+    /* a few ranges per thread, so thieves can even out the load */
+    n_ranges = jobs != NULL ? (jobs->n_workers + 1) * 4 : 1;
+    if (n_ranges > MAX_WORKERS * 4) n_ranges = MAX_WORKERS * 4;
+    size = (count + n_ranges - 1) / n_ranges;
+    if (size < grain) size = grain;
+    if (jobs == NULL || jobs->n_workers == 0 || size >= count) {
+        func(data, 0, count);
+        return;
+    }
+
+    /* the calling thread keeps the first range for itself */
+    n_ranges = 0;
+    for (begin = size; begin < count; begin += size) {
+        struct job* job = take_pool_job();
+        if (job == NULL) break;
+        job->range_func = func;
+        job->data = data;
+        job->begin = begin;
+        job->end = begin + size < count ? begin + size : count;
+        ranges[n_ranges++] = job;
+        start_job(job);
+    }
+    /* without a job for the rest of the range, process it here */
+    if (begin < count) func(data, begin, count);
+    func(data, 0, size);
+    for (i = 0; i < n_ranges; i++) wait_job(ranges[i]);
+}
+
+static bool all_done(void* data)
+{
+    UNUSED(data);
+    return SDL_AtomicGet(&jobs->unfinished) == 0;
+}
+
+void finish_jobs(void)
+{
+    if (jobs == NULL) return;
+    help_until(all_done, NULL);
+    SDL_AtomicSet(&jobs->n_jobs, 0);
+}
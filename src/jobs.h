@@ -0,0 +1,165 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#ifndef JOBS_H_N4YH7CXD
+#define JOBS_H_N4YH7CXD
+
+#include "SDL.h"
+#include "types.h"
+
+#include "begin_prefix.h"
+/** Number of jobs that can be created between two finish_jobs() calls */
+#define JOB_POOL_SIZE 4096
+/** Number of jobs that can wait for a single job */
+#define JOB_MAX_DEPENDENTS 8
+
+/**
+ * This is the prototype of a job function.
+ */
+typedef void (*job_func_t)(void* data);
+
+/**
+ * This is the prototype of a parallel_for() function. It is called with
+ * a range of indices to process, from begin up to but not including end.
+ */
+typedef void (*parallel_func_t)(void* data, int begin, int end);
+
+/**
+ * Jobs run functions on worker threads, so game states and engine
+ * subsystems can use every core. Workers are opt-in: games that set
+ * \ref settings worker_threads, or the worker_threads key of
+ * res/game.conf, get them started before the first game state is
+ * created. Without workers, jobs run on the main thread.
+ *
+ * The simplest way to use the workers is parallel_for(), which splits a
+ * range of indices between them and returns once all are processed:
+ *
+ *     static void move_zombies(void* data, int begin, int end)
+ *     {
+ *         struct zombie* zombies = data;
+ *         for (int i = begin; i < end; i++)
+ *             walk(&zombies[i]);
+ *     }
+ *
+ *     parallel_for(n_zombies, 64, move_zombies, zombies);
+ *
+ * Jobs can also run in the background, possibly after other jobs:
+ *
+ *     struct job* path = create_job(find_paths, level);
+ *     struct job* ai = create_job(think, level);
+ *     add_job_dependency(ai, path);
+ *     start_job(path);
+ *     start_job(ai);
+ *     // ... later in the frame
+ *     wait_job(ai);
+ *
+ * Every worker keeps its own queue of jobs and takes work from the
+ * other queues when it runs out. Threads waiting for a job run other
+ * jobs meanwhile. The game loop calls finish_jobs() at the end of every
+ * frame, which waits for all started jobs and recycles them, so job
+ * pointers are only valid during the frame they were created in.
+ */
+struct job {
+    /* job function, or NULL for a parallel_for() range */
+    job_func_t func;
+    parallel_func_t range_func;
+    void* data;
+    int begin;
+    int end;
+    /* unfinished dependencies, plus one until the job is started */
+    SDL_atomic_t pending;
+    SDL_atomic_t done;
+    /* jobs waiting for this one, guarded by lock */
+    SDL_SpinLock lock;
+    struct job* dependents[JOB_MAX_DEPENDENTS];
+    int n_dependents;
+};
+
+/**
+ * Create a job. The job runs once started using start_job() and once
+ * all of its dependencies are done.
+ * @param func job function
+ * @param data data passed to the job function
+ *
+ * @return a new job, or NULL when JOB_POOL_SIZE jobs were already
+ * created this frame
+ */
+struct job* create_job(job_func_t func, void* data);
+
+/**
+ * Make a job wait for another job
+ * @param job job to hold, not started yet
+ * @param dependency job that must be done before job runs
+ *
+ * @return 0 on success or -1 when dependency already has
+ * JOB_MAX_DEPENDENTS dependent jobs
+ */
+int add_job_dependency(struct job* job, struct job* dependency);
+
+/**
+ * Start a job created using create_job()
+ * @param job job to start
+ */
+void start_job(struct job* job);
+
+/**
+ * Wait for a started job to be done, running other jobs meanwhile
+ * @param job job to wait for
+ */
+void wait_job(struct job* job);
+
+/**
+ * Check if a job is done
+ * @param job job to check
+ *
+ * @return true once the job function returned
+ */
+bool is_job_done(struct job* job);
+
+/**
+ * Process a range of indices on all workers
+ * @param count number of indices, from 0 to count - 1
+ * @param grain smallest number of indices worth a job of its own
+ * @param func function processing a part of the range
+ * @param data data passed to func
+ *
+ * The calling thread processes parts of the range too, and the call
+ * returns once the whole range is processed.
+ */
+void parallel_for(int count, int grain, parallel_func_t func, void* data);
+
+/**
+ * Wait for all started jobs and recycle every job created so far.
+ * The game loop calls it after each frame update, so you only need it
+ * to reuse the job pool within a frame. Jobs created but not started
+ * are dropped.
+ */
+void finish_jobs(void);
+
+/**
+ * Get the number of worker threads
+ *
+ * @return number of worker threads beside the main thread
+ */
+int get_worker_count(void);
+
+#include "end_prefix.h"
+#endif /* end of include guard: JOBS_H_N4YH7CXD */
@@ -0,0 +1,232 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "lightmap.h"
+#include "internals.h"
+#include "utils.h"
+#include <math.h>
+#include <stdlib.h>
+#include "begin_prefix.h"
+
+/* size of the generated light images */
+#define LIGHT_SIZE 64
+#define MIN_LIGHTS 16
+/* spot light edges fade out over this many degrees */
+#define CONE_EDGE 6.0
+
+struct lightmap* create_lightmap(int width, int height, int scale)
+{
+    struct lightmap* lightmap;
+
+    if (width <= 0 || height <= 0 || scale <= 0) {
+        ERROR("Lightmap size and scale must be positive");
+        return NULL;
+    }
+    lightmap = (struct lightmap*)CALLOC(
+    1, sizeof(struct lightmap), MEMORY_RENDER);
+    if (lightmap == NULL) goto error;
+    lightmap->buffer = create_target_image((width + scale - 1) / scale,
+                                           (height + scale - 1) / scale,
+                                           color_from_RGB(0, 0, 0));
+    if (lightmap->buffer == NULL) goto free_lightmap;
+    set_blend_mode(lightmap->buffer, MULTIPLY);
+#if SDL_VERSION_ATLEAST(2, 0, 12)
+    /* a stretched nearest neighbour buffer shows its pixels */
+    SDL_SetTextureScaleMode(lightmap->buffer->impl, SDL_ScaleModeLinear);
+#endif
+    lightmap->lights = (struct light*)MALLOC(
+    sizeof(struct light) * MIN_LIGHTS, MEMORY_RENDER);
+    if (lightmap->lights == NULL) goto free_buffer;
+    lightmap->capacity = MIN_LIGHTS;
+    lightmap->width = width;
+    lightmap->height = height;
+    lightmap->scale = scale;
+    lightmap->ambient = color_from_RGB(0, 0, 0);
+    return lightmap;
+
+free_buffer:
+    destroy_image(lightmap->buffer);
+free_lightmap:
+    FREE(lightmap);
+error:
+    ERROR("Unable to allocate a lightmap");
+    return NULL;
+}
+
+void destroy_lightmap(struct lightmap* lightmap)
+{
+    int i;
+    if (lightmap != NULL) {
+        if (lightmap->falloff != NULL) destroy_image(lightmap->falloff);
+        for (i = 0; i < LIGHT_CONE_STEPS; i++)
+            if (lightmap->cones[i] != NULL) destroy_image(lightmap->cones[i]);
+        destroy_image(lightmap->buffer);
+        FREE(lightmap->lights);
+        FREE(lightmap);
+    }
+}
+
+int add_light(struct lightmap* lightmap, const struct light* light)
+{
+    if (lightmap->n_lights == lightmap->capacity) {
+        int capacity = lightmap->capacity * 2;
+        struct light* lights = (struct light*)REALLOC(
+        lightmap->lights, sizeof(struct light) * capacity, MEMORY_RENDER);
+        if (lights == NULL) {
+            ERROR("Unable to grow the lightmap lights");
+            return -1;
+        }
+        lightmap->lights = lights;
+        lightmap->capacity = capacity;
+    }
+    lightmap->lights[lightmap->n_lights++] = *light;
+    return 0;
+}
+
+/* Light images are white, with the light intensity in the alpha
+ * channel, so the light color and intensity come from the color and
+ * alpha modulation. The light center is the image center, and spot
+ * lights point right. cone is the spot width in degrees, or 0.
+ */
+static struct image* create_light_image(double cone)
+{
+    struct image* image;
+    uint32_t* pixels;
+    int pitch, px, py;
+    double half = LIGHT_SIZE / 2.0;
+
+    image = create_blank_image(LIGHT_SIZE, LIGHT_SIZE);
+    if (image == NULL) return NULL;
+    if (lock_image(image, (void**)&pixels, &pitch) == -1) {
+        destroy_image(image);
+        return NULL;
+    }
+    for (py = 0; py < LIGHT_SIZE; py++) {
+        uint32_t* row = (uint32_t*)((char*)pixels + py * pitch);
+        for (px = 0; px < LIGHT_SIZE; px++) {
+            double dx = px + 0.5 - half;
+            double dy = py + 0.5 - half;
+            double d = 1 - sqrt(dx * dx + dy * dy) / half;
+            double intensity = d > 0 ? d * d : 0;
+            if (cone > 0) {
+                double angle = fabs(atan2(dy, dx)) * 180 / Pi;
+                double edge = (cone / 2 - angle) / CONE_EDGE;
+                intensity *= edge < 0 ? 0 : edge > 1 ? 1 : edge;
+            }
+            /* RGBA8888 */
+            row[px] = 0xffffff00u | (uint32_t)(intensity * 255 + 0.5);
+        }
+    }
+    unlock_image(image);
+    set_blend_mode(image, ADD);
+    return image;
+}
+
+static struct image* light_image(struct lightmap* lightmap,
+                                 const struct light* light)
+{
+    int step;
+    if (light->cone <= 0 || light->cone >= 360) {
+        if (lightmap->falloff == NULL)
+            lightmap->falloff = create_light_image(0);
+        return lightmap->falloff;
+    }
+    step = (int)(light->cone * LIGHT_CONE_STEPS / 360 + 0.5f);
+    if (step < 1) step = 1;
+    if (step > LIGHT_CONE_STEPS - 1) step = LIGHT_CONE_STEPS - 1;
+    if (lightmap->cones[step] == NULL)
+        lightmap->cones[step] =
+        create_light_image(step * 360.0 / LIGHT_CONE_STEPS);
+    return lightmap->cones[step];
+}
+
+static void draw_lights(struct lightmap* lightmap)
+{
+    struct image* buffer = lightmap->buffer;
+    struct rectangle clip = { 0, 0, LIGHT_SIZE, LIGHT_SIZE };
+    struct draw_params params = default_draw_params();
+    float half = LIGHT_SIZE / 2.0f;
+    int i;
+
+    for (i = 0; i < lightmap->n_lights; i++) {
+        const struct light* light = &lightmap->lights[i];
+        struct image* image;
+        float x = (light->x - lightmap->x) / lightmap->scale;
+        float y = (light->y - lightmap->y) / lightmap->scale;
+        float r = light->radius / lightmap->scale;
+
+        if (x + r <= 0 || y + r <= 0 || x - r >= buffer->width ||
+            y - r >= buffer->height || r <= 0) {
+            lightmap->culled++;
+            continue;
+        }
+        image = light_image(lightmap, light);
+        if (image == NULL) continue;
+        params.scale_x = params.scale_y = r / half;
+        params.angle = image != lightmap->falloff ? light->direction : 0;
+        params.color = light->color;
+        render_image_ex(image, &clip, x - half, y - half, 0, 0, half, half,
+                        &params);
+        lightmap->drawn++;
+    }
+}
+
+void draw_lightmap(struct lightmap* lightmap)
+{
+    struct image* previous = screen->target;
+    struct image* buffer = lightmap->buffer;
+    struct rectangle whole;
+    struct draw_params params;
+    float offset_x = screen->offset_x;
+    float offset_y = screen->offset_y;
+
+    lightmap->drawn = 0;
+    lightmap->culled = 0;
+    if (set_render_target(buffer) != 0) {
+        ERROR("Unable to bind the lightmap buffer");
+        goto clear;
+    }
+    set_render_draw_color(lightmap->ambient);
+    SDL_RenderClear(screen->impl);
+    /* lights are placed relative to the lit area, not the shaking
+     * screen, which moves the whole buffer when it is drawn */
+    screen->offset_x = 0;
+    screen->offset_y = 0;
+    draw_lights(lightmap);
+    screen->offset_x = offset_x;
+    screen->offset_y = offset_y;
+    if (set_render_target(previous) != 0) {
+        ERROR("Unable to restore the render target");
+        goto clear;
+    }
+
+    whole.x = 0;
+    whole.y = 0;
+    whole.w = buffer->width;
+    whole.h = buffer->height;
+    params = default_draw_params();
+    params.scale_x = params.scale_y = (float)lightmap->scale;
+    render_image_ex(buffer, &whole, lightmap->x, lightmap->y, 0, 0, 0, 0,
+                    &params);
+
+clear:
+    lightmap->n_lights = 0;
+}
@@ -0,0 +1,134 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#ifndef LIGHTMAP_H_T5ZB2QEW
+#define LIGHTMAP_H_T5ZB2QEW
+
+#include "image.h"
+#include "color.h"
+
+#include "begin_prefix.h"
+/** Number of cone widths spot lights are rounded to */
+#define LIGHT_CONE_STEPS 36
+
+/**
+ * A point or spot light, added to a \ref lightmap using add_light().
+ * Lights are plain values, so keep them with your game objects.
+ */
+struct light {
+    /** x position of the light center */
+    float x;
+    /** y position of the light center */
+    float y;
+    /** distance at which the light fades out, in pixels */
+    float radius;
+    /** light color, its alpha is the light intensity */
+    struct color color;
+    /** spot light direction in degrees, clockwise from the x axis */
+    float direction;
+    /** spot light cone width in degrees, or 0 for a point light */
+    float cone;
+};
+
+/**
+ * Lightmaps darken the scene except where lights shine. Lights are
+ * accumulated in a buffer a fraction of the lit area size, which is
+ * then stretched and multiplied over everything drawn so far:
+ *
+ *     struct lightmap* lights = create_lightmap(width, height, 4);
+ *     lights->ambient = color_from_RGB(40, 40, 80);
+ *
+ * Then, every frame, after drawing the scene:
+ *
+ *     struct light torch = {x, y, 48};
+ *     torch.color = color_from_RGB(255, 200, 120);
+ *     add_light(lights, &torch);
+ *     draw_lightmap(lights);
+ *
+ * Lights are added together, so overlapping lights brighten each other.
+ * Drawing one light costs a single small quad in the buffer, and lights
+ * outside the lit area are skipped, so dozens of lights are cheap.
+ */
+struct lightmap {
+    /** x position of the lit area top-left corner */
+    float x;
+    /** y position of the lit area top-left corner */
+    float y;
+    /** lit area width in pixels */
+    int width;
+    /** lit area height in pixels */
+    int height;
+    /** lit area pixels per buffer pixel */
+    int scale;
+    /** light color where no light shines */
+    struct color ambient;
+    /** number of lights drawn by the last draw_lightmap() call */
+    int drawn;
+    /** number of lights outside the lit area in the last call */
+    int culled;
+    /* light buffer, a scale times smaller than the lit area */
+    struct image* buffer;
+    /* point light falloff and spot light cones, created when used */
+    struct image* falloff;
+    struct image* cones[LIGHT_CONE_STEPS];
+    /* lights added since the last draw */
+    struct light* lights;
+    int n_lights;
+    int capacity;
+};
+
+/**
+ * Allocate a new lightmap
+ * @param width lit area width in pixels, usually the screen width
+ * @param height lit area height in pixels, usually the screen height
+ * @param scale lit area pixels per light buffer pixel, e.g. 4 for a
+ * light buffer a quarter of the lit area size
+ *
+ * @return a new lightmap or NULL on error
+ */
+struct lightmap* create_lightmap(int width, int height, int scale);
+
+/**
+ * Destroy a lightmap created using create_lightmap()
+ * @param lightmap lightmap to destroy
+ */
+void destroy_lightmap(struct lightmap* lightmap);
+
+/**
+ * Add a light to the next draw_lightmap() call
+ * @param lightmap lightmap to light
+ * @param light light to add, copied into the lightmap
+ *
+ * @return 0 on success or -1 on failure
+ */
+int add_light(struct lightmap* lightmap, const struct light* light);
+
+/**
+ * Render the added lights and multiply them over the lit area
+ * @param lightmap lightmap to draw
+ *
+ * The lights list is emptied, so add the lights again for the next
+ * frame.
+ */
+void draw_lightmap(struct lightmap* lightmap);
+
+#include "end_prefix.h"
+#endif /* end of include guard: LIGHTMAP_H_T5ZB2QEW */
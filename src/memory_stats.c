@@ -0,0 +1,263 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "memory_stats.h"
+#include "internals.h"
+#include "utils.h"
+#include "SDL.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "begin_prefix.h"
+
+static const char* tag_names[NUM_OF_MEMORY_TAGS] = {
+    "engine",  "images",     "textures",  "sounds", "audio",    "fonts",
+    "sprites", "animations", "timelines", "tiles",  "particles", "paths",
+    "render",  "entities",   "jobs",      "arenas", "packs",
+    "snapshots"
+};
+
+const char* get_memory_tag_name(enum memory_tag tag)
+{
+    if ((int)tag < 0 || tag >= NUM_OF_MEMORY_TAGS) return "unknown";
+    return tag_names[tag];
+}
+
+#ifdef CAGE_TRACK_MEMORY
+
+/* Tracked allocations start with a header holding their size and tag,
+ * padded so the memory handed out keeps malloc() alignment. */
+#define HEADER_SIZE 16
+#define MAX_ASSET_PATH 128
+
+struct asset_record {
+    const void* key;
+    int tag;
+    size_t bytes;
+    char path[MAX_ASSET_PATH];
+};
+
+static struct memory_stats stats[NUM_OF_MEMORY_TAGS];
+static struct memory_stats total;
+static struct asset_record* assets = NULL;
+static int n_assets = 0;
+static int assets_capacity = 0;
+/* jobs may allocate too */
+static SDL_SpinLock lock = 0;
+
+static void account(int tag, size_t bytes, int count)
+{
+    struct memory_stats* s = &stats[tag];
+    SDL_AtomicLock(&lock);
+    if (count > 0) {
+        s->live_bytes += bytes;
+        s->live_count++;
+        s->total_count++;
+        total.live_bytes += bytes;
+        total.live_count++;
+        total.total_count++;
+    } else {
+        s->live_bytes -= bytes;
+        s->live_count--;
+        total.live_bytes -= bytes;
+        total.live_count--;
+    }
+    if (s->live_bytes > s->peak_bytes) s->peak_bytes = s->live_bytes;
+    if (total.live_bytes > total.peak_bytes)
+        total.peak_bytes = total.live_bytes;
+    SDL_AtomicUnlock(&lock);
+}
+
+static void* attach_header(char* block, size_t size, int tag)
+{
+    if (block == NULL) return NULL;
+    ((size_t*)block)[0] = size;
+    ((size_t*)block)[1] = (size_t)tag;
+    account(tag, size, 1);
+    return block + HEADER_SIZE;
+}
+
+void* tracked_malloc(size_t size, int tag)
+{
+    return attach_header((char*)malloc(size + HEADER_SIZE), size, tag);
+}
+
+void* tracked_calloc(size_t count, size_t size, int tag)
+{
+    char* block;
+    if (size != 0 && count > ((size_t)-1 - HEADER_SIZE) / size) return NULL;
+    block = (char*)calloc(1, count * size + HEADER_SIZE);
+    return attach_header(block, count * size, tag);
+}
+
+void* tracked_realloc(void* memory, size_t size, int tag)
+{
+    char* block;
+    size_t old_size;
+    int old_tag;
+
+    if (memory == NULL) return tracked_malloc(size, tag);
+    block = (char*)memory - HEADER_SIZE;
+    old_size = ((size_t*)block)[0];
+    old_tag = (int)((size_t*)block)[1];
+    block = (char*)realloc(block, size + HEADER_SIZE);
+    if (block == NULL) return NULL;
+    account(old_tag, old_size, -1);
+    return attach_header(block, size, tag);
+}
+
+void tracked_free(void* memory)
+{
+    char* block;
+    if (memory == NULL) return;
+    block = (char*)memory - HEADER_SIZE;
+    account((int)((size_t*)block)[1], ((size_t*)block)[0], -1);
+    free(block);
+}
+
+void track_asset(const void* key, int tag, const char* path, size_t bytes)
+{
+    struct asset_record* records;
+    struct asset_record* record;
+    int capacity;
+
+    if (key == NULL) return;
+    account(tag, bytes, 1);
+    SDL_AtomicLock(&lock);
+    if (n_assets == assets_capacity) {
+        capacity = assets_capacity == 0 ? 64 : assets_capacity * 2;
+        records = (struct asset_record*)realloc(
+        assets, capacity * sizeof(struct asset_record));
+        if (records == NULL) {
+            /* still counted by tag, only missing from snapshots */
+            SDL_AtomicUnlock(&lock);
+            return;
+        }
+        assets = records;
+        assets_capacity = capacity;
+    }
+    record = &assets[n_assets++];
+    record->key = key;
+    record->tag = tag;
+    record->bytes = bytes;
+    strncpy(record->path, path, MAX_ASSET_PATH - 1);
+    record->path[MAX_ASSET_PATH - 1] = '\0';
+    SDL_AtomicUnlock(&lock);
+}
+
+void untrack_asset(const void* key, int tag, size_t bytes)
+{
+    int i;
+    if (key == NULL) return;
+    account(tag, bytes, -1);
+    SDL_AtomicLock(&lock);
+    for (i = 0; i < n_assets; i++) {
+        if (assets[i].key == key) {
+            assets[i] = assets[--n_assets];
+            break;
+        }
+    }
+    SDL_AtomicUnlock(&lock);
+}
+
+bool is_memory_tracked(void)
+{
+    return true;
+}
+
+void get_memory_stats(enum memory_tag tag, struct memory_stats* s)
+{
+    SDL_AtomicLock(&lock);
+    *s = stats[tag];
+    SDL_AtomicUnlock(&lock);
+}
+
+void get_total_memory_stats(struct memory_stats* s)
+{
+    SDL_AtomicLock(&lock);
+    *s = total;
+    SDL_AtomicUnlock(&lock);
+}
+
+static void write_stats(FILE* fp, const char* name, struct memory_stats* s)
+{
+    fprintf(fp, "%-12s %12lu %12lu %10lu %10lu\n", name,
+            (unsigned long)s->live_bytes, (unsigned long)s->peak_bytes,
+            s->live_count, s->total_count);
+}
+
+int dump_memory_snapshot(const char* filepath)
+{
+    struct memory_stats s;
+    FILE* fp;
+    int i;
+
+    if ((fp = fopen(filepath, "w")) == NULL) {
+        ERROR("Unable to open the memory snapshot file");
+        return -1;
+    }
+    fprintf(fp, "%-12s %12s %12s %10s %10s\n", "# tag", "live", "peak",
+            "count", "total");
+    for (i = 0; i < NUM_OF_MEMORY_TAGS; i++) {
+        get_memory_stats((enum memory_tag)i, &s);
+        write_stats(fp, tag_names[i], &s);
+    }
+    get_total_memory_stats(&s);
+    write_stats(fp, "total", &s);
+    fprintf(fp, "\n%-12s %12s %s\n", "# asset", "bytes", "path");
+    SDL_AtomicLock(&lock);
+    for (i = 0; i < n_assets; i++)
+        fprintf(fp, "%-12s %12lu %s\n", tag_names[assets[i].tag],
+                (unsigned long)assets[i].bytes, assets[i].path);
+    SDL_AtomicUnlock(&lock);
+    if (fclose(fp) != 0) {
+        ERROR("Unable to write the memory snapshot file");
+        return -1;
+    }
+    return 0;
+}
+
+#else
+
+bool is_memory_tracked(void)
+{
+    return false;
+}
+
+void get_memory_stats(enum memory_tag tag, struct memory_stats* stats)
+{
+    UNUSED(tag);
+    memset(stats, 0, sizeof(struct memory_stats));
+}
+
+void get_total_memory_stats(struct memory_stats* stats)
+{
+    memset(stats, 0, sizeof(struct memory_stats));
+}
+
+int dump_memory_snapshot(const char* filepath)
+{
+    UNUSED(filepath);
+    ERROR("Memory tracking is not built in, define CAGE_TRACK_MEMORY");
+    return -1;
+}
+
+#endif
@@ -0,0 +1,121 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#ifndef MEMORY_STATS_H_Q6RV9ZHJ
+#define MEMORY_STATS_H_Q6RV9ZHJ
+
+#include <stddef.h>
+#include "types.h"
+
+#include "begin_prefix.h"
+/**
+ * Subsystems memory is accounted to. Texture and audio tags count
+ * the estimated size of SDL textures and the PCM data of sounds, the
+ * other tags count Cage allocations.
+ */
+enum memory_tag {
+    MEMORY_ENGINE,
+    MEMORY_IMAGES,
+    MEMORY_TEXTURES,
+    MEMORY_SOUNDS,
+    MEMORY_AUDIO,
+    MEMORY_FONTS,
+    MEMORY_SPRITES,
+    MEMORY_ANIMATIONS,
+    MEMORY_TIMELINES,
+    MEMORY_TILES,
+    MEMORY_PARTICLES,
+    MEMORY_PATHS,
+    MEMORY_RENDER,
+    MEMORY_ENTITIES,
+    MEMORY_JOBS,
+    MEMORY_ARENAS,
+    MEMORY_PACKS,
+    MEMORY_SNAPSHOTS,
+    NUM_OF_MEMORY_TAGS
+};
+
+/**
+ * Memory used by a subsystem, or by all of them.
+ *
+ * Memory tracking is opt-in: build Cage with CAGE_TRACK_MEMORY defined,
+ * e.g. using ``make TRACK_MEMORY=1``, and every allocation Cage makes,
+ * every texture and every sound buffer is accounted to a
+ * \ref memory_tag. Without it the stats stay zero and tracking costs
+ * nothing:
+ *
+ *     struct memory_stats stats;
+ *     get_memory_stats(MEMORY_TEXTURES, &stats);
+ *     printf("%lu bytes of textures\n", (unsigned long)stats.live_bytes);
+ *
+ * dump_memory_snapshot() writes the stats of every tag, and the size
+ * and path of every texture and sound, to a text file.
+ */
+struct memory_stats {
+    /** bytes in use */
+    size_t live_bytes;
+    /** most bytes ever in use at once */
+    size_t peak_bytes;
+    /** allocations in use */
+    unsigned long live_count;
+    /** allocations made so far */
+    unsigned long total_count;
+};
+
+/**
+ * Check if Cage was built with memory tracking
+ *
+ * @return true when CAGE_TRACK_MEMORY was defined
+ */
+bool is_memory_tracked(void);
+
+/**
+ * Get the memory used by a subsystem
+ * @param tag subsystem \ref memory_tag
+ * @param stats \ref memory_stats to fill
+ */
+void get_memory_stats(enum memory_tag tag, struct memory_stats* stats);
+
+/**
+ * Get the memory used by all subsystems
+ * @param stats \ref memory_stats to fill
+ */
+void get_total_memory_stats(struct memory_stats* stats);
+
+/**
+ * Get the name of a memory tag, e.g. "textures"
+ * @param tag \ref memory_tag
+ *
+ * @return tag name
+ */
+const char* get_memory_tag_name(enum memory_tag tag);
+
+/**
+ * Write the memory stats and the tracked assets to a text file
+ * @param filepath path of the file to write
+ *
+ * @return 0 on success or -1 on failure, including when memory
+ * tracking is not built in
+ */
+int dump_memory_snapshot(const char* filepath);
+
+#include "end_prefix.h"
+#endif /* end of include guard: MEMORY_STATS_H_Q6RV9ZHJ */
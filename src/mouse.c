@@ -24,15 +24,23 @@
 #include "SDL.h"
 
 #include "begin_prefix.h"
-void update_mouse(struct mouse* mouse)
+static struct mouse global_mouse;
+struct mouse* mouse_state = &global_mouse;
+
+void sample_mouse(void)
 {
     int x, y, w, h;
     Uint32 ms = SDL_GetMouseState(&x, &y);
     SDL_GetWindowSize(screen->window, &w, &h);
-    mouse->x_position = x / (w * 1.0);
-    mouse->y_position = y / (h * 1.0);
-    mouse->left_click = ms & SDL_BUTTON(SDL_BUTTON_LEFT);
-    mouse->right_click = ms & SDL_BUTTON(SDL_BUTTON_RIGHT);
-    mouse->middle_click = ms & SDL_BUTTON(SDL_BUTTON_MIDDLE);
+    mouse_state->x_position = x / (w * 1.0);
+    mouse_state->y_position = y / (h * 1.0);
+    mouse_state->left_click = ms & SDL_BUTTON(SDL_BUTTON_LEFT);
+    mouse_state->right_click = ms & SDL_BUTTON(SDL_BUTTON_RIGHT);
+    mouse_state->middle_click = ms & SDL_BUTTON(SDL_BUTTON_MIDDLE);
+}
+
+void update_mouse(struct mouse* mouse)
+{
+    *mouse = *mouse_state;
 }
 #include "end_prefix.h"
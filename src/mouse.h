@@ -42,6 +42,9 @@ struct mouse {
 
 /**
  * Query the current mouse state and update the passed mouse struct.
+ * The state is sampled once per frame, before the update function runs,
+ * so it is the recorded one while replaying input, see
+ * is_replaying_input().
  */
 void update_mouse(struct mouse* mouse);
 
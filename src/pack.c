@@ -0,0 +1,1013 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "pack.h"
+#include "internals.h"
+#include "jobs.h"
+#include "utils.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "begin_prefix.h"
+
+/* Pack file layout, all integers are 32 bit little endian:
+ *
+ *   header    magic, version, n_entries, n_buckets, n_slots, names_size
+ *   buckets   n_buckets hash seeds
+ *   slots     n_slots entry indices, or EMPTY_SLOT
+ *   entries   n_entries name offset, name length, data offset, size,
+ *             stored size and flags
+ *   names     names_size bytes of NUL terminated paths
+ *   data      entry data, each entry aligned to PACK_ALIGN bytes
+ *
+ * A path hashes with seed 0 to a bucket, and with the bucket seed to
+ * a slot. build_pack() picks the bucket seeds so no two paths share a
+ * slot, which makes the lookup a perfect hash.
+ *
+ * The data of an ENTRY_LZ4 entry is split into PACK_BLOCK_SIZE blocks,
+ * each compressed on its own using the LZ4 block format, so blocks
+ * decompress in parallel. The data starts with the end offset of every
+ * block, relative to the end of this table, with BLOCK_STORED set on
+ * blocks LZ4 did not shrink, which are stored as is.
+ */
+#define PACK_MAGIC "CPAK"
+#define PACK_VERSION 2
+#define HEADER_SIZE 24
+#define ENTRY_SIZE 24
+#define PACK_ALIGN 16
+#define PACK_BLOCK_SIZE (64 * 1024)
+#define ENTRY_LZ4 1u
+#define BLOCK_STORED 0x80000000u
+#define EMPTY_SLOT 0xFFFFFFFFu
+#define MAX_SEED 0xFFFFFu
+
+struct mounted_pack {
+    unsigned char* memory;
+    size_t size;
+    /* 1 when memory maps the pack file, 0 when it was read */
+    int mapped;
+    uint32_t n_entries;
+    uint32_t n_buckets;
+    uint32_t n_slots;
+    uint32_t names_size;
+    const unsigned char* buckets;
+    const unsigned char* slots;
+    const unsigned char* entries;
+    const char* names;
+    /* decompressed data of preloaded entries, or NULL */
+    unsigned char** preloaded;
+};
+
+struct pack_entry {
+    uint32_t offset;
+    uint32_t size;
+    uint32_t stored_size;
+    uint32_t flags;
+};
+
+static struct mounted_pack packs[MAX_PACKS];
+static int n_packs = 0;
+static struct pack_stats stats;
+
+static uint32_t read32(const unsigned char* p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+           (uint32_t)p[3] << 24;
+}
+
+static void write32_to(unsigned char* p, uint32_t value)
+{
+    p[0] = (unsigned char)value;
+    p[1] = (unsigned char)(value >> 8);
+    p[2] = (unsigned char)(value >> 16);
+    p[3] = (unsigned char)(value >> 24);
+}
+
+static int write32(SDL_RWops* rw, uint32_t value)
+{
+    unsigned char p[4];
+    write32_to(p, value);
+    return SDL_RWwrite(rw, p, 4, 1) == 1 ? 0 : -1;
+}
+
+static uint32_t hash_path(const char* path, uint32_t seed)
+{
+    /* FNV-1a, seeded, with a final mix so the low bits spread well */
+    uint32_t hash = 2166136261u ^ (seed * 2654435769u);
+    const unsigned char* c;
+    for (c = (const unsigned char*)path; *c != '\0'; c++) {
+        hash ^= *c;
+        hash *= 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 2246822507u;
+    hash ^= hash >> 13;
+    return hash;
+}
+
+/* Paths are stored and looked up without a leading "./" */
+static const char* entry_name(const char* path)
+{
+    while (path[0] == '.' && path[1] == '/') path += 2;
+    return path;
+}
+
+/* ----------------------------------------------------------------
+ * LZ4 block format
+ *
+ * A block is a run of sequences. Each sequence is a token byte holding
+ * the literal count and the match length minus MIN_MATCH in its high
+ * and low nibbles, extra literal count bytes when the nibble is 15,
+ * the literals, a 2 byte match offset and extra match length bytes.
+ * The last sequence has literals only. Matches start at least
+ * MATCH_LIMIT bytes before the end and leave the last LAST_LITERALS
+ * bytes alone.
+ * ---------------------------------------------------------------- */
+#define MIN_MATCH 4
+#define LAST_LITERALS 5
+#define MATCH_LIMIT 12
+#define MAX_DISTANCE 65535
+#define LZ4_HASH_BITS 12
+
+static uint32_t lz4_hash(const unsigned char* p)
+{
+    return (read32(p) * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+static unsigned char* write_length(unsigned char* op, size_t length)
+{
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = (unsigned char)length;
+    return op;
+}
+
+static unsigned char* write_sequence(unsigned char* op,
+                                     const unsigned char* literals,
+                                     size_t n_literals,
+                                     size_t offset,
+                                     size_t match_length)
+{
+    unsigned char* token = op++;
+    *token = (unsigned char)((n_literals < 15 ? n_literals : 15) << 4);
+    if (n_literals >= 15) op = write_length(op, n_literals - 15);
+    memcpy(op, literals, n_literals);
+    op += n_literals;
+    if (offset == 0) return op;
+    *op++ = (unsigned char)offset;
+    *op++ = (unsigned char)(offset >> 8);
+    match_length -= MIN_MATCH;
+    *token |= (unsigned char)(match_length < 15 ? match_length : 15);
+    if (match_length >= 15) op = write_length(op, match_length - 15);
+    return op;
+}
+
+/* Worst case size of a sequence with n literals and a match */
+#define SEQUENCE_BOUND(n, match) \
+    (1 + (n) / 255 + 1 + (n) + 2 + (match) / 255 + 1)
+
+/* Compress a block into dst, returning the compressed size, or 0 when
+ * it takes capacity bytes or more. table holds 1 << LZ4_HASH_BITS
+ * positions. */
+static size_t lz4_compress(const unsigned char* src,
+                           size_t size,
+                           unsigned char* dst,
+                           size_t capacity,
+                           uint32_t* table)
+{
+    const unsigned char* ip = src;
+    const unsigned char* anchor = src;
+    const unsigned char* ref;
+    const unsigned char* end = src + size;
+    const unsigned char* match_end;
+    unsigned char* op = dst;
+    uint32_t h;
+    size_t misses = 0;
+
+    memset(table, 0, sizeof(uint32_t) << LZ4_HASH_BITS);
+    while (size >= MATCH_LIMIT && ip <= end - MATCH_LIMIT) {
+        h = lz4_hash(ip);
+        ref = src + table[h];
+        table[h] = (uint32_t)(ip - src);
+        if (ref >= ip || ip - ref > MAX_DISTANCE || read32(ref) != read32(ip)) {
+            /* skip faster through data that does not compress */
+            ip += 1 + (misses++ >> 6);
+            continue;
+        }
+        misses = 0;
+        match_end = ip + MIN_MATCH;
+        ref += MIN_MATCH;
+        while (match_end < end - LAST_LITERALS && *match_end == *ref) {
+            match_end++;
+            ref++;
+        }
+        if ((size_t)(op - dst) + SEQUENCE_BOUND((size_t)(ip - anchor),
+                                                (size_t)(match_end - ip)) >=
+            capacity)
+            return 0;
+        op = write_sequence(op, anchor, (size_t)(ip - anchor),
+                            (size_t)(match_end - ref),
+                            (size_t)(match_end - ip));
+        ip = anchor = match_end;
+    }
+    if ((size_t)(op - dst) + SEQUENCE_BOUND((size_t)(end - anchor), 0) >=
+        capacity)
+        return 0;
+    op = write_sequence(op, anchor, (size_t)(end - anchor), 0, 0);
+    return (size_t)(op - dst);
+}
+
+static int read_length(const unsigned char** ip,
+                       const unsigned char* end,
+                       size_t* length)
+{
+    unsigned char b;
+    do {
+        if (*ip >= end) return -1;
+        b = *(*ip)++;
+        *length += b;
+    } while (b == 255);
+    return 0;
+}
+
+/* Decompress a block, which must fill exactly size bytes of dst.
+ * Returns 0 on success or -1 if the block is malformed. */
+static int lz4_decompress(const unsigned char* src,
+                          size_t src_size,
+                          unsigned char* dst,
+                          size_t size)
+{
+    const unsigned char* ip = src;
+    const unsigned char* end = src + src_size;
+    const unsigned char* match;
+    unsigned char* op = dst;
+    unsigned char* op_end = dst + size;
+    size_t length, offset;
+    unsigned char token;
+
+    while (ip < end) {
+        token = *ip++;
+        length = token >> 4;
+        if (length == 15 && read_length(&ip, end, &length) == -1) return -1;
+        if (length > (size_t)(end - ip) || length > (size_t)(op_end - op))
+            return -1;
+        memcpy(op, ip, length);
+        op += length;
+        ip += length;
+        if (ip == end) break;
+        if (end - ip < 2) return -1;
+        offset = (size_t)ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) return -1;
+        length = token & 15;
+        if (length == 15 && read_length(&ip, end, &length) == -1) return -1;
+        length += MIN_MATCH;
+        if (length > (size_t)(op_end - op)) return -1;
+        match = op - offset;
+        if (offset >= length) {
+            memcpy(op, match, length);
+            op += length;
+        } else {
+            /* the match overlaps the bytes it repeats */
+            while (length-- > 0) *op++ = *match++;
+        }
+    }
+    return op == op_end ? 0 : -1;
+}
+
+/* ---------------------------------------------------------------- */
+
+struct bucket_order {
+    uint32_t bucket;
+    uint32_t size;
+};
+
+static int compare_buckets(const void* a, const void* b)
+{
+    const struct bucket_order* x = (const struct bucket_order*)a;
+    const struct bucket_order* y = (const struct bucket_order*)b;
+    if (x->size != y->size) return x->size > y->size ? -1 : 1;
+    return x->bucket < y->bucket ? -1 : x->bucket > y->bucket;
+}
+
+/* Find a seed placing every path of a bucket in a free slot */
+static int place_bucket(const char** names,
+                        const uint32_t* members,
+                        uint32_t n_members,
+                        uint32_t* slots,
+                        uint32_t n_slots,
+                        uint32_t* seed)
+{
+    uint32_t s, i, j, slot;
+    for (i = 0; i < n_members; i++)
+        for (j = i + 1; j < n_members; j++)
+            if (strcmp(names[members[i]], names[members[j]]) == 0) {
+                ERROR("Duplicate path in pack");
+                return -1;
+            }
+    for (s = 1; s <= MAX_SEED; s++) {
+        for (i = 0; i < n_members; i++) {
+            slot = hash_path(names[members[i]], s) % n_slots;
+            if (slots[slot] != EMPTY_SLOT) break;
+            slots[slot] = members[i];
+        }
+        if (i == n_members) {
+            *seed = s;
+            return 0;
+        }
+        /* undo the members placed with this seed */
+        for (j = 0; j < i; j++)
+            slots[hash_path(names[members[j]], s) % n_slots] = EMPTY_SLOT;
+    }
+    ERROR("Unable to build the pack index");
+    return -1;
+}
+
+/* Read a file into memory, leaving size bytes or failing */
+static unsigned char* read_whole_file(const char* path, uint32_t size)
+{
+    unsigned char* data;
+    SDL_RWops* rw = SDL_RWFromFile(path, "rb");
+    if (rw == NULL) return NULL;
+    data = (unsigned char*)MALLOC(size > 0 ? size : 1, MEMORY_PACKS);
+    if (data != NULL && size > 0 && SDL_RWread(rw, data, size, 1) != 1) {
+        FREE(data);
+        data = NULL;
+    }
+    SDL_RWclose(rw);
+    return data;
+}
+
+/* Write the data of an entry, compressed when asked to and LZ4 shrinks
+ * it by at least an eighth, and store its stored size and flags */
+static int write_entry_data(SDL_RWops* out,
+                            const char* path,
+                            struct pack_entry* entry,
+                            uint32_t* table,
+                            bool compress)
+{
+    uint32_t n_blocks = (entry->size + PACK_BLOCK_SIZE - 1) / PACK_BLOCK_SIZE;
+    uint32_t i, block_size, stored = n_blocks * 4;
+    unsigned char* data = read_whole_file(path, entry->size);
+    unsigned char* packed = NULL;
+    size_t n;
+    int ret = -1;
+
+    if (data == NULL) return -1;
+    entry->stored_size = entry->size;
+    entry->flags = 0;
+    if (compress && n_blocks > 0)
+        packed = (unsigned char*)MALLOC(stored + entry->size, MEMORY_PACKS);
+    for (i = 0; packed != NULL && i < n_blocks; i++) {
+        block_size = entry->size - i * PACK_BLOCK_SIZE;
+        if (block_size > PACK_BLOCK_SIZE) block_size = PACK_BLOCK_SIZE;
+        n = lz4_compress(data + i * PACK_BLOCK_SIZE, block_size,
+                         packed + stored, block_size, table);
+        if (n == 0) {
+            memcpy(packed + stored, data + i * PACK_BLOCK_SIZE, block_size);
+            stored += block_size;
+            write32_to(packed + i * 4, (stored - n_blocks * 4) | BLOCK_STORED);
+        } else {
+            stored += (uint32_t)n;
+            write32_to(packed + i * 4, stored - n_blocks * 4);
+        }
+    }
+    if (packed != NULL && stored <= entry->size - entry->size / 8) {
+        entry->stored_size = stored;
+        entry->flags = ENTRY_LZ4;
+        ret = SDL_RWwrite(out, packed, stored, 1) == 1 ? 0 : -1;
+    } else {
+        ret = entry->size == 0 || SDL_RWwrite(out, data, entry->size, 1) == 1
+              ? 0
+              : -1;
+    }
+    FREE(packed);
+    FREE(data);
+    return ret;
+}
+
+static int write_padding(SDL_RWops* out, Uint64 offset)
+{
+    static const unsigned char zeros[PACK_ALIGN] = { 0 };
+    size_t n = (size_t)((PACK_ALIGN - offset % PACK_ALIGN) % PACK_ALIGN);
+    return n == 0 || SDL_RWwrite(out, zeros, 1, n) == n ? 0 : -1;
+}
+
+int build_pack(const char* filepath, const char** paths, int n_paths)
+{
+    return build_pack_ex(filepath, paths, n_paths, true);
+}
+
+int build_pack_ex(const char* filepath,
+                  const char** paths,
+                  int n_paths,
+                  bool compress)
+{
+    static const unsigned char empty_entry[ENTRY_SIZE] = { 0 };
+    uint32_t n = (uint32_t)n_paths;
+    uint32_t n_buckets, n_slots, names_size = 0, i, b;
+    struct pack_entry* entries = NULL;
+    uint32_t* starts = NULL;
+    uint32_t* members = NULL;
+    uint32_t* bucket_of = NULL;
+    uint32_t* filled = NULL;
+    uint32_t* seeds = NULL;
+    uint32_t* slots = NULL;
+    struct bucket_order* order = NULL;
+    const char** names = NULL;
+    uint32_t* table = NULL;
+    SDL_RWops* rw;
+    Sint64 size, offset;
+    int ret = -1;
+
+    if (n_paths < 0) {
+        ERROR("Invalid number of pack paths");
+        return -1;
+    }
+    n_buckets = n / 2 + 1;
+    n_slots = n + n / 4 + 1;
+    names = (const char**)MALLOC(sizeof(char*) * (n + 1), MEMORY_PACKS);
+    entries = (struct pack_entry*)MALLOC(
+    sizeof(struct pack_entry) * (n + 1), MEMORY_PACKS);
+    starts = (uint32_t*)CALLOC(n_buckets + 1, sizeof(uint32_t), MEMORY_PACKS);
+    members = (uint32_t*)MALLOC(sizeof(uint32_t) * (n + 1), MEMORY_PACKS);
+    bucket_of = (uint32_t*)MALLOC(sizeof(uint32_t) * (n + 1), MEMORY_PACKS);
+    filled = (uint32_t*)CALLOC(n_buckets, sizeof(uint32_t), MEMORY_PACKS);
+    seeds = (uint32_t*)CALLOC(n_buckets, sizeof(uint32_t), MEMORY_PACKS);
+    slots = (uint32_t*)MALLOC(sizeof(uint32_t) * n_slots, MEMORY_PACKS);
+    order = (struct bucket_order*)MALLOC(
+    sizeof(struct bucket_order) * n_buckets, MEMORY_PACKS);
+    table = (uint32_t*)MALLOC(sizeof(uint32_t) << LZ4_HASH_BITS, MEMORY_PACKS);
+    if (names == NULL || entries == NULL || starts == NULL || members == NULL ||
+        bucket_of == NULL || filled == NULL || seeds == NULL ||
+        slots == NULL || order == NULL || table == NULL) {
+        ERROR("Unable to allocate the pack index");
+        goto done;
+    }
+
+    /* entry names and sizes, and the bucket of every entry */
+    for (i = 0; i < n; i++) {
+        names[i] = entry_name(paths[i]);
+        rw = SDL_RWFromFile(paths[i], "rb");
+        if (rw == NULL) {
+            ERROR("Unable to open a file to pack");
+            goto done;
+        }
+        size = SDL_RWsize(rw);
+        SDL_RWclose(rw);
+        if (size < 0 || size > 0x7FFFFFFF) {
+            ERROR("Unable to pack a file of this size");
+            goto done;
+        }
+        entries[i].size = (uint32_t)size;
+        names_size += (uint32_t)strlen(names[i]) + 1;
+        bucket_of[i] = hash_path(names[i], 0) % n_buckets;
+        starts[bucket_of[i] + 1]++;
+    }
+    for (b = 0; b < n_buckets; b++) {
+        order[b].bucket = b;
+        order[b].size = starts[b + 1];
+        starts[b + 1] += starts[b];
+    }
+    for (i = 0; i < n; i++)
+        members[starts[bucket_of[i]] + filled[bucket_of[i]]++] = i;
+
+    /* place the biggest buckets first, while most slots are free */
+    qsort(order, n_buckets, sizeof(struct bucket_order), compare_buckets);
+    for (i = 0; i < n_slots; i++) slots[i] = EMPTY_SLOT;
+    for (b = 0; b < n_buckets && order[b].size > 0; b++) {
+        if (place_bucket(names, members + starts[order[b].bucket],
+                         order[b].size, slots, n_slots,
+                         &seeds[order[b].bucket]) == -1)
+            goto done;
+    }
+
+    rw = SDL_RWFromFile(filepath, "wb");
+    if (rw == NULL) {
+        ERROR("Unable to open the pack file for writing");
+        goto done;
+    }
+    if (SDL_RWwrite(rw, PACK_MAGIC, 4, 1) != 1 ||
+        write32(rw, PACK_VERSION) == -1 || write32(rw, n) == -1 ||
+        write32(rw, n_buckets) == -1 || write32(rw, n_slots) == -1 ||
+        write32(rw, names_size) == -1)
+        goto write_error;
+    for (b = 0; b < n_buckets; b++)
+        if (write32(rw, seeds[b]) == -1) goto write_error;
+    for (i = 0; i < n_slots; i++)
+        if (write32(rw, slots[i]) == -1) goto write_error;
+
+    /* the entry table is written once the data is, as stored sizes
+     * are only known after compressing */
+    offset = SDL_RWtell(rw);
+    for (i = 0; i < n; i++)
+        if (SDL_RWwrite(rw, empty_entry, ENTRY_SIZE, 1) != 1)
+            goto write_error;
+    for (i = 0; i < n; i++)
+        if (SDL_RWwrite(rw, names[i], strlen(names[i]) + 1, 1) != 1)
+            goto write_error;
+    for (i = 0; i < n; i++) {
+        if (write_padding(rw, (Uint64)SDL_RWtell(rw)) == -1) goto write_error;
+        entries[i].offset = (uint32_t)SDL_RWtell(rw);
+        if (write_entry_data(rw, paths[i], &entries[i], table, compress) == -1)
+            goto write_error;
+        if (SDL_RWtell(rw) > (Sint64)0xFFFFFFFFu) {
+            ERROR("Pack file is too big");
+            goto close;
+        }
+    }
+    if (SDL_RWseek(rw, offset, RW_SEEK_SET) != offset) goto write_error;
+    names_size = 0;
+    for (i = 0; i < n; i++) {
+        if (write32(rw, names_size) == -1 ||
+            write32(rw, (uint32_t)strlen(names[i])) == -1 ||
+            write32(rw, entries[i].offset) == -1 ||
+            write32(rw, entries[i].size) == -1 ||
+            write32(rw, entries[i].stored_size) == -1 ||
+            write32(rw, entries[i].flags) == -1)
+            goto write_error;
+        names_size += (uint32_t)strlen(names[i]) + 1;
+    }
+    ret = 0;
+    goto close;
+write_error:
+    ERROR("Unable to write the pack file");
+close:
+    if (SDL_RWclose(rw) != 0) ret = -1;
+done:
+    FREE(table);
+    FREE(order);
+    FREE(slots);
+    FREE(seeds);
+    FREE(filled);
+    FREE(bucket_of);
+    FREE(members);
+    FREE(starts);
+    FREE(entries);
+    FREE(names);
+    return ret;
+}
+
+/* ---------------------------------------------------------------- */
+
+/* Map the pack file into memory, when the platform can */
+static int map_pack(struct mounted_pack* pack, const char* filepath)
+{
+    void* memory;
+    if (map_file_memory(filepath, &memory, &pack->size) == -1) return -1;
+    pack->memory = (unsigned char*)memory;
+    pack->mapped = 1;
+    return 0;
+}
+
+/* Read the whole pack file into memory. Android assets live inside
+ * the APK and can only be read this way.
+ */
+static int read_pack(struct mounted_pack* pack, const char* filepath)
+{
+    Sint64 size;
+    SDL_RWops* rw = SDL_RWFromFile(filepath, "rb");
+    if (rw == NULL) return -1;
+    size = SDL_RWsize(rw);
+    if (size > 0 && (Uint64)size <= (size_t)-1)
+        pack->memory = (unsigned char*)MALLOC((size_t)size, MEMORY_PACKS);
+    if (pack->memory != NULL &&
+        SDL_RWread(rw, pack->memory, (size_t)size, 1) != 1) {
+        FREE(pack->memory);
+        pack->memory = NULL;
+    }
+    SDL_RWclose(rw);
+    if (pack->memory == NULL) return -1;
+    pack->size = (size_t)size;
+    pack->mapped = 0;
+    return 0;
+}
+
+static void release_preloaded(struct mounted_pack* pack)
+{
+    uint32_t i;
+    if (pack->preloaded == NULL) return;
+    for (i = 0; i < pack->n_entries; i++) FREE(pack->preloaded[i]);
+    FREE(pack->preloaded);
+    pack->preloaded = NULL;
+}
+
+static void release_pack(struct mounted_pack* pack)
+{
+    release_preloaded(pack);
+    if (pack->memory == NULL) return;
+    if (pack->mapped)
+        unmap_file_memory(pack->memory, pack->size);
+    else
+        FREE(pack->memory);
+    pack->memory = NULL;
+}
+
+/* Take a table of count items, size bytes each, from the pack at
+ * offset, or NULL if the pack is too short */
+static const unsigned char* take_table(const struct mounted_pack* pack,
+                                       size_t* offset,
+                                       uint32_t count,
+                                       size_t size)
+{
+    const unsigned char* table = pack->memory + *offset;
+    if (count > (pack->size - *offset) / size) return NULL;
+    *offset += count * size;
+    return table;
+}
+
+int mount_pack(const char* filepath)
+{
+    struct mounted_pack* pack;
+    size_t offset = HEADER_SIZE;
+    if (n_packs == MAX_PACKS) {
+        ERROR("Too many mounted packs");
+        return -1;
+    }
+    pack = &packs[n_packs];
+    memset(pack, 0, sizeof(struct mounted_pack));
+    if (map_pack(pack, filepath) == -1 && read_pack(pack, filepath) == -1) {
+        ERROR("Unable to open the pack file");
+        return -1;
+    }
+    if (pack->size < HEADER_SIZE ||
+        memcmp(pack->memory, PACK_MAGIC, 4) != 0 ||
+        read32(pack->memory + 4) != PACK_VERSION) {
+        ERROR("Not a supported pack file");
+        goto error;
+    }
+    pack->n_entries = read32(pack->memory + 8);
+    pack->n_buckets = read32(pack->memory + 12);
+    pack->n_slots = read32(pack->memory + 16);
+    pack->names_size = read32(pack->memory + 20);
+    pack->buckets = take_table(pack, &offset, pack->n_buckets, 4);
+    pack->slots = take_table(pack, &offset, pack->n_slots, 4);
+    pack->entries = take_table(pack, &offset, pack->n_entries, ENTRY_SIZE);
+    pack->names = (const char*)take_table(pack, &offset, pack->names_size, 1);
+    if (pack->n_buckets == 0 || pack->n_slots == 0 || pack->buckets == NULL ||
+        pack->slots == NULL || pack->entries == NULL || pack->names == NULL) {
+        ERROR("Pack file is truncated");
+        goto error;
+    }
+    n_packs++;
+    return 0;
+error:
+    release_pack(pack);
+    return -1;
+}
+
+void unmount_packs(void)
+{
+    while (n_packs > 0) release_pack(&packs[--n_packs]);
+}
+
+/* Find the entry a path is stored in, returning its index or -1 */
+static int find_entry(const struct mounted_pack* pack,
+                      const char* name,
+                      struct pack_entry* found)
+{
+    const unsigned char* entry;
+    uint32_t seed, index, name_offset, length;
+    seed = read32(pack->buckets + hash_path(name, 0) % pack->n_buckets * 4);
+    index =
+    read32(pack->slots + hash_path(name, seed) % pack->n_slots * 4);
+    if (index >= pack->n_entries) return -1;
+    entry = pack->entries + (size_t)index * ENTRY_SIZE;
+    name_offset = read32(entry);
+    length = read32(entry + 4);
+    if (name_offset > pack->names_size ||
+        length >= pack->names_size - name_offset ||
+        strncmp(pack->names + name_offset, name, length) != 0 ||
+        name[length] != '\0')
+        return -1;
+    found->offset = read32(entry + 8);
+    found->size = read32(entry + 12);
+    found->stored_size = read32(entry + 16);
+    found->flags = read32(entry + 20);
+    if (found->offset > pack->size ||
+        found->stored_size > pack->size - found->offset ||
+        found->size > 0x7FFFFFFF ||
+        ((found->flags & ENTRY_LZ4) == 0 &&
+         found->stored_size != found->size))
+        return -1;
+    return (int)index;
+}
+
+/* A compressed entry being decompressed, one block per task */
+struct entry_load {
+    struct mounted_pack* pack;
+    int index;
+    const unsigned char* table;
+    uint32_t n_blocks;
+    uint32_t size;
+    uint32_t stored_size;
+    unsigned char* data;
+    SDL_atomic_t failed;
+};
+
+struct block_task {
+    struct entry_load* load;
+    uint32_t block;
+};
+
+static int begin_load(struct mounted_pack* pack,
+                      int index,
+                      const struct pack_entry* entry,
+                      struct entry_load* load)
+{
+    load->pack = pack;
+    load->index = index;
+    load->table = pack->memory + entry->offset;
+    load->n_blocks = (entry->size + PACK_BLOCK_SIZE - 1) / PACK_BLOCK_SIZE;
+    load->size = entry->size;
+    load->stored_size = entry->stored_size;
+    load->data = NULL;
+    SDL_AtomicSet(&load->failed, 0);
+    if (load->n_blocks == 0 || entry->stored_size < load->n_blocks * 4) {
+        ERROR("Pack entry is corrupt");
+        return -1;
+    }
+    load->data = (unsigned char*)MALLOC(entry->size, MEMORY_PACKS);
+    if (load->data == NULL) {
+        ERROR("Unable to allocate a pack entry");
+        return -1;
+    }
+    return 0;
+}
+
+static int decompress_block(const struct entry_load* load, uint32_t block)
+{
+    const unsigned char* blocks = load->table + load->n_blocks * 4;
+    uint32_t blocks_size = load->stored_size - load->n_blocks * 4;
+    uint32_t start = 0;
+    uint32_t end = read32(load->table + block * 4);
+    uint32_t size = load->size - block * PACK_BLOCK_SIZE;
+    unsigned char* dst = load->data + (size_t)block * PACK_BLOCK_SIZE;
+    if (block > 0)
+        start = read32(load->table + (block - 1) * 4) & ~BLOCK_STORED;
+    if (size > PACK_BLOCK_SIZE) size = PACK_BLOCK_SIZE;
+    if (start > (end & ~BLOCK_STORED) || (end & ~BLOCK_STORED) > blocks_size)
+        return -1;
+    if ((end & BLOCK_STORED) == 0)
+        return lz4_decompress(blocks + start, end - start, dst, size);
+    end &= ~BLOCK_STORED;
+    if (end - start != size) return -1;
+    memcpy(dst, blocks + start, size);
+    return 0;
+}
+
+static void decompress_blocks(void* data, int begin, int end)
+{
+    struct block_task* tasks = (struct block_task*)data;
+    int i;
+    for (i = begin; i < end; i++)
+        if (decompress_block(tasks[i].load, tasks[i].block) == -1)
+            SDL_AtomicSet(&tasks[i].load->failed, 1);
+}
+
+/* Decompress the blocks of a batch of loads on all workers */
+static int run_loads(struct entry_load* loads, int n_loads)
+{
+    struct block_task* tasks;
+    Uint64 start = SDL_GetPerformanceCounter();
+    int i, n_tasks = 0;
+    uint32_t b;
+    for (i = 0; i < n_loads; i++) n_tasks += (int)loads[i].n_blocks;
+    tasks = (struct block_task*)MALLOC(
+    sizeof(struct block_task) * (n_tasks + 1), MEMORY_PACKS);
+    if (tasks == NULL) {
+        ERROR("Unable to allocate the pack decompression tasks");
+        return -1;
+    }
+    n_tasks = 0;
+    for (i = 0; i < n_loads; i++) {
+        for (b = 0; b < loads[i].n_blocks; b++) {
+            tasks[n_tasks].load = &loads[i];
+            tasks[n_tasks++].block = b;
+        }
+        stats.decompressed_bytes += loads[i].size;
+    }
+    parallel_for(n_tasks, 1, decompress_blocks, tasks);
+    FREE(tasks);
+    stats.decompress_ms += (float)(SDL_GetPerformanceCounter() - start) *
+                           1000.0f / SDL_GetPerformanceFrequency();
+    return 0;
+}
+
+static int SDLCALL close_loaded_entry(SDL_RWops* rw)
+{
+    FREE(rw->hidden.mem.base);
+    SDL_FreeRW(rw);
+    return 0;
+}
+
+/* SDL_RWFromConstMem() refuses empty memory, so empty entries are read
+ * through a stream of their own */
+static Sint64 SDLCALL size_empty_entry(SDL_RWops* rw)
+{
+    UNUSED(rw);
+    return 0;
+}
+
+static Sint64 SDLCALL seek_empty_entry(SDL_RWops* rw, Sint64 offset, int whence)
+{
+    UNUSED(rw);
+    UNUSED(offset);
+    UNUSED(whence);
+    return 0;
+}
+
+static size_t SDLCALL read_empty_entry(SDL_RWops* rw,
+                                       void* ptr,
+                                       size_t size,
+                                       size_t maxnum)
+{
+    UNUSED(rw);
+    UNUSED(ptr);
+    UNUSED(size);
+    UNUSED(maxnum);
+    return 0;
+}
+
+static size_t SDLCALL write_empty_entry(SDL_RWops* rw,
+                                        const void* ptr,
+                                        size_t size,
+                                        size_t num)
+{
+    UNUSED(rw);
+    UNUSED(ptr);
+    UNUSED(size);
+    UNUSED(num);
+    return 0;
+}
+
+static int SDLCALL close_empty_entry(SDL_RWops* rw)
+{
+    SDL_FreeRW(rw);
+    return 0;
+}
+
+static SDL_RWops* open_empty_entry(void)
+{
+    SDL_RWops* rw = SDL_AllocRW();
+    if (rw == NULL) {
+        ERROR("Unable to open an empty pack entry");
+        return NULL;
+    }
+    rw->size = size_empty_entry;
+    rw->seek = seek_empty_entry;
+    rw->read = read_empty_entry;
+    rw->write = write_empty_entry;
+    rw->close = close_empty_entry;
+    rw->type = SDL_RWOPS_UNKNOWN;
+    return rw;
+}
+
+static SDL_RWops* open_entry(struct mounted_pack* pack,
+                             int index,
+                             const struct pack_entry* entry)
+{
+    struct entry_load load;
+    SDL_RWops* rw = NULL;
+    stats.packed_opens++;
+    if (entry->size == 0) return open_empty_entry();
+    if ((entry->flags & ENTRY_LZ4) == 0)
+        return SDL_RWFromConstMem(pack->memory + entry->offset,
+                                  (int)entry->size);
+    if (pack->preloaded != NULL && pack->preloaded[index] != NULL)
+        return SDL_RWFromConstMem(pack->preloaded[index], (int)entry->size);
+    if (begin_load(pack, index, entry, &load) == -1) goto error;
+    if (run_loads(&load, 1) == -1) goto error;
+    if (SDL_AtomicGet(&load.failed)) {
+        ERROR("Unable to decompress a pack entry");
+        goto error;
+    }
+    rw = SDL_RWFromConstMem(load.data, (int)load.size);
+    if (rw == NULL) goto error;
+    /* the decompressed data goes away with the SDL_RWops */
+    rw->close = close_loaded_entry;
+    return rw;
+error:
+    FREE(load.data);
+    return NULL;
+}
+
+SDL_RWops* open_asset(const char* path)
+{
+    const char* name = entry_name(path);
+    struct pack_entry entry;
+    SDL_RWops* rw;
+    int i, index;
+    for (i = n_packs - 1; i >= 0; i--) {
+        if ((index = find_entry(&packs[i], name, &entry)) != -1)
+            return open_entry(&packs[i], index, &entry);
+    }
+    rw = SDL_RWFromFile(path, "rb");
+    if (rw != NULL) stats.loose_opens++;
+    return rw;
+}
+
+int preload_assets(const char** paths, int n_paths)
+{
+    struct entry_load* loads;
+    struct mounted_pack* pack;
+    struct pack_entry entry;
+    const char* name;
+    int i, p, index, n_loads = 0, ret = 0;
+
+    loads = (struct entry_load*)MALLOC(
+    sizeof(struct entry_load) * (n_paths + 1), MEMORY_PACKS);
+    if (loads == NULL) {
+        ERROR("Unable to allocate the pack preload");
+        return -1;
+    }
+    for (i = 0; i < n_paths; i++) {
+        name = entry_name(paths[i]);
+        for (p = n_packs - 1; p >= 0; p--)
+            if ((index = find_entry(&packs[p], name, &entry)) != -1) break;
+        /* loose files and stored entries need no preloading */
+        if (p < 0 || (entry.flags & ENTRY_LZ4) == 0) continue;
+        pack = &packs[p];
+        if (pack->preloaded == NULL)
+            pack->preloaded = (unsigned char**)CALLOC(
+            pack->n_entries, sizeof(unsigned char*), MEMORY_PACKS);
+        if (pack->preloaded == NULL) {
+            ERROR("Unable to allocate the pack preload");
+            ret = -1;
+            break;
+        }
+        if (pack->preloaded[index] != NULL) continue;
+        if (begin_load(pack, index, &entry, &loads[n_loads]) == -1) {
+            ret = -1;
+            continue;
+        }
+        pack->preloaded[index] = loads[n_loads++].data;
+    }
+    if (run_loads(loads, n_loads) == -1) {
+        for (i = 0; i < n_loads; i++) SDL_AtomicSet(&loads[i].failed, 1);
+    }
+    for (i = 0; i < n_loads; i++) {
+        if (!SDL_AtomicGet(&loads[i].failed)) continue;
+        loads[i].pack->preloaded[loads[i].index] = NULL;
+        FREE(loads[i].data);
+        ERROR("Unable to decompress a pack entry");
+        ret = -1;
+    }
+    FREE(loads);
+    return ret;
+}
+
+void release_preloaded_assets(void)
+{
+    int i;
+    for (i = 0; i < n_packs; i++) release_preloaded(&packs[i]);
+}
+
+void get_pack_stats(struct pack_stats* pack_stats)
+{
+    *pack_stats = stats;
+}
+
+char* read_text_asset(const char* path, size_t* length, int tag)
+{
+    char* buf;
+    Sint64 size;
+    SDL_RWops* rw = open_asset(path);
+    UNUSED(tag);
+    if (rw == NULL) return NULL;
+    size = SDL_RWsize(rw);
+    buf = size < 0 ? NULL : (char*)MALLOC((size_t)size + 1, tag);
+    if (buf != NULL) {
+        if (size > 0 && SDL_RWread(rw, buf, (size_t)size, 1) != 1) {
+            FREE(buf);
+            buf = NULL;
+        } else {
+            buf[size] = '\0';
+            *length = (size_t)size;
+        }
+    }
+    SDL_RWclose(rw);
+    return buf;
+}
+#include "end_prefix.h"
@@ -0,0 +1,168 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#ifndef PACK_H_J5DW8QXN
+#define PACK_H_J5DW8QXN
+
+#include "SDL.h"
+#include "types.h"
+
+#include "begin_prefix.h"
+/** Pack mounted by the game loop before setup, when the file exists */
+#define DEFAULT_PACK "res.pak"
+
+/** Most packs that can be mounted at once */
+#define MAX_PACKS 8
+
+/**
+ * Packs bundle game assets in a single indexed file. Shipping one
+ * pack instead of hundreds of loose files saves a file open per asset,
+ * and a mounted pack is mapped into memory once, so loading an asset
+ * decodes straight from the mapping without reading or copying it.
+ *
+ * Build a pack from your asset files with the pack sample, or in a
+ * small tool of your own that runs as part of your build:
+ *
+ *     const char* assets[] = { "res/hero.png", "res/jump.ogg" };
+ *     build_pack("res.pak", assets, 2);
+ *
+ * Each asset is stored under the path it was read from. Once the pack
+ * is mounted, every Cage loader looks the path up in the mounted packs
+ * before going to the file system, so the game code stays the same:
+ *
+ *     mount_pack("res.pak");
+ *     hero = create_image("res/hero.png");
+ *
+ * The game loop mounts \ref DEFAULT_PACK before calling the setup
+ * function, when the file exists, so even the configuration file can
+ * come from a pack. Paths are looked up using a perfect hash built with
+ * the pack, which costs two hashes and a single string compare.
+ *
+ * build_pack() compresses the assets LZ4 shrinks by at least an eighth,
+ * like WAV files, and stores the others, like PNG files, as they are.
+ * Compressed assets are split into blocks that decompress in parallel
+ * on the job workers when opened. To decompress many of them at once,
+ * e.g. while a level loads, preload them in a single batch:
+ *
+ *     const char* level[] = { "res/level1.png", "res/rain.wav" };
+ *     preload_assets(level, 2);
+ *     ...create the level images and sounds...
+ *     release_preloaded_assets();
+ *
+ * Mount, preload and release packs from the main thread. The counters
+ * filled by get_pack_stats() help comparing loading times with and
+ * without packs, and running the pack sample with --bench times
+ * loading your assets from loose files, a stored and an LZ4 pack.
+ */
+struct pack_stats {
+    /** assets opened from packs */
+    unsigned long packed_opens;
+    /** assets opened from loose files */
+    unsigned long loose_opens;
+    /** bytes of compressed assets decompressed */
+    size_t decompressed_bytes;
+    /** milliseconds spent decompressing */
+    float decompress_ms;
+};
+
+/**
+ * Build a pack from asset files
+ * @param filepath path of the pack file to write
+ * @param paths paths of the asset files to add, which are also the
+ * paths the assets are looked up by
+ * @param n_paths number of paths
+ *
+ * @return 0 on success or -1 on error
+ */
+int build_pack(const char* filepath, const char** paths, int n_paths);
+
+/**
+ * Build a pack from asset files, optionally storing every asset as it
+ * is, e.g. to compare loading times with and without compression
+ * @param filepath path of the pack file to write
+ * @param paths paths of the asset files to add, which are also the
+ * paths the assets are looked up by
+ * @param n_paths number of paths
+ * @param compress false to store every asset uncompressed, true to
+ * compress assets as build_pack() does
+ *
+ * @return 0 on success or -1 on error
+ */
+int build_pack_ex(const char* filepath,
+                  const char** paths,
+                  int n_paths,
+                  bool compress);
+
+/**
+ * Mount a pack, so assets are looked up in it before the file system
+ * and before the packs mounted earlier.
+ * @param filepath path to the pack file
+ *
+ * @return 0 on success or -1 on error
+ */
+int mount_pack(const char* filepath);
+
+/**
+ * Decompress compressed pack assets ahead of opening them, in a
+ * single batch spread over the job workers. Assets stay decompressed
+ * until release_preloaded_assets() or unmount_packs() is called.
+ * @param paths asset paths. Loose files and assets that are not
+ * compressed need no preloading and are skipped.
+ * @param n_paths number of paths
+ *
+ * @return 0 on success or -1 if some assets could not be decompressed
+ */
+int preload_assets(const char** paths, int n_paths);
+
+/**
+ * Free the assets decompressed by preload_assets(). SDL_RWops opened
+ * for them must be closed before.
+ */
+void release_preloaded_assets(void);
+
+/**
+ * Get the pack counters
+ * @param stats \ref pack_stats to fill
+ */
+void get_pack_stats(struct pack_stats* stats);
+
+/**
+ * Unmount all packs. SDL_RWops returned by open_asset() for pack
+ * entries must be closed before.
+ */
+void unmount_packs(void);
+
+/**
+ * Open an asset for reading, from the mounted packs or the file system.
+ * @param path asset path
+ *
+ * @return SDL_RWops for the asset, to be closed using SDL_RWclose(),
+ * or NULL if the asset is not found
+ *
+ * Pack entries that are not compressed, and preloaded entries, are
+ * opened using SDL_RWFromConstMem() over memory that is already there,
+ * so opening them allocates no buffers and reads nothing. Compressed
+ * entries are decompressed into a buffer freed by SDL_RWclose().
+ */
+SDL_RWops* open_asset(const char* path);
+
+#include "end_prefix.h"
+#endif /* end of include guard: PACK_H_J5DW8QXN */
@@ -0,0 +1,399 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "particles.h"
+#include "internals.h"
+#include "jobs.h"
+#include "utils.h"
+#include <math.h>
+#include <stdlib.h>
+
+/* SDL_RenderGeometry() draws all the particles of an emitter in one call.
+ * Older SDL versions draw them one by one. */
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+#define RENDER_GEOMETRY 1
+
+/* Defined ahead of the prefix macros, which would rename the SDL_Vertex
+ * color member. */
+static void put_vertex(SDL_Vertex* vertex,
+                       float x,
+                       float y,
+                       float u,
+                       float v,
+                       SDL_Color c)
+{
+    vertex->position.x = x;
+    vertex->position.y = y;
+    vertex->tex_coord.x = u;
+    vertex->tex_coord.y = v;
+    vertex->color = c;
+}
+#endif
+
+#include "begin_prefix.h"
+
+/* number of float arrays in the per-particle block */
+#define FLOAT_ARRAYS 7
+
+struct particle_emitter* create_particle_emitter(struct image* image,
+                                                 int capacity)
+{
+    struct particle_emitter* emitter;
+    char* block;
+    int i;
+    size_t floats = sizeof(float) * FLOAT_ARRAYS * capacity;
+
+    if (capacity <= 0) {
+        ERROR("Particle emitter capacity must be positive");
+        return NULL;
+    }
+    emitter = (struct particle_emitter*)CALLOC(1,
+                                               sizeof(struct particle_emitter),
+                                               MEMORY_PARTICLES);
+    if (emitter == NULL) goto error;
+    /* all per-particle arrays share a single allocation */
+    block = (char*)MALLOC(
+    floats + sizeof(struct color) * capacity, MEMORY_PARTICLES);
+    if (block == NULL) goto free_emitter;
+    emitter->x_positions = (float*)block;
+    emitter->y_positions = emitter->x_positions + capacity;
+    emitter->x_velocities = emitter->y_positions + capacity;
+    emitter->y_velocities = emitter->x_velocities + capacity;
+    emitter->life = emitter->y_velocities + capacity;
+    emitter->inv_lifetime = emitter->life + capacity;
+    emitter->scales = emitter->inv_lifetime + capacity;
+    emitter->colors = (struct color*)(block + floats);
+
+#ifdef RENDER_GEOMETRY
+    emitter->vertices = MALLOC(
+    sizeof(SDL_Vertex) * 4 * capacity, MEMORY_PARTICLES);
+    if (emitter->vertices == NULL) goto free_block;
+    emitter->indices = (int*)MALLOC(
+    sizeof(int) * 6 * capacity, MEMORY_PARTICLES);
+    if (emitter->indices == NULL) goto free_vertices;
+    /* every particle is a quad made of two triangles */
+    for (i = 0; i < capacity; i++) {
+        emitter->indices[i * 6] = i * 4;
+        emitter->indices[i * 6 + 1] = i * 4 + 1;
+        emitter->indices[i * 6 + 2] = i * 4 + 2;
+        emitter->indices[i * 6 + 3] = i * 4;
+        emitter->indices[i * 6 + 4] = i * 4 + 2;
+        emitter->indices[i * 6 + 5] = i * 4 + 3;
+    }
+#else
+    UNUSED(i);
+#endif
+
+    emitter->image = image;
+    emitter->capacity = capacity;
+    emitter->angle_spread = 180;
+    emitter->min_speed = 50;
+    emitter->max_speed = 50;
+    emitter->min_life = 1000;
+    emitter->max_life = 1000;
+    emitter->start_scale = 1;
+    emitter->end_scale = 1;
+    emitter->start_color = color_from_RGBA(255, 255, 255, 255);
+    emitter->end_color = color_from_RGBA(255, 255, 255, 0);
+    emitter->seed = 0x9e3779b9;
+    return emitter;
+
+#ifdef RENDER_GEOMETRY
+free_vertices:
+    FREE(emitter->vertices);
+free_block:
+    FREE(block);
+#endif
+free_emitter:
+    FREE(emitter);
+error:
+    ERROR("Unable to allocate a particle emitter");
+    return NULL;
+}
+
+void destroy_particle_emitter(struct particle_emitter* emitter)
+{
+    if (emitter != NULL) {
+        FREE(emitter->indices);
+        FREE(emitter->vertices);
+        FREE(emitter->x_positions);
+        FREE(emitter);
+    }
+}
+
+/* xorshift32, good enough for scattering particles and cheap */
+static float random_range(uint32_t* seed, float from, float to)
+{
+    uint32_t x = *seed;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *seed = x;
+    return from + (to - from) * (float)(x >> 8) * (1.0f / 16777216.0f);
+}
+
+static uint8_t mix_channel(uint8_t from, uint8_t to, float amount)
+{
+    float value = from + (to - from) * amount + 0.5f;
+    /* back and elastic easing functions overshoot */
+    if (value < 0) return 0;
+    if (value > 255) return 255;
+    return (uint8_t)value;
+}
+
+static void build_ramp(struct particle_emitter* emitter)
+{
+    struct color* from = &emitter->start_color;
+    struct color* to = &emitter->end_color;
+    int i;
+    for (i = 0; i < PARTICLE_RAMP_SIZE; i++) {
+        float p = (float)i / (PARTICLE_RAMP_SIZE - 1);
+        float c = emitter->color_easing ? emitter->color_easing(p) : p;
+        float a = emitter->alpha_easing ? emitter->alpha_easing(p) : p;
+        emitter->ramp[i].red = mix_channel(from->red, to->red, c);
+        emitter->ramp[i].green = mix_channel(from->green, to->green, c);
+        emitter->ramp[i].blue = mix_channel(from->blue, to->blue, c);
+        emitter->ramp[i].alpha = mix_channel(from->alpha, to->alpha, a);
+    }
+}
+
+int emit_particles(struct particle_emitter* emitter, int count)
+{
+    int i, end;
+    float angle, speed, life;
+
+    if (count > emitter->capacity - emitter->count)
+        count = emitter->capacity - emitter->count;
+    end = emitter->count + count;
+    for (i = emitter->count; i < end; i++) {
+        emitter->x_positions[i] =
+        emitter->x + random_range(&emitter->seed, -emitter->spread_x,
+                                  emitter->spread_x);
+        emitter->y_positions[i] =
+        emitter->y + random_range(&emitter->seed, -emitter->spread_y,
+                                  emitter->spread_y);
+        angle = emitter->direction +
+                random_range(&emitter->seed, -emitter->angle_spread,
+                             emitter->angle_spread);
+        angle *= (float)(Pi / 180);
+        speed = random_range(&emitter->seed, emitter->min_speed,
+                             emitter->max_speed);
+        emitter->x_velocities[i] = (float)cos(angle) * speed;
+        emitter->y_velocities[i] = (float)sin(angle) * speed;
+        life = random_range(&emitter->seed, emitter->min_life,
+                            emitter->max_life);
+        if (life < 1) life = 1;
+        emitter->life[i] = life;
+        emitter->inv_lifetime[i] = 1 / life;
+        emitter->scales[i] = emitter->start_scale;
+        emitter->colors[i] = emitter->ramp[0];
+    }
+    emitter->count = end;
+    return count;
+}
+
+void clear_particles(struct particle_emitter* emitter)
+{
+    emitter->count = 0;
+    emitter->pending = 0;
+}
+
+/* Smallest number of particles worth a worker thread */
+#define PARTICLE_GRAIN 4096
+
+struct particle_pass {
+    struct particle_emitter* emitter;
+    float dt;
+    float ms;
+};
+
+/* Each loop below touches a couple of arrays with no branches, which
+ * the compiler turns into SIMD code. The passes run on ranges of
+ * particles, split between the job workers using parallel_for(). */
+static void integrate(void* data, int begin, int end)
+{
+    struct particle_pass* pass = (struct particle_pass*)data;
+    struct particle_emitter* emitter = pass->emitter;
+    float* x = emitter->x_positions;
+    float* y = emitter->y_positions;
+    float* vx = emitter->x_velocities;
+    float* vy = emitter->y_velocities;
+    float* life = emitter->life;
+    float dt = pass->dt;
+    float ms = pass->ms;
+    float gx = emitter->gravity_x * dt;
+    float gy = emitter->gravity_y * dt;
+    int i;
+
+    for (i = begin; i < end; i++) {
+        vx[i] += gx;
+        x[i] += vx[i] * dt;
+    }
+    for (i = begin; i < end; i++) {
+        vy[i] += gy;
+        y[i] += vy[i] * dt;
+    }
+    for (i = begin; i < end; i++) life[i] -= ms;
+}
+
+static void move_particle(struct particle_emitter* emitter, int from, int to)
+{
+    emitter->x_positions[to] = emitter->x_positions[from];
+    emitter->y_positions[to] = emitter->y_positions[from];
+    emitter->x_velocities[to] = emitter->x_velocities[from];
+    emitter->y_velocities[to] = emitter->y_velocities[from];
+    emitter->life[to] = emitter->life[from];
+    emitter->inv_lifetime[to] = emitter->inv_lifetime[from];
+    emitter->scales[to] = emitter->scales[from];
+    emitter->colors[to] = emitter->colors[from];
+}
+
+static void remove_dead(struct particle_emitter* emitter)
+{
+    int i = 0;
+    while (i < emitter->count) {
+        if (emitter->life[i] > 0) {
+            i++;
+        } else {
+            /* the last particle takes the dead one slot */
+            emitter->count--;
+            move_particle(emitter, emitter->count, i);
+        }
+    }
+}
+
+static void age_particles(void* data, int begin, int end)
+{
+    struct particle_pass* pass = (struct particle_pass*)data;
+    struct particle_emitter* emitter = pass->emitter;
+    float* life = emitter->life;
+    float* inv_lifetime = emitter->inv_lifetime;
+    float* scales = emitter->scales;
+    struct color* colors = emitter->colors;
+    float start = emitter->start_scale;
+    float delta = emitter->end_scale - emitter->start_scale;
+    int i;
+
+    for (i = begin; i < end; i++) {
+        float progress = 1 - life[i] * inv_lifetime[i];
+        scales[i] = start + delta * progress;
+        colors[i] =
+        emitter->ramp[(int)(progress * (PARTICLE_RAMP_SIZE - 1) + 0.5f)];
+    }
+}
+
+void update_particles(struct particle_emitter* emitter, uint32_t elapsed_ms)
+{
+    struct particle_pass pass;
+    int n;
+
+    pass.emitter = emitter;
+    pass.dt = elapsed_ms / 1000.0f;
+    pass.ms = (float)elapsed_ms;
+    build_ramp(emitter);
+    parallel_for(emitter->count, PARTICLE_GRAIN, integrate, &pass);
+    remove_dead(emitter);
+    if (emitter->rate > 0) {
+        emitter->pending += emitter->rate * pass.dt;
+        n = (int)emitter->pending;
+        emitter->pending -= n;
+        emit_particles(emitter, n);
+    }
+    parallel_for(emitter->count, PARTICLE_GRAIN, age_particles, &pass);
+}
+
+void draw_particles(struct particle_emitter* emitter)
+{
+    struct image* image = emitter->image;
+    struct rectangle clip = emitter->clip;
+    float ox = screen->offset_x;
+    float oy = screen->offset_y;
+    int i;
+#ifdef RENDER_GEOMETRY
+    SDL_Vertex* v = (SDL_Vertex*)emitter->vertices;
+    float u1, v1, u2, v2;
+    int width, height, n = 0;
+#else
+    SDL_Rect src, dst;
+#endif
+
+    if (emitter->count == 0 || use_image(image) == -1) return;
+    if (clip.w == 0 || clip.h == 0) {
+        clip.x = 0;
+        clip.y = 0;
+        clip.w = image->width;
+        clip.h = image->height;
+    }
+
+#ifdef RENDER_GEOMETRY
+    u1 = (float)clip.x / image->width;
+    v1 = (float)clip.y / image->height;
+    u2 = (float)(clip.x + clip.w) / image->width;
+    v2 = (float)(clip.y + clip.h) / image->height;
+    /* culled inline rather than using cull_quad(), as there are many */
+    get_render_target_size(&width, &height);
+    for (i = 0; i < emitter->count; i++) {
+        float hw = clip.w * 0.5f * emitter->scales[i];
+        float hh = clip.h * 0.5f * emitter->scales[i];
+        float x = emitter->x_positions[i] + ox;
+        float y = emitter->y_positions[i] + oy;
+        SDL_Color c;
+        if (x + hw <= 0 || y + hh <= 0 || x - hw >= width ||
+            y - hh >= height)
+            continue;
+        c.r = emitter->colors[i].red;
+        c.g = emitter->colors[i].green;
+        c.b = emitter->colors[i].blue;
+        c.a = emitter->colors[i].alpha * image->alpha / 255;
+        put_vertex(&v[0], x - hw, y - hh, u1, v1, c);
+        put_vertex(&v[1], x + hw, y - hh, u2, v1, c);
+        put_vertex(&v[2], x + hw, y + hh, u2, v2, c);
+        put_vertex(&v[3], x - hw, y + hh, u1, v2, c);
+        v += 4;
+        n++;
+    }
+    screen->stats.submitted += n;
+    screen->stats.culled += emitter->count - n;
+    if (n == 0) return;
+    /* vertex colors carry the tint and alpha of each particle */
+    set_texture_color_mod(image, 255, 255, 255);
+    set_texture_alpha_mod(image, 255);
+    SDL_RenderGeometry(screen->impl, image->impl,
+                       (SDL_Vertex*)emitter->vertices, n * 4,
+                       emitter->indices, n * 6);
+#else
+    src.x = clip.x;
+    src.y = clip.y;
+    src.w = clip.w;
+    src.h = clip.h;
+    for (i = 0; i < emitter->count; i++) {
+        struct color c = emitter->colors[i];
+        dst.w = (int)(clip.w * emitter->scales[i] + 0.5f);
+        dst.h = (int)(clip.h * emitter->scales[i] + 0.5f);
+        dst.x = (int)floor(emitter->x_positions[i] + ox - dst.w / 2.0f + 0.5f);
+        dst.y = (int)floor(emitter->y_positions[i] + oy - dst.h / 2.0f + 0.5f);
+        if (cull_quad(dst.x, dst.y, dst.x + dst.w, dst.y + dst.h)) continue;
+        set_texture_color_mod(image, c.red, c.green, c.blue);
+        set_texture_alpha_mod(image, c.alpha * image->alpha / 255);
+        SDL_RenderCopy(screen->impl, image->impl, &src, &dst);
+    }
+#endif
+}
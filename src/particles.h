@@ -0,0 +1,182 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#ifndef PARTICLES_H_W6JC3NHV
+#define PARTICLES_H_W6JC3NHV
+
+#include <stdint.h>
+#include "image.h"
+
+#include "begin_prefix.h"
+/** Number of entries in the particle color ramp */
+#define PARTICLE_RAMP_SIZE 64
+
+/**
+ * Particle emitters spawn, move and draw many short lived images,
+ * like sparks, smoke or dust. The emitter settings are plain fields,
+ * so set them once after creating the emitter, or change them at any
+ * time to shape the effect:
+ *
+ *     struct particle_emitter* sparks;
+ *     sparks = create_particle_emitter(spark_image, 10000);
+ *     sparks->rate = 2000;
+ *     sparks->min_speed = 40;
+ *     sparks->max_speed = 120;
+ *     sparks->end_color = color_from_RGBA(255, 64, 0, 0);
+ *     sparks->alpha_easing = quadratic_ease_in;
+ *
+ * Then, once per frame, move the emitter, update and draw it:
+ *
+ *     sparks->x = x;
+ *     sparks->y = y;
+ *     update_particles(sparks, elapsed_ms);
+ *     draw_particles(sparks);
+ *
+ * Particles are kept as separate arrays of positions, velocities, life
+ * and colors rather than an array of particle structures, so the update
+ * pass walks memory linearly and the compiler can vectorize it.
+ * An emitter draws all its particles in a single render call.
+ */
+struct particle_emitter {
+    /** image drawn for every particle */
+    struct image* image;
+    /** image area to draw, or zero sized for the whole image */
+    struct rectangle clip;
+    /** emitter x position */
+    float x;
+    /** emitter y position */
+    float y;
+    /** particles are spawned up to this distance from x */
+    float spread_x;
+    /** particles are spawned up to this distance from y */
+    float spread_y;
+    /** particles emitted per second, 0 to emit using emit_particles() */
+    float rate;
+    /** emission direction in degrees, clockwise from the x axis */
+    float direction;
+    /** particles are emitted up to this many degrees from direction */
+    float angle_spread;
+    /** minimal particle speed in pixels per second */
+    float min_speed;
+    /** maximal particle speed in pixels per second */
+    float max_speed;
+    /** x acceleration in pixels per second squared */
+    float gravity_x;
+    /** y acceleration in pixels per second squared */
+    float gravity_y;
+    /** minimal particle life in milliseconds */
+    float min_life;
+    /** maximal particle life in milliseconds */
+    float max_life;
+    /** particle scale when spawned */
+    float start_scale;
+    /** particle scale when it dies */
+    float end_scale;
+    /** particle color when spawned */
+    struct color start_color;
+    /** particle color when it dies */
+    struct color end_color;
+    /**
+     * easing function for the red, green and blue channels or NULL to
+     * change them linearly
+     */
+    float (*color_easing)(float);
+    /** easing function for the alpha channel or NULL for linear */
+    float (*alpha_easing)(float);
+    /** maximum number of live particles */
+    int capacity;
+    /** number of live particles */
+    int count;
+    /* Per-particle state, one array per attribute. Slots [0, count) are
+     * alive. life is the time left in milliseconds and inv_lifetime the
+     * reciprocal of the particle total life. */
+    float* x_positions;
+    float* y_positions;
+    float* x_velocities;
+    float* y_velocities;
+    float* life;
+    float* inv_lifetime;
+    float* scales;
+    struct color* colors;
+    /* colors sampled from the start and end colors and easing functions */
+    struct color ramp[PARTICLE_RAMP_SIZE];
+    /* fraction of a particle left over from the last emission */
+    float pending;
+    /* random generator state */
+    uint32_t seed;
+    /* draw call vertex and index buffers */
+    void* vertices;
+    int* indices;
+};
+
+/**
+ * Allocate a new particle emitter
+ * @param image image drawn for every particle, not owned by the emitter
+ * @param capacity maximum number of live particles
+ *
+ * The emitter starts at 0,0 with a rate of 0, emitting white particles
+ * in every direction that fade out within a second.
+ *
+ * @return a new particle emitter or NULL on error
+ */
+struct particle_emitter* create_particle_emitter(struct image* image,
+                                                 int capacity);
+
+/**
+ * Destroy a particle emitter created using create_particle_emitter()
+ * @param emitter emitter to destroy
+ */
+void destroy_particle_emitter(struct particle_emitter* emitter);
+
+/**
+ * Spawn particles right away
+ * @param emitter emitter to spawn the particles from
+ * @param count number of particles to spawn
+ *
+ * @return number of particles spawned, which is less than count when
+ * the emitter is full
+ */
+int emit_particles(struct particle_emitter* emitter, int count);
+
+/**
+ * Remove all live particles
+ * @param emitter emitter to clear
+ */
+void clear_particles(struct particle_emitter* emitter);
+
+/**
+ * Emit new particles and move, age and color the live ones
+ * @param emitter emitter to update
+ * @param elapsed_ms time since last rendered frame (usually elapsed_ms)
+ */
+void update_particles(struct particle_emitter* emitter, uint32_t elapsed_ms);
+
+/**
+ * Draw all live particles
+ * @param emitter emitter to draw
+ *
+ * Particles are centered on their position and drawn using the image
+ * blend mode and alpha.
+ */
+void draw_particles(struct particle_emitter* emitter);
+
+#include "end_prefix.h"
+#endif /* end of include guard: PARTICLES_H_W6JC3NHV */
@@ -0,0 +1,542 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "path.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "internals.h"
+#include "begin_prefix.h"
+
+#define STRAIGHT_COST 10
+#define DIAGONAL_COST 14
+#define MIN_HEAP_CAPACITY 256
+
+/* Open list entry. Nodes are pushed again when a cheaper way to them is
+ * found, and stale entries are skipped when popped. */
+struct path_node {
+    int f;
+    int g;
+    int index;
+};
+
+/* visit[] holds generation * 2 for open nodes and generation * 2 + 1 for
+ * closed ones, so starting a search does not need to clear anything. */
+#define OPENED(finder) ((finder)->generation * 2)
+#define CLOSED(finder) ((finder)->generation * 2 + 1)
+
+static const int dir_x[8] = { 0, 1, 0, -1, 1, 1, -1, -1 };
+static const int dir_y[8] = { -1, 0, 1, 0, -1, 1, 1, -1 };
+
+static bool walkable(const struct tilemap* map, int col, int row)
+{
+    return is_map_walkable(map, col, row);
+}
+
+static int octile(int dx, int dy)
+{
+    dx = abs(dx);
+    dy = abs(dy);
+    return dx > dy ? STRAIGHT_COST * dx + (DIAGONAL_COST - STRAIGHT_COST) * dy
+                   : STRAIGHT_COST * dy + (DIAGONAL_COST - STRAIGHT_COST) * dx;
+}
+
+static int heuristic(const struct path_finder* finder, int index)
+{
+    int cols = finder->map->cols;
+    int dx = index % cols - finder->goal % cols;
+    int dy = index / cols - finder->goal / cols;
+    if (finder->flags & (PATH_DIAGONAL | PATH_JUMP)) return octile(dx, dy);
+    return STRAIGHT_COST * (abs(dx) + abs(dy));
+}
+
+struct path_finder* create_path_finder(int capacity)
+{
+    struct path_finder* finder;
+    if (capacity <= 0) {
+        ERROR("Path finder capacity must be positive");
+        return NULL;
+    }
+    finder = (struct path_finder*)MALLOC(
+    sizeof(struct path_finder), MEMORY_PATHS);
+    if (finder == NULL) goto error;
+    finder->cost = (int*)MALLOC(sizeof(int) * 2 * capacity, MEMORY_PATHS);
+    if (finder->cost == NULL) goto free_finder;
+    finder->parent = finder->cost + capacity;
+    finder->visit = (uint32_t*)CALLOC(capacity, sizeof(uint32_t), MEMORY_PATHS);
+    if (finder->visit == NULL) goto free_cost;
+    finder->heap_capacity = MIN_HEAP_CAPACITY;
+    finder->heap = (struct path_node*)MALLOC(sizeof(struct path_node) *
+                                             finder->heap_capacity,
+                                             MEMORY_PATHS);
+    if (finder->heap == NULL) goto free_visit;
+    finder->capacity = capacity;
+    finder->generation = 0;
+    finder->heap_size = 0;
+    finder->map = NULL;
+    finder->status = PATH_NOT_FOUND;
+    return finder;
+
+free_visit:
+    FREE(finder->visit);
+free_cost:
+    FREE(finder->cost);
+free_finder:
+    FREE(finder);
+error:
+    ERROR("Unable to allocate path finder");
+    return NULL;
+}
+
+void destroy_path_finder(struct path_finder* finder)
+{
+    if (finder == NULL) return;
+    FREE(finder->heap);
+    FREE(finder->visit);
+    FREE(finder->cost);
+    FREE(finder);
+}
+
+static bool node_before(const struct path_node* a, const struct path_node* b)
+{
+    /* prefer nodes closer to the goal when costs tie */
+    return a->f < b->f || (a->f == b->f && a->g > b->g);
+}
+
+static int push_node(struct path_finder* finder, int index, int g)
+{
+    struct path_node node;
+    int i;
+    if (finder->heap_size == finder->heap_capacity) {
+        int capacity = finder->heap_capacity * 2;
+        struct path_node* heap = (struct path_node*)REALLOC(
+        finder->heap, sizeof(struct path_node) * capacity, MEMORY_PATHS);
+        if (heap == NULL) return -1;
+        finder->heap = heap;
+        finder->heap_capacity = capacity;
+    }
+    node.f = g + heuristic(finder, index);
+    node.g = g;
+    node.index = index;
+    i = finder->heap_size++;
+    while (i > 0 && node_before(&node, &finder->heap[(i - 1) / 2])) {
+        finder->heap[i] = finder->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    finder->heap[i] = node;
+    return 0;
+}
+
+static struct path_node pop_node(struct path_finder* finder)
+{
+    struct path_node top = finder->heap[0];
+    struct path_node last = finder->heap[--finder->heap_size];
+    int n = finder->heap_size;
+    int i = 0;
+    for (;;) {
+        int child = i * 2 + 1;
+        if (child >= n) break;
+        if (child + 1 < n &&
+            node_before(&finder->heap[child + 1], &finder->heap[child]))
+            child++;
+        if (!node_before(&finder->heap[child], &last)) break;
+        finder->heap[i] = finder->heap[child];
+        i = child;
+    }
+    if (n > 0) finder->heap[i] = last;
+    return top;
+}
+
+/* Record a way to reach index from parent with cost g, if it is the
+ * best one so far */
+static int relax(struct path_finder* finder, int index, int parent, int g)
+{
+    uint32_t visit = finder->visit[index];
+    if (visit == CLOSED(finder)) return 0;
+    if (visit == OPENED(finder) && finder->cost[index] <= g) return 0;
+    finder->visit[index] = OPENED(finder);
+    finder->cost[index] = g;
+    finder->parent[index] = parent;
+    return push_node(finder, index, g);
+}
+
+int start_path_search(struct path_finder* finder,
+                      const struct tilemap* map,
+                      int from_col,
+                      int from_row,
+                      int to_col,
+                      int to_row,
+                      int flags)
+{
+    finder->status = PATH_NOT_FOUND;
+    if (map->cols * map->rows > finder->capacity) {
+        ERROR("Map is too big for the path finder");
+        return -1;
+    }
+    if (from_col < 0 || from_row < 0 || from_col >= map->cols ||
+        from_row >= map->rows || to_col < 0 || to_row < 0 ||
+        to_col >= map->cols || to_row >= map->rows) {
+        ERROR("Path end is outside the map");
+        return -1;
+    }
+    if (++finder->generation >= 0x7fffffffu) {
+        memset(finder->visit, 0, sizeof(uint32_t) * finder->capacity);
+        finder->generation = 1;
+    }
+    finder->map = map;
+    finder->flags = flags;
+    finder->start = from_row * map->cols + from_col;
+    finder->goal = to_row * map->cols + to_col;
+    finder->heap_size = 0;
+    if (!walkable(map, to_col, to_row)) return 0;
+    finder->status = PATH_SEARCHING;
+    return relax(finder, finder->start, -1, 0);
+}
+
+/* Jump point search with no corner cutting: scan from col, row in the
+ * dx, dy direction and return the first tile worth expanding, or -1. */
+static int jump(const struct path_finder* finder,
+                int col,
+                int row,
+                int dx,
+                int dy)
+{
+    const struct tilemap* map = finder->map;
+    for (;;) {
+        if (!walkable(map, col, row)) return -1;
+        if (row * map->cols + col == finder->goal) return finder->goal;
+        if (dx != 0 && dy != 0) {
+            if (jump(finder, col + dx, row, dx, 0) != -1 ||
+                jump(finder, col, row + dy, 0, dy) != -1)
+                return row * map->cols + col;
+        } else if (dx != 0) {
+            if ((walkable(map, col, row - 1) &&
+                 !walkable(map, col - dx, row - 1)) ||
+                (walkable(map, col, row + 1) &&
+                 !walkable(map, col - dx, row + 1)))
+                return row * map->cols + col;
+        } else {
+            if ((walkable(map, col - 1, row) &&
+                 !walkable(map, col - 1, row - dy)) ||
+                (walkable(map, col + 1, row) &&
+                 !walkable(map, col + 1, row - dy)))
+                return row * map->cols + col;
+        }
+        if (!walkable(map, col + dx, row) || !walkable(map, col, row + dy))
+            return -1;
+        col += dx;
+        row += dy;
+    }
+}
+
+static int sign(int x)
+{
+    return (x > 0) - (x < 0);
+}
+
+/* Directions to scan from a jump point, pruned by the direction it was
+ * reached from. Returns the number of directions written to dirs. */
+static int jump_directions(const struct path_finder* finder,
+                           int index,
+                           int* dirs)
+{
+    const struct tilemap* map = finder->map;
+    int col = index % map->cols;
+    int row = index / map->cols;
+    int parent = finder->parent[index];
+    int dx, dy, d;
+    int n = 0;
+
+    if (parent == -1) {
+        for (d = 0; d < 8; d++) dirs[n++] = d;
+        return n;
+    }
+    dx = sign(col - parent % map->cols);
+    dy = sign(row - parent / map->cols);
+    for (d = 0; d < 8; d++) {
+        int x = dir_x[d];
+        int y = dir_y[d];
+        if (dx != 0 && dy != 0) {
+            /* keep going diagonally or along either axis */
+            if ((x == dx && y == dy) || (x == dx && y == 0) ||
+                (x == 0 && y == dy))
+                dirs[n++] = d;
+        } else if (dx != 0) {
+            /* forward, plus sideways moves past the tile */
+            if (x == dx || (x == 0 && y != 0)) dirs[n++] = d;
+        } else {
+            if (y == dy || (y == 0 && x != 0)) dirs[n++] = d;
+        }
+    }
+    return n;
+}
+
+static bool can_step(const struct tilemap* map, int col, int row, int d)
+{
+    int x = dir_x[d];
+    int y = dir_y[d];
+    if (!walkable(map, col + x, row + y)) return false;
+    /* diagonal steps must not cut a blocked corner */
+    return (x == 0 || y == 0) ||
+           (walkable(map, col + x, row) && walkable(map, col, row + y));
+}
+
+static int expand(struct path_finder* finder, struct path_node node)
+{
+    const struct tilemap* map = finder->map;
+    int col = node.index % map->cols;
+    int row = node.index / map->cols;
+    int dirs[8];
+    int n, i;
+
+    if (finder->flags & PATH_JUMP) {
+        n = jump_directions(finder, node.index, dirs);
+        for (i = 0; i < n; i++) {
+            int d = dirs[i];
+            int next;
+            if (!can_step(map, col, row, d)) continue;
+            next = jump(finder, col + dir_x[d], row + dir_y[d], dir_x[d],
+                        dir_y[d]);
+            if (next == -1) continue;
+            if (relax(finder, next, node.index,
+                      node.g + octile(next % map->cols - col,
+                                      next / map->cols - row)) == -1)
+                return -1;
+        }
+        return 0;
+    }
+
+    n = (finder->flags & PATH_DIAGONAL) ? 8 : 4;
+    for (i = 0; i < n; i++) {
+        if (!can_step(map, col, row, i)) continue;
+        if (relax(finder,
+                  (row + dir_y[i]) * map->cols + col + dir_x[i],
+                  node.index,
+                  node.g + (i < 4 ? STRAIGHT_COST : DIAGONAL_COST)) == -1)
+            return -1;
+    }
+    return 0;
+}
+
+enum path_status continue_path_search(struct path_finder* finder,
+                                      int max_expansions)
+{
+    int expanded = 0;
+    while (finder->status == PATH_SEARCHING) {
+        struct path_node node;
+        if (finder->heap_size == 0) {
+            finder->status = PATH_NOT_FOUND;
+            break;
+        }
+        if (max_expansions > 0 && expanded == max_expansions) break;
+        node = pop_node(finder);
+        if (finder->visit[node.index] == CLOSED(finder) ||
+            node.g != finder->cost[node.index])
+            continue;
+        finder->visit[node.index] = CLOSED(finder);
+        if (node.index == finder->goal) {
+            finder->status = PATH_FOUND;
+            break;
+        }
+        if (expand(finder, node) == -1) {
+            ERROR("Unable to grow the path finder open list");
+            finder->status = PATH_NOT_FOUND;
+        }
+        expanded++;
+    }
+    return (enum path_status)finder->status;
+}
+
+int get_path(const struct path_finder* finder,
+             struct path_step* path,
+             int max_steps)
+{
+    int cols;
+    int length = 0;
+    int index;
+
+    if (finder->status != PATH_FOUND) return -1;
+    cols = finder->map->cols;
+    /* Jump points are joined by straight or diagonal lines, so the
+     * number of steps between two of them is the longer axis. */
+    for (index = finder->goal; index != finder->start;
+         index = finder->parent[index]) {
+        int parent = finder->parent[index];
+        int dx = abs(index % cols - parent % cols);
+        int dy = abs(index / cols - parent / cols);
+        length += dx > dy ? dx : dy;
+    }
+    /* walk back from the goal, filling steps from the end */
+    {
+        int step = length;
+        for (index = finder->goal; index != finder->start;
+             index = finder->parent[index]) {
+            int parent = finder->parent[index];
+            int col = index % cols;
+            int row = index / cols;
+            int dx = sign(parent % cols - col);
+            int dy = sign(parent / cols - row);
+            while (col != parent % cols || row != parent / cols) {
+                step--;
+                if (step < max_steps) {
+                    path[step].col = col;
+                    path[step].row = row;
+                }
+                col += dx;
+                row += dy;
+            }
+        }
+    }
+    return length;
+}
+
+int find_path(struct path_finder* finder,
+              const struct tilemap* map,
+              int from_col,
+              int from_row,
+              int to_col,
+              int to_row,
+              int flags,
+              struct path_step* path,
+              int max_steps)
+{
+    if (start_path_search(finder, map, from_col, from_row, to_col, to_row,
+                          flags) == -1)
+        return -1;
+    if (continue_path_search(finder, 0) != PATH_FOUND) return -1;
+    return get_path(finder, path, max_steps);
+}
+
+struct flow_field* create_flow_field(int cols, int rows)
+{
+    struct flow_field* field;
+    size_t n = (size_t)cols * rows;
+    if (cols <= 0 || rows <= 0) {
+        ERROR("Flow field size must be positive");
+        return NULL;
+    }
+    field = (struct flow_field*)MALLOC(sizeof(struct flow_field), MEMORY_PATHS);
+    if (field == NULL) goto error;
+    field->distance = (int*)MALLOC(sizeof(int) * 2 * n, MEMORY_PATHS);
+    if (field->distance == NULL) goto free_field;
+    field->queue = field->distance + n;
+    field->direction = (int8_t*)MALLOC(n, MEMORY_PATHS);
+    if (field->direction == NULL) goto free_distance;
+    field->cols = cols;
+    field->rows = rows;
+    memset(field->direction, -1, n);
+    return field;
+
+free_distance:
+    FREE(field->distance);
+free_field:
+    FREE(field);
+error:
+    ERROR("Unable to allocate flow field");
+    return NULL;
+}
+
+void destroy_flow_field(struct flow_field* field)
+{
+    if (field == NULL) return;
+    FREE(field->direction);
+    FREE(field->distance);
+    FREE(field);
+}
+
+int build_flow_field(struct flow_field* field,
+                     const struct tilemap* map,
+                     int goal_col,
+                     int goal_row,
+                     int flags)
+{
+    int n = field->cols * field->rows;
+    int n_dirs = (flags & (PATH_DIAGONAL | PATH_JUMP)) ? 8 : 4;
+    int head = 0;
+    int tail = 0;
+    int i, d;
+
+    if (map->cols != field->cols || map->rows != field->rows) {
+        ERROR("Flow field and map sizes differ");
+        return -1;
+    }
+    if (goal_col < 0 || goal_row < 0 || goal_col >= map->cols ||
+        goal_row >= map->rows) {
+        ERROR("Flow field goal is outside the map");
+        return -1;
+    }
+    for (i = 0; i < n; i++) field->distance[i] = -1;
+    memset(field->direction, -1, n);
+    if (!walkable(map, goal_col, goal_row)) return 0;
+
+    /* breadth first from the goal, moving the way agents would */
+    field->distance[goal_row * map->cols + goal_col] = 0;
+    field->queue[tail++] = goal_row * map->cols + goal_col;
+    while (head < tail) {
+        int index = field->queue[head++];
+        int col = index % map->cols;
+        int row = index / map->cols;
+        for (d = 0; d < n_dirs; d++) {
+            int next = (row + dir_y[d]) * map->cols + col + dir_x[d];
+            if (!can_step(map, col, row, d) || field->distance[next] != -1)
+                continue;
+            field->distance[next] = field->distance[index] + 1;
+            field->queue[tail++] = next;
+        }
+    }
+
+    /* every reached tile points at its closest neighbour, preferring
+     * straight steps since they come first */
+    for (head = 1; head < tail; head++) {
+        int index = field->queue[head];
+        int col = index % map->cols;
+        int row = index / map->cols;
+        int best = field->distance[index];
+        for (d = 0; d < n_dirs; d++) {
+            int next;
+            if (!can_step(map, col, row, d)) continue;
+            next = (row + dir_y[d]) * map->cols + col + dir_x[d];
+            if (field->distance[next] >= 0 && field->distance[next] < best) {
+                best = field->distance[next];
+                field->direction[index] = (int8_t)d;
+            }
+        }
+    }
+    return 0;
+}
+
+int get_flow_direction(const struct flow_field* field,
+                       int col,
+                       int row,
+                       int* dx,
+                       int* dy)
+{
+    int d;
+    if (col < 0 || row < 0 || col >= field->cols || row >= field->rows)
+        return -1;
+    d = field->direction[row * field->cols + col];
+    if (d < 0) return -1;
+    *dx = dir_x[d];
+    *dy = dir_y[d];
+    return 0;
+}
+#include "end_prefix.h"
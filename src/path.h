@@ -0,0 +1,264 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#ifndef PATH_H_N6FQ2WCT
+#define PATH_H_N6FQ2WCT
+
+#include <stdint.h>
+#include "tilemap.h"
+
+#include "begin_prefix.h"
+/**
+ * Path search options. Combine them with a bitwise or.
+ */
+enum path_flags {
+    /** move in 4 directions only */
+    PATH_STRAIGHT = 0,
+    /** also move diagonally, without cutting blocked corners */
+    PATH_DIAGONAL = 1,
+    /** use jump point search, which implies PATH_DIAGONAL */
+    PATH_JUMP = 2
+};
+
+/**
+ * State of a path search
+ */
+enum path_status {
+    /** the search needs more calls to continue_path_search() */
+    PATH_SEARCHING,
+    /** a path was found, use get_path() to read it */
+    PATH_FOUND,
+    /** there is no path between the two tiles */
+    PATH_NOT_FOUND
+};
+
+/**
+ * A single tile along a path
+ */
+struct path_step {
+    /** tile column */
+    int col;
+    /** tile row */
+    int row;
+};
+
+/**
+ * Path finders search for the shortest path between two tiles of a
+ * \ref tilemap, using A* or jump point search over the tilemap
+ * walkable tiles.
+ * A path finder holds the scratch buffers of a search, sized for maps of
+ * up to a given number of tiles, and reuses them for every search. The
+ * tilemap is only read, so threads may search the same map at the same
+ * time as long as each uses its own path finder:
+ *
+ *     struct path_finder* finder = create_path_finder(map->cols * map->rows);
+ *     struct path_step path[256];
+ *     int n = find_path(finder, map, 1, 1, 40, 30, PATH_JUMP, path, 256);
+ *
+ * Long searches can be spread over several frames. Start the search, and
+ * then give it a budget of expanded tiles every frame until it is done:
+ *
+ *     start_path_search(finder, map, 1, 1, 40, 30, PATH_JUMP);
+ *     // every frame
+ *     if (continue_path_search(finder, 200) == PATH_FOUND) {
+ *         n = get_path(finder, path, 256);
+ *     }
+ */
+struct path_finder {
+    /** most map tiles the finder can search */
+    int capacity;
+    /* search state, see path.c */
+    const struct tilemap* map;
+    int flags;
+    int start;
+    int goal;
+    int status;
+    int* cost;
+    int* parent;
+    uint32_t* visit;
+    uint32_t generation;
+    struct path_node* heap;
+    int heap_size;
+    int heap_capacity;
+};
+
+/**
+ * Create a path finder
+ * @param capacity most map tiles (columns times rows) to search
+ *
+ * @return a new \ref path_finder or NULL on error
+ */
+struct path_finder* create_path_finder(int capacity);
+
+/**
+ * Destroy a path finder
+ * @param finder path finder to destroy
+ */
+void destroy_path_finder(struct path_finder* finder);
+
+/**
+ * Start a new path search
+ * @param finder path finder to use
+ * @param map tilemap to search
+ * @param from_col start tile column
+ * @param from_row start tile row
+ * @param to_col goal tile column
+ * @param to_row goal tile row
+ * @param flags \ref path_flags
+ *
+ * @return 0 on success or -1 if the map is too big for the finder or a
+ * tile is outside the map
+ */
+int start_path_search(struct path_finder* finder,
+                      const struct tilemap* map,
+                      int from_col,
+                      int from_row,
+                      int to_col,
+                      int to_row,
+                      int flags);
+
+/**
+ * Continue a search started using start_path_search()
+ * @param finder path finder to use
+ * @param max_expansions most tiles to expand in this call, or 0 to
+ * finish the search
+ *
+ * @return the \ref path_status of the search
+ */
+enum path_status continue_path_search(struct path_finder* finder,
+                                      int max_expansions);
+
+/**
+ * Read the path found by the last search
+ * @param finder path finder holding a found path
+ * @param path steps to fill, from the tile after the start up to and
+ * including the goal
+ * @param max_steps size of path
+ *
+ * @return number of steps in the path, which may be more than max_steps,
+ * or -1 if no path was found
+ */
+int get_path(const struct path_finder* finder,
+             struct path_step* path,
+             int max_steps);
+
+/**
+ * Search for a path in one go
+ * @param finder path finder to use
+ * @param map tilemap to search
+ * @param from_col start tile column
+ * @param from_row start tile row
+ * @param to_col goal tile column
+ * @param to_row goal tile row
+ * @param flags \ref path_flags
+ * @param path steps to fill, see get_path()
+ * @param max_steps size of path
+ *
+ * @return number of steps in the path or -1 if there is no path
+ */
+int find_path(struct path_finder* finder,
+              const struct tilemap* map,
+              int from_col,
+              int from_row,
+              int to_col,
+              int to_row,
+              int flags,
+              struct path_step* path,
+              int max_steps);
+
+/**
+ * Flow fields lead any number of agents to a single goal.
+ * Building a flow field walks the whole map once, after which every tile
+ * knows which way leads to the goal, so moving hundreds of agents costs
+ * a table lookup each:
+ *
+ *     struct flow_field* field = create_flow_field(map->cols, map->rows);
+ *     build_flow_field(field, map, goal_col, goal_row, PATH_DIAGONAL);
+ *     // for each agent
+ *     int dx, dy;
+ *     if (get_flow_direction(field, col, row, &dx, &dy) == 0) {
+ *         // move towards col + dx, row + dy
+ *     }
+ */
+struct flow_field {
+    /** field width in tiles */
+    int cols;
+    /** field height in tiles */
+    int rows;
+    /** steps from every tile to the goal, or -1 if it cannot be reached */
+    int* distance;
+    /** direction from every tile towards the goal, or -1 for none */
+    int8_t* direction;
+    /* breadth first search queue */
+    int* queue;
+};
+
+/**
+ * Create a flow field
+ * @param cols field width in tiles
+ * @param rows field height in tiles
+ *
+ * @return a new \ref flow_field or NULL on error
+ */
+struct flow_field* create_flow_field(int cols, int rows);
+
+/**
+ * Destroy a flow field
+ * @param field flow field to destroy
+ */
+void destroy_flow_field(struct flow_field* field);
+
+/**
+ * Point every tile of a flow field towards a goal
+ * @param field flow field to build, with the same size as the map
+ * @param map tilemap to search
+ * @param goal_col goal tile column
+ * @param goal_row goal tile row
+ * @param flags \ref path_flags, PATH_DIAGONAL allows diagonal directions
+ *
+ * @return 0 on success or -1 if the field and map sizes differ or the goal
+ * is outside the map
+ */
+int build_flow_field(struct flow_field* field,
+                     const struct tilemap* map,
+                     int goal_col,
+                     int goal_row,
+                     int flags);
+
+/**
+ * Get the direction towards the goal
+ * @param field flow field to query
+ * @param col tile column
+ * @param row tile row
+ * @param dx set to the column step, -1, 0 or 1
+ * @param dy set to the row step, -1, 0 or 1
+ *
+ * @return 0 on success, or -1 at the goal, outside the field or where the
+ * goal cannot be reached
+ */
+int get_flow_direction(const struct flow_field* field,
+                       int col,
+                       int row,
+                       int* dx,
+                       int* dy);
+
+#include "end_prefix.h"
+#endif /* end of include guard: PATH_H_N6FQ2WCT */
@@ -0,0 +1,278 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "render_pass.h"
+#include "internals.h"
+#include "utils.h"
+#include <stdlib.h>
+#include "SDL.h"
+
+#include "begin_prefix.h"
+
+#define MIN_POOL_CAPACITY 4
+
+/* Target images shared by all render pass lists */
+struct target_pool {
+    struct image** images;
+    bool* in_use;
+    int count;
+    int capacity;
+};
+
+static struct target_pool pool = { NULL, NULL, 0, 0 };
+
+static struct image* acquire_target(int width, int height)
+{
+    struct image* image;
+    int i;
+
+    for (i = 0; i < pool.count; i++) {
+        image = pool.images[i];
+        if (!pool.in_use[i] && image->width == width &&
+            image->height == height) {
+            pool.in_use[i] = true;
+            return image;
+        }
+    }
+
+    if (pool.count == pool.capacity) {
+        int capacity = max(pool.capacity * 2, MIN_POOL_CAPACITY);
+        struct image** images = (struct image**)REALLOC(
+        pool.images, sizeof(struct image*) * capacity, MEMORY_RENDER);
+        bool* in_use;
+        if (images == NULL) return NULL;
+        pool.images = images;
+        in_use = (bool*)REALLOC(
+        pool.in_use, sizeof(bool) * capacity, MEMORY_RENDER);
+        if (in_use == NULL) return NULL;
+        pool.in_use = in_use;
+        pool.capacity = capacity;
+    }
+
+    image = create_target_image(width, height, color_from_RGBA(0, 0, 0, 0));
+    if (image == NULL) return NULL;
+    pool.images[pool.count] = image;
+    pool.in_use[pool.count] = true;
+    pool.count++;
+    return image;
+}
+
+void release_render_target(struct image* image)
+{
+    int i;
+    for (i = 0; i < pool.count; i++) {
+        if (pool.images[i] == image) {
+            pool.in_use[i] = false;
+            return;
+        }
+    }
+}
+
+void purge_render_targets(void)
+{
+    int i;
+    int kept = 0;
+    for (i = 0; i < pool.count; i++) {
+        if (pool.in_use[i]) {
+            pool.images[kept] = pool.images[i];
+            pool.in_use[kept] = true;
+            kept++;
+        } else {
+            destroy_image(pool.images[i]);
+        }
+    }
+    pool.count = kept;
+    if (kept == 0) {
+        FREE(pool.images);
+        FREE(pool.in_use);
+        pool.images = NULL;
+        pool.in_use = NULL;
+        pool.capacity = 0;
+    }
+}
+
+struct render_passes* create_render_passes(int capacity)
+{
+    struct render_passes* passes;
+
+    if (capacity <= 0) {
+        ERROR("Render pass capacity must be positive");
+        return NULL;
+    }
+    passes = (struct render_passes*)MALLOC(
+    sizeof(struct render_passes), MEMORY_RENDER);
+    if (passes == NULL) goto error;
+    passes->passes =
+    (struct render_pass*)CALLOC(
+    capacity, sizeof(struct render_pass), MEMORY_RENDER);
+    if (passes->passes == NULL) goto free_passes;
+    passes->order = (int*)MALLOC(sizeof(int) * 2 * capacity, MEMORY_RENDER);
+    if (passes->order == NULL) goto free_list;
+    passes->readers = passes->order + capacity;
+    passes->capacity = capacity;
+    passes->count = 0;
+    return passes;
+
+free_list:
+    FREE(passes->passes);
+free_passes:
+    FREE(passes);
+error:
+    ERROR("Unable to allocate render passes");
+    return NULL;
+}
+
+void destroy_render_passes(struct render_passes* passes)
+{
+    if (passes == NULL) return;
+    FREE(passes->order);
+    FREE(passes->passes);
+    FREE(passes);
+}
+
+struct render_pass* add_render_pass(struct render_passes* passes,
+                                    int width,
+                                    int height,
+                                    render_pass_func_t draw,
+                                    void* data)
+{
+    struct render_pass* pass;
+    if (passes->count == passes->capacity) {
+        ERROR("Render pass list is full");
+        return NULL;
+    }
+    pass = &passes->passes[passes->count++];
+    pass->width = width;
+    pass->height = height;
+    pass->clear_on_bind = false;
+    pass->clear_color = color_from_RGBA(0, 0, 0, 0);
+    pass->input = NULL;
+    pass->composite = false;
+    pass->x = 0;
+    pass->y = 0;
+    pass->blend = BLEND;
+    pass->draw = draw;
+    pass->data = data;
+    pass->target = NULL;
+    return pass;
+}
+
+/* Depth first walk placing every pass after its input. readers holds
+ * the walk state: 0 unvisited, 1 in progress, 2 placed. */
+static int order_pass(struct render_passes* passes, int i, int* n)
+{
+    struct render_pass* input = passes->passes[i].input;
+    if (passes->readers[i] == 2) return 0;
+    if (passes->readers[i] == 1) {
+        ERROR("Render pass inputs form a cycle");
+        return -1;
+    }
+    passes->readers[i] = 1;
+    if (input != NULL &&
+        order_pass(passes, (int)(input - passes->passes), n) == -1)
+        return -1;
+    passes->readers[i] = 2;
+    passes->order[(*n)++] = i;
+    return 0;
+}
+
+static int order_passes(struct render_passes* passes)
+{
+    int i;
+    int n = 0;
+    for (i = 0; i < passes->count; i++) passes->readers[i] = 0;
+    for (i = 0; i < passes->count; i++)
+        if (order_pass(passes, i, &n) == -1) return -1;
+    for (i = 0; i < passes->count; i++) passes->readers[i] = 0;
+    for (i = 0; i < passes->count; i++) {
+        struct render_pass* input = passes->passes[i].input;
+        if (input != NULL) passes->readers[input - passes->passes]++;
+    }
+    return 0;
+}
+
+/* Hand a pass target back to the pool once nothing needs it */
+static void retire_pass(struct render_passes* passes, struct render_pass* pass)
+{
+    if (pass->target == NULL || pass->composite ||
+        passes->readers[pass - passes->passes] > 0)
+        return;
+    release_render_target(pass->target);
+    pass->target = NULL;
+}
+
+int run_render_passes(struct render_passes* passes)
+{
+    struct image* previous = screen->target;
+    struct render_pass* pass;
+    int ret = -1;
+    int i;
+
+    if (order_passes(passes) == -1) return -1;
+
+    for (i = 0; i < passes->count; i++) {
+        pass = &passes->passes[passes->order[i]];
+        pass->target = acquire_target(pass->width, pass->height);
+        if (pass->target == NULL) {
+            ERROR("Unable to acquire a render pass target");
+            goto release;
+        }
+        if (set_render_target(pass->target) != 0) {
+            ERROR("Unable to bind a render pass target");
+            goto release;
+        }
+        if (pass->clear_on_bind) {
+            set_render_draw_color(pass->clear_color);
+            SDL_RenderClear(screen->impl);
+        }
+        if (pass->draw != NULL) pass->draw(pass->data, pass);
+        if (pass->input != NULL) {
+            passes->readers[pass->input - passes->passes]--;
+            retire_pass(passes, pass->input);
+        }
+        retire_pass(passes, pass);
+    }
+
+    if (set_render_target(previous) != 0) {
+        ERROR("Unable to restore the render target");
+        goto release;
+    }
+    for (i = 0; i < passes->count; i++) {
+        pass = &passes->passes[i];
+        if (!pass->composite) continue;
+        set_blend_mode(pass->target, pass->blend);
+        draw_image(pass->target, pass->x, pass->y, NULL, 0);
+    }
+    ret = 0;
+
+release:
+    if (ret != 0) set_render_target(previous);
+    for (i = 0; i < passes->count; i++) {
+        pass = &passes->passes[i];
+        /* a queued composite still needs its target when flushed */
+        if (pass->target != NULL &&
+            !(ret == 0 && pass->composite && hold_until_flushed(pass->target)))
+            release_render_target(pass->target);
+        pass->target = NULL;
+    }
+    return ret;
+}
+#include "end_prefix.h"
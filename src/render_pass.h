@@ -0,0 +1,151 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#ifndef RENDER_PASS_H_W7TQ3KZN
+#define RENDER_PASS_H_W7TQ3KZN
+
+#include "image.h"
+#include "color.h"
+#include "types.h"
+
+#include "begin_prefix.h"
+struct render_pass;
+
+/**
+ * This is the prototype of a render pass draw function. It is called
+ * with the pass target bound, so any image, sprite or text drawn in it
+ * lands on the pass target instead of the screen.
+ */
+typedef void (*render_pass_func_t)(void* data, struct render_pass* pass);
+
+/**
+ * A render pass draws into an off-screen target borrowed from a pool
+ * of target images. Set up the pass fields after adding it using
+ * add_render_pass().
+ */
+struct render_pass {
+    /** target width in pixels */
+    int width;
+    /** target height in pixels */
+    int height;
+    /** clear the target when it is bound, instead of using clear_image() */
+    bool clear_on_bind;
+    /** color to clear the target with */
+    struct color clear_color;
+    /** pass whose target this pass reads while drawing, or NULL */
+    struct render_pass* input;
+    /** draw the target on the screen once all passes are done */
+    bool composite;
+    /** x coordinates to composite the target at */
+    int x;
+    /** y coordinates to composite the target at */
+    int y;
+    /** blend mode to composite the target with */
+    enum blend_mode blend;
+    /** function drawing the pass */
+    render_pass_func_t draw;
+    /** user data handed to the draw function */
+    void* data;
+    /** the target image, only valid while the passes run */
+    struct image* target;
+};
+
+/**
+ * Render passes declare off-screen drawing up front, so Cage can order
+ * it and keep target switches to a minimum. Rather than keeping a long
+ * lived target image and switching between draw_on_image() and
+ * draw_on_screen(), declare a pass once:
+ *
+ *     struct render_passes* passes = create_render_passes(4);
+ *     struct render_pass* light = add_render_pass(passes, 320, 180,
+ *                                                 draw_lights, game);
+ *     light->clear_on_bind = true;
+ *     light->clear_color = color_from_RGB(40, 40, 40);
+ *     light->composite = true;
+ *     light->blend = MULTIPLY;
+ *
+ * Then, once per frame, where the result should land on the screen:
+ *
+ *     run_render_passes(passes);
+ *
+ * Passes run before any pass that reads them as an input, then every
+ * composited pass is drawn on the screen in the order the passes were
+ * added. Targets come from a pool shared by all render passes, and a
+ * target is handed to the next pass of the same size as soon as
+ * nothing needs it anymore.
+ */
+struct render_passes {
+    /** maximum number of passes */
+    int capacity;
+    /** number of passes added */
+    int count;
+    /** the passes, in the order they were added */
+    struct render_pass* passes;
+    /* execution order and per-pass bookkeeping */
+    int* order;
+    int* readers;
+};
+
+/**
+ * Allocate a new render pass list
+ * @param capacity maximum number of passes
+ *
+ * @return a new render pass list or NULL on error
+ */
+struct render_passes* create_render_passes(int capacity);
+
+/**
+ * Destroy a render pass list created using create_render_passes()
+ * @param passes render pass list to destroy
+ */
+void destroy_render_passes(struct render_passes* passes);
+
+/**
+ * Add a render pass
+ * @param passes render pass list to add the pass to
+ * @param width target width in pixels
+ * @param height target height in pixels
+ * @param draw function drawing the pass
+ * @param data user data handed to the draw function
+ *
+ * @return the new \ref render_pass or NULL if the list is full
+ */
+struct render_pass* add_render_pass(struct render_passes* passes,
+                                    int width,
+                                    int height,
+                                    render_pass_func_t draw,
+                                    void* data);
+
+/**
+ * Run all passes and composite their targets on the screen
+ * @param passes render pass list to run
+ *
+ * @return 0 on success or -1 on error
+ */
+int run_render_passes(struct render_passes* passes);
+
+/**
+ * Destroy all pooled target images that are not in use.
+ */
+void purge_render_targets(void);
+
+#include "end_prefix.h"
+#endif /* end of include guard: RENDER_PASS_H_W7TQ3KZN */
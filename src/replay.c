@@ -0,0 +1,251 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "replay.h"
+#include "internals.h"
+#include "mouse.h"
+#include "snapshot.h"
+#include "utils.h"
+#include <stdint.h>
+#include <string.h>
+
+#include "begin_prefix.h"
+
+/* Recordings are snapshots of REPLAY_VERSION holding one record per
+ * frame:
+ *
+ *   flags     FRAME_* bits telling which of the fields below follow
+ *   time      stopwatch as a varint, or a float with FRAME_TIME_FLOAT
+ *   mouse     x and y position floats, with FRAME_MOUSE_MOVED
+ *   buttons   BUTTON_* bits, with FRAME_BUTTONS
+ *   keys      number of changed keys followed by a varint per key,
+ *             scancode << 1 | down, with FRAME_KEYS
+ *
+ * Fields other than the time are only written when they changed since
+ * the previous frame, so an idle frame takes 2 bytes.
+ */
+#define REPLAY_VERSION 1
+#define FRAME_TIME_FLOAT 1
+#define FRAME_MOUSE_MOVED 2
+#define FRAME_BUTTONS 4
+#define FRAME_KEYS 8
+#define BUTTON_LEFT 1
+#define BUTTON_RIGHT 2
+#define BUTTON_MIDDLE 4
+
+struct input_track {
+    struct snapshot* frames;
+    /* keyboard and mouse state as of the last frame */
+    uint8_t keys[SDL_NUM_SCANCODES];
+    struct mouse mouse;
+};
+
+static struct input_track recording;
+static struct input_track replaying;
+static char* record_file = NULL;
+
+static uint8_t button_bits(const struct mouse* mouse)
+{
+    return (mouse->left_click ? BUTTON_LEFT : 0) |
+           (mouse->right_click ? BUTTON_RIGHT : 0) |
+           (mouse->middle_click ? BUTTON_MIDDLE : 0);
+}
+
+static struct snapshot* load_recording(const char* path)
+{
+    SDL_RWops* rw = SDL_RWFromFile(path, "rb");
+    struct snapshot* frames = NULL;
+    void* buf = NULL;
+    Sint64 size;
+    if (rw == NULL) {
+        ERROR("Unable to open the input recording");
+        return NULL;
+    }
+    size = SDL_RWsize(rw);
+    if (size <= 0 || size > 0x7FFFFFFF) {
+        ERROR("Invalid input recording");
+        goto cleanup;
+    }
+    buf = MALLOC((size_t)size, MEMORY_ENGINE);
+    frames = create_snapshot((size_t)size);
+    if (buf == NULL || frames == NULL) {
+        ERROR("Not enough memory for the input recording");
+        goto cleanup;
+    }
+    if (SDL_RWread(rw, buf, (size_t)size, 1) != 1 ||
+        set_snapshot_data(frames, buf, (size_t)size) != REPLAY_VERSION) {
+        ERROR("Invalid input recording");
+        goto cleanup;
+    }
+    FREE(buf);
+    SDL_RWclose(rw);
+    return frames;
+cleanup:
+    destroy_snapshot(frames);
+    FREE(buf);
+    SDL_RWclose(rw);
+    return NULL;
+}
+
+static int save_recording(void)
+{
+    SDL_RWops* rw;
+    int size = end_snapshot(recording.frames);
+    if (size == -1) return -1;
+    rw = SDL_RWFromFile(record_file, "wb");
+    if (rw == NULL) {
+        ERROR("Unable to create the input recording");
+        return -1;
+    }
+    if (SDL_RWwrite(rw, recording.frames->data, (size_t)size, 1) != 1) {
+        ERROR("Unable to write the input recording");
+        SDL_RWclose(rw);
+        return -1;
+    }
+    return SDL_RWclose(rw) == 0 ? size : -1;
+}
+
+static void record_frame(float stopwatch)
+{
+    struct snapshot* frames = recording.frames;
+    size_t flags_at = frames->size;
+    uint8_t flags = 0;
+    uint8_t buttons = button_bits(mouse_state);
+    uint32_t n_keys = 0;
+    int i;
+
+    write_u8(frames, 0);
+    if (stopwatch >= 0 && stopwatch < 4294967296.0f &&
+        (float)(uint32_t)stopwatch == stopwatch) {
+        write_varint(frames, (uint32_t)stopwatch);
+    } else {
+        flags |= FRAME_TIME_FLOAT;
+        write_float(frames, stopwatch);
+    }
+    if (mouse_state->x_position != recording.mouse.x_position ||
+        mouse_state->y_position != recording.mouse.y_position) {
+        flags |= FRAME_MOUSE_MOVED;
+        write_float(frames, mouse_state->x_position);
+        write_float(frames, mouse_state->y_position);
+    }
+    if (buttons != button_bits(&recording.mouse)) {
+        flags |= FRAME_BUTTONS;
+        write_u8(frames, buttons);
+    }
+    recording.mouse = *mouse_state;
+
+    for (i = 0; i < SDL_NUM_SCANCODES; i++)
+        if ((keyboard->keys[i] != 0) != recording.keys[i]) n_keys++;
+    if (n_keys > 0) {
+        flags |= FRAME_KEYS;
+        write_varint(frames, n_keys);
+        for (i = 0; i < SDL_NUM_SCANCODES; i++) {
+            if ((keyboard->keys[i] != 0) == recording.keys[i]) continue;
+            recording.keys[i] = keyboard->keys[i] != 0;
+            write_varint(frames, ((uint32_t)i << 1) | recording.keys[i]);
+        }
+    }
+    if (!frames->failed) frames->data[flags_at] = flags;
+}
+
+static int play_frame(float* stopwatch)
+{
+    struct snapshot* frames = replaying.frames;
+    uint8_t flags;
+    uint8_t buttons;
+    uint32_t n_keys;
+    uint32_t key;
+
+    if (frames->position == frames->size) return -1;
+    flags = read_u8(frames);
+    if (flags & FRAME_TIME_FLOAT)
+        *stopwatch = read_float(frames);
+    else
+        *stopwatch = (float)read_varint(frames);
+    if (flags & FRAME_MOUSE_MOVED) {
+        replaying.mouse.x_position = read_float(frames);
+        replaying.mouse.y_position = read_float(frames);
+    }
+    if (flags & FRAME_BUTTONS) {
+        buttons = read_u8(frames);
+        replaying.mouse.left_click = (buttons & BUTTON_LEFT) != 0;
+        replaying.mouse.right_click = (buttons & BUTTON_RIGHT) != 0;
+        replaying.mouse.middle_click = (buttons & BUTTON_MIDDLE) != 0;
+    }
+    n_keys = flags & FRAME_KEYS ? read_varint(frames) : 0;
+    for (; n_keys > 0 && !frames->failed; n_keys--) {
+        key = read_varint(frames);
+        if ((key >> 1) >= SDL_NUM_SCANCODES) frames->failed = true;
+        else replaying.keys[key >> 1] = key & 1;
+    }
+    if (frames->failed) {
+        ERROR("Invalid input recording");
+        return -1;
+    }
+    *mouse_state = replaying.mouse;
+    keyboard->keys = replaying.keys;
+    return 0;
+}
+
+int prepare_replay(const char* record_path, const char* replay_path)
+{
+    if (replay_path != NULL) {
+        replaying.frames = load_recording(replay_path);
+        if (replaying.frames == NULL) return -1;
+    }
+    if (record_path != NULL) {
+        record_file = (char*)MALLOC(strlen(record_path) + 1, MEMORY_ENGINE);
+        recording.frames = create_snapshot(64 * 1024);
+        if (record_file == NULL || recording.frames == NULL) {
+            ERROR("Not enough memory for the input recording");
+            teardown_replay();
+            return -1;
+        }
+        strcpy(record_file, record_path);
+        begin_snapshot(recording.frames, REPLAY_VERSION);
+    }
+    return 0;
+}
+
+int replay_frame(float* stopwatch)
+{
+    if (replaying.frames != NULL && play_frame(stopwatch) == -1) return -1;
+    if (recording.frames != NULL) record_frame(*stopwatch);
+    return 0;
+}
+
+void teardown_replay(void)
+{
+    if (recording.frames != NULL && record_file != NULL) save_recording();
+    destroy_snapshot(recording.frames);
+    destroy_snapshot(replaying.frames);
+    FREE(record_file);
+    memset(&recording, 0, sizeof(recording));
+    memset(&replaying, 0, sizeof(replaying));
+    record_file = NULL;
+}
+
+bool is_replaying_input(void)
+{
+    return replaying.frames != NULL;
+}
+
+#include "end_prefix.h"
@@ -0,0 +1,56 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#ifndef REPLAY_H_W8FQ3KZM
+#define REPLAY_H_W8FQ3KZM
+
+#include "types.h"
+
+#include "begin_prefix.h"
+/**
+ * Check if the game loop is replaying recorded input.
+ *
+ * Set \ref settings record_input to a file path in your setup function
+ * and the game loop records the keyboard state, the mouse state and the
+ * stopwatch of every frame to that file when the game quits:
+ *
+ *     void setup(struct settings* settings)
+ *     {
+ *         ...
+ *         settings->record_input = "run.rec";
+ *     }
+ *
+ * The same goes for a ``record_input run.rec`` line in res/game.conf.
+ * Set replay_input to the same path and the game loop feeds the
+ * recorded frames back to the game instead of sampling the keyboard
+ * and mouse, and hands the recorded elapsed time to the update
+ * function. The frame rate limit is lifted, so the replay runs as fast
+ * as the game can go, and the game loop quits after the last recorded
+ * frame. Games that draw random numbers should use a fixed seed while
+ * replaying, so every run of the same recording plays out the same
+ * way and frame times can be compared between runs.
+ *
+ * @return true while replaying input or false otherwise
+ */
+bool is_replaying_input(void);
+
+#include "end_prefix.h"
+#endif /* end of include guard: REPLAY_H_W8FQ3KZM */
@@ -22,6 +22,7 @@
 #include "screen.h"
 #include "easing.h"
 #include "internals.h"
+#include "image.h"
 #include "utils.h"
 #include <stdlib.h>
 
@@ -73,22 +74,215 @@ void relax_screen(float stopwatch)
 
 void screen_color(struct color bg)
 {
-    SDL_SetRenderDrawColor(screen->impl, bg.red, bg.green, bg.blue, bg.alpha);
+    screen->background = bg;
+    set_render_draw_color(bg);
 }
 
 void draw_on_screen(void)
 {
-    int ret = SDL_SetRenderTarget(screen->impl, NULL);
+    int ret = set_render_target(NULL);
     if (ret != 0) exit(1);
 }
 
+void reset_render_state(void)
+{
+    screen->target = NULL;
+    screen->draw_color_known = 0;
+}
+
+static int bind_scene(void)
+{
+    int ret = SDL_SetRenderTarget(screen->impl, screen->scene->impl);
+    if (ret != 0) return ret;
+    /* SDL resets the scale whenever a target texture is bound */
+    SDL_RenderSetScale(screen->impl, screen->render_scale,
+                       screen->render_scale);
+    screen->target = NULL;
+    return 0;
+}
+
+int set_render_target(struct image* target)
+{
+    int ret;
+    if (target == screen->target) {
+        screen->stats.elided++;
+        return 0;
+    }
+    screen->stats.issued++;
+    if (target == NULL && screen->scene != NULL) return bind_scene();
+    ret = SDL_SetRenderTarget(screen->impl,
+                              target != NULL ? target->impl : NULL);
+    if (ret == 0) screen->target = target;
+    return ret;
+}
+
+void set_render_draw_color(struct color color)
+{
+    if (screen->draw_color_known && color.red == screen->draw_color.red &&
+        color.green == screen->draw_color.green &&
+        color.blue == screen->draw_color.blue &&
+        color.alpha == screen->draw_color.alpha) {
+        screen->stats.elided++;
+        return;
+    }
+    screen->stats.issued++;
+    SDL_SetRenderDrawColor(screen->impl, color.red, color.green, color.blue,
+                           color.alpha);
+    screen->draw_color = color;
+    screen->draw_color_known = 1;
+}
+
+/* frames between render scale adjustments */
+#define SCALE_FRAMES 30
+/* render scale steps, down quickly and up slowly */
+#define SCALE_DOWN 0.1f
+#define SCALE_UP 0.05f
+/* frame time below which the render scale goes up, as a fraction of
+ * the budget, leaving room so the scale does not flip back and forth */
+#define SCALE_UP_BELOW 0.75f
+
+int prepare_dynamic_resolution(float frame_budget, float min_render_scale)
+{
+    screen->scene = create_target_image(screen->width, screen->height,
+                                        screen->background);
+    if (screen->scene == NULL) {
+        ERROR("Unable to create the dynamic resolution scene target");
+        return -1;
+    }
+    screen->render_scale = 1;
+    screen->min_render_scale = clamp(min_render_scale, 0.1f, 1.0f);
+    screen->frame_budget = frame_budget;
+    screen->frame_time = 0;
+    screen->scale_frames = 0;
+    return 0;
+}
+
+void teardown_dynamic_resolution(void)
+{
+    if (screen->scene != NULL) {
+        destroy_image(screen->scene);
+        screen->scene = NULL;
+    }
+}
+
+void begin_frame(void)
+{
+    if (screen->scene != NULL) {
+        screen->stats.issued++;
+        if (bind_scene() != 0) exit(1);
+    }
+    set_render_draw_color(screen->background);
+    SDL_RenderClear(screen->impl);
+}
+
+static void update_render_scale(float frame_ms)
+{
+    float scale = screen->render_scale;
+    screen->frame_time += (frame_ms - screen->frame_time) * 0.1f;
+    if (++screen->scale_frames < SCALE_FRAMES) return;
+    screen->scale_frames = 0;
+    if (screen->frame_time > screen->frame_budget)
+        scale -= SCALE_DOWN;
+    else if (screen->frame_time < screen->frame_budget * SCALE_UP_BELOW)
+        scale += SCALE_UP;
+    screen->render_scale = clamp(scale, screen->min_render_scale, 1.0f);
+}
+
+void present_frame(uint64_t frame_start)
+{
+    SDL_Rect used;
+    if (screen->scene == NULL) {
+        SDL_RenderPresent(screen->impl);
+        return;
+    }
+    used.x = 0;
+    used.y = 0;
+    used.w = (int)(screen->scene->width * screen->render_scale + 0.5f);
+    used.h = (int)(screen->scene->height * screen->render_scale + 0.5f);
+    /* stretch the part of the scene in use over the logical screen,
+     * leaving the cached target pointing at the scene for the next
+     * begin_frame() to bind again */
+    SDL_SetRenderTarget(screen->impl, NULL);
+    set_texture_blend_mode(screen->scene, SDL_BLENDMODE_NONE);
+    set_texture_color_mod(screen->scene, 255, 255, 255);
+    set_texture_alpha_mod(screen->scene, 255);
+    SDL_RenderCopy(screen->impl, screen->scene->impl, &used, NULL);
+    SDL_RenderPresent(screen->impl);
+    update_render_scale((float)((SDL_GetPerformanceCounter() - frame_start) *
+                                1000.0 / SDL_GetPerformanceFrequency()));
+}
+
+float get_render_scale(void)
+{
+    return screen->scene != NULL ? screen->render_scale : 1.0f;
+}
+
+void get_render_target_size(int* width, int* height)
+{
+    if (screen->target != NULL) {
+        *width = screen->target->width;
+        *height = screen->target->height;
+    } else if (screen->width > 0 && screen->height > 0) {
+        *width = screen->width;
+        *height = screen->height;
+    } else {
+        SDL_GetRendererOutputSize(screen->impl, width, height);
+    }
+}
+
+int cull_quad(float left, float top, float right, float bottom)
+{
+    int width, height;
+    get_render_target_size(&width, &height);
+    if (right <= 0 || bottom <= 0 || left >= width || top >= height) {
+        screen->stats.culled++;
+        return 1;
+    }
+    screen->stats.submitted++;
+    return 0;
+}
+
+void get_render_stats(struct render_stats* stats)
+{
+    *stats = screen->stats;
+}
+
+void reset_render_stats(void)
+{
+    screen->stats.issued = 0;
+    screen->stats.elided = 0;
+    screen->stats.submitted = 0;
+    screen->stats.culled = 0;
+}
+
 void set_screen_size(int width, int height)
 {
     SDL_RenderSetLogicalSize(screen->impl, width, height);
+    screen->width = width;
+    screen->height = height;
+    if (screen->scene != NULL) {
+        /* the scene target follows the logical size */
+        struct image* scene = create_target_image(width, height,
+                                                  screen->background);
+        if (scene == NULL) {
+            ERROR("Unable to resize the dynamic resolution scene target");
+            return;
+        }
+        destroy_image(screen->scene);
+        screen->scene = scene;
+        if (screen->target == NULL) bind_scene();
+    }
 }
 
 void get_screen_size(int* width, int* height)
 {
+    /* the renderer reports the size of target images while one is
+     * bound, so rely on the cached size when there is one */
+    if (screen->width > 0 && screen->height > 0) {
+        *width = screen->width;
+        *height = screen->height;
+        return;
+    }
     SDL_RenderGetLogicalSize(screen->impl, width, height);
 }
 
@@ -25,6 +25,26 @@
 #include "color.h"
 
 #include "begin_prefix.h"
+/**
+ * Renderer counters.
+ * Cage remembers the render target, draw color and the blend mode,
+ * alpha and color modulation of every image, and skips state changes
+ * that would not change anything. It also skips drawing images that
+ * land completely outside the screen, or the image being drawn on.
+ * Use these counters to see how much work actually reached the
+ * renderer.
+ */
+struct render_stats {
+    /** state changes passed on to the renderer */
+    unsigned long issued;
+    /** redundant state changes that were skipped */
+    unsigned long elided;
+    /** quads passed on to the renderer */
+    unsigned long submitted;
+    /** quads skipped for being outside the render target */
+    unsigned long culled;
+};
+
 /**
  * Change the screen background color.
  */
@@ -69,6 +89,24 @@ void set_window_size(int width, int height);
  */
 void get_window_size(int* width, int* height);
 
+/**
+ * Get the fraction of the screen size the game is drawn at
+ *
+ * @return 1, or less while dynamic resolution lowers the resolution to
+ * fit the frame time budget set in \ref settings
+ */
+float get_render_scale(void);
+
+/**
+ * Get the renderer counters
+ * @param stats \ref render_stats to fill
+ */
+void get_render_stats(struct render_stats* stats);
+
+/**
+ * Reset the renderer counters, e.g. at the start of a frame.
+ */
+void reset_render_stats(void);
 
 /* cldoc:end-category() */
 
@@ -0,0 +1,477 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "snapshot.h"
+#include "internals.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "begin_prefix.h"
+
+/* Snapshot layout, all integers little endian:
+ *
+ *   header    magic, 32 bit layout version, 32 bit payload size
+ *   payload   the values written between begin_snapshot() and
+ *             end_snapshot()
+ *
+ * Delta layout:
+ *
+ *   header    magic, 32 bit base size, 32 bit base checksum and 32 bit
+ *             snapshot size
+ *   runs      pairs of varints, the number of bytes to copy from base
+ *             followed by the number of literal bytes, then the literal
+ *             bytes themselves
+ *
+ * Whatever follows the last run is copied from base.
+ */
+#define SNAPSHOT_MAGIC "CSNP"
+#define DELTA_MAGIC "CSND"
+#define HEADER_SIZE 12
+#define DELTA_HEADER_SIZE 16
+#define MIN_CAPACITY 256
+/* A literal run ends once this many bytes match base again, shorter
+ * matches cost more to encode than to copy */
+#define MIN_MATCH 8
+
+static void put32(unsigned char* p, uint32_t value)
+{
+    p[0] = (unsigned char)value;
+    p[1] = (unsigned char)(value >> 8);
+    p[2] = (unsigned char)(value >> 16);
+    p[3] = (unsigned char)(value >> 24);
+}
+
+static uint32_t get32(const unsigned char* p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 |
+           (uint32_t)p[3] << 24;
+}
+
+static int grow(struct snapshot* snapshot, size_t size)
+{
+    size_t capacity = snapshot->capacity;
+    unsigned char* data;
+    if (size <= capacity) return 0;
+    if (capacity < MIN_CAPACITY) capacity = MIN_CAPACITY;
+    while (capacity < size) capacity *= 2;
+    data = (unsigned char*)REALLOC(snapshot->data, capacity, MEMORY_SNAPSHOTS);
+    if (data == NULL) {
+        ERROR("Not enough memory for snapshot");
+        return -1;
+    }
+    snapshot->data = data;
+    snapshot->capacity = capacity;
+    return 0;
+}
+
+static unsigned char* reserve(struct snapshot* snapshot, size_t size)
+{
+    unsigned char* p;
+    if (snapshot->failed) return NULL;
+    if (snapshot->size + size > 0x7FFFFFFF ||
+        grow(snapshot, snapshot->size + size) == -1) {
+        snapshot->failed = true;
+        return NULL;
+    }
+    p = snapshot->data + snapshot->size;
+    snapshot->size += size;
+    return p;
+}
+
+static const unsigned char* take(struct snapshot* snapshot, size_t size)
+{
+    const unsigned char* p;
+    if (snapshot->failed || snapshot->size - snapshot->position < size) {
+        snapshot->failed = true;
+        return NULL;
+    }
+    p = snapshot->data + snapshot->position;
+    snapshot->position += size;
+    return p;
+}
+
+static uint32_t checksum(const unsigned char* data, size_t size)
+{
+    uint32_t hash = 2166136261u;
+    size_t i;
+    for (i = 0; i + 4 <= size; i += 4) {
+        hash = (hash ^ get32(data + i)) * 0x9E3779B1u;
+        hash ^= hash >> 15;
+    }
+    for (; i < size; i++) hash = (hash ^ data[i]) * 16777619u;
+    return hash;
+}
+
+struct snapshot* create_snapshot(size_t capacity)
+{
+    struct snapshot* snapshot;
+    snapshot = (struct snapshot*)CALLOC(1, sizeof(struct snapshot),
+                                        MEMORY_SNAPSHOTS);
+    if (snapshot == NULL) {
+        ERROR("Not enough memory for snapshot");
+        return NULL;
+    }
+    if (grow(snapshot, capacity > HEADER_SIZE ? capacity : HEADER_SIZE) == -1) {
+        FREE(snapshot);
+        return NULL;
+    }
+    return snapshot;
+}
+
+void destroy_snapshot(struct snapshot* snapshot)
+{
+    if (snapshot == NULL) return;
+    FREE(snapshot->data);
+    FREE(snapshot);
+}
+
+void begin_snapshot(struct snapshot* snapshot, int version)
+{
+    unsigned char* header;
+    snapshot->size = 0;
+    snapshot->position = 0;
+    snapshot->failed = false;
+    header = reserve(snapshot, HEADER_SIZE);
+    if (header == NULL) return;
+    memcpy(header, SNAPSHOT_MAGIC, 4);
+    put32(header + 4, (uint32_t)version);
+    put32(header + 8, 0);
+}
+
+int end_snapshot(struct snapshot* snapshot)
+{
+    if (snapshot->failed || snapshot->size < HEADER_SIZE) return -1;
+    put32(snapshot->data + 8, (uint32_t)(snapshot->size - HEADER_SIZE));
+    return (int)snapshot->size;
+}
+
+int rewind_snapshot(struct snapshot* snapshot)
+{
+    uint32_t version;
+    snapshot->position = 0;
+    snapshot->failed = true;
+    if (snapshot->size < HEADER_SIZE ||
+        memcmp(snapshot->data, SNAPSHOT_MAGIC, 4) != 0 ||
+        get32(snapshot->data + 8) != snapshot->size - HEADER_SIZE) {
+        ERROR("Invalid snapshot");
+        return -1;
+    }
+    version = get32(snapshot->data + 4);
+    if (version > 0x7FFFFFFF) {
+        ERROR("Invalid snapshot version");
+        return -1;
+    }
+    snapshot->position = HEADER_SIZE;
+    snapshot->failed = false;
+    return (int)version;
+}
+
+int set_snapshot_data(struct snapshot* snapshot,
+                      const void* data,
+                      size_t size)
+{
+    snapshot->size = 0;
+    snapshot->failed = false;
+    if (reserve(snapshot, size) == NULL) return -1;
+    memcpy(snapshot->data, data, size);
+    return rewind_snapshot(snapshot);
+}
+
+int save_snapshot(const struct snapshot* snapshot, struct file_spec file_spec)
+{
+    if (snapshot->failed || snapshot->size < HEADER_SIZE) {
+        ERROR("Saving an unfinished snapshot");
+        return -1;
+    }
+    return write_file_data(file_spec, snapshot->data, snapshot->size);
+}
+
+int load_snapshot(struct snapshot* snapshot, struct file_spec file_spec)
+{
+    struct file_view view;
+    int version;
+    if (map_file(&view, file_spec) == -1) return -1;
+    version = set_snapshot_data(snapshot, view.data, view.size);
+    unmap_file(&view);
+    return version;
+}
+
+int make_snapshot_delta(struct snapshot* delta,
+                        const struct snapshot* base,
+                        const struct snapshot* current)
+{
+    const unsigned char* b = base->data;
+    const unsigned char* c = current->data;
+    size_t size = current->size;
+    size_t common = base->size < size ? base->size : size;
+    size_t i = 0;
+    size_t start;
+    size_t literal;
+    unsigned char* header;
+
+    delta->size = 0;
+    delta->position = 0;
+    delta->failed = false;
+    header = reserve(delta, DELTA_HEADER_SIZE);
+    if (header == NULL) return -1;
+    memcpy(header, DELTA_MAGIC, 4);
+    put32(header + 4, (uint32_t)base->size);
+    put32(header + 8, checksum(b, base->size));
+    put32(header + 12, (uint32_t)size);
+
+    while (i < size) {
+        start = i;
+        while (i + MIN_MATCH <= common && memcmp(b + i, c + i, MIN_MATCH) == 0)
+            i += MIN_MATCH;
+        while (i < common && b[i] == c[i]) i++;
+        if (i == size) break;
+        write_varint(delta, (uint32_t)(i - start));
+
+        literal = i;
+        if (i >= common) {
+            i = size;
+        } else {
+            while (i < size && !(i + MIN_MATCH <= common &&
+                                 memcmp(b + i, c + i, MIN_MATCH) == 0))
+                i++;
+        }
+        write_varint(delta, (uint32_t)(i - literal));
+        header = reserve(delta, i - literal);
+        if (header != NULL) memcpy(header, c + literal, i - literal);
+    }
+    if (delta->failed) return -1;
+    return (int)delta->size;
+}
+
+int apply_snapshot_delta(struct snapshot* snapshot,
+                         const struct snapshot* base,
+                         const struct snapshot* delta)
+{
+    struct snapshot runs = *delta;
+    const unsigned char* header = delta->data;
+    const unsigned char* literal;
+    size_t size;
+    size_t copy;
+    size_t position = 0;
+
+    if (delta->size < DELTA_HEADER_SIZE ||
+        memcmp(header, DELTA_MAGIC, 4) != 0) {
+        ERROR("Invalid snapshot delta");
+        return -1;
+    }
+    if (get32(header + 4) != base->size ||
+        get32(header + 8) != checksum(base->data, base->size)) {
+        ERROR("Snapshot delta does not match its base");
+        return -1;
+    }
+    size = get32(header + 12);
+    snapshot->size = 0;
+    snapshot->failed = false;
+    if (reserve(snapshot, size) == NULL) return -1;
+
+    runs.position = DELTA_HEADER_SIZE;
+    runs.failed = false;
+    while (runs.position < runs.size) {
+        copy = read_varint(&runs);
+        if (copy > size - position ||
+            (copy > 0 && position + copy > base->size))
+            break;
+        memcpy(snapshot->data + position, base->data + position, copy);
+        position += copy;
+        copy = read_varint(&runs);
+        literal = take(&runs, copy);
+        if (literal == NULL || copy > size - position) break;
+        memcpy(snapshot->data + position, literal, copy);
+        position += copy;
+    }
+    if (runs.position != runs.size || runs.failed ||
+        (position < size && size > base->size)) {
+        ERROR("Invalid snapshot delta");
+        snapshot->size = 0;
+        return -1;
+    }
+    memcpy(snapshot->data + position, base->data + position, size - position);
+    return rewind_snapshot(snapshot);
+}
+
+void write_u8(struct snapshot* snapshot, uint8_t value)
+{
+    unsigned char* p = reserve(snapshot, 1);
+    if (p != NULL) *p = value;
+}
+
+void write_u16(struct snapshot* snapshot, uint16_t value)
+{
+    unsigned char* p = reserve(snapshot, 2);
+    if (p == NULL) return;
+    p[0] = (unsigned char)value;
+    p[1] = (unsigned char)(value >> 8);
+}
+
+void write_u32(struct snapshot* snapshot, uint32_t value)
+{
+    unsigned char* p = reserve(snapshot, 4);
+    if (p != NULL) put32(p, value);
+}
+
+void write_u64(struct snapshot* snapshot, uint64_t value)
+{
+    unsigned char* p = reserve(snapshot, 8);
+    if (p == NULL) return;
+    put32(p, (uint32_t)value);
+    put32(p + 4, (uint32_t)(value >> 32));
+}
+
+void write_i32(struct snapshot* snapshot, int32_t value)
+{
+    write_u32(snapshot, (uint32_t)value);
+}
+
+void write_float(struct snapshot* snapshot, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    write_u32(snapshot, bits);
+}
+
+void write_double(struct snapshot* snapshot, double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    write_u64(snapshot, bits);
+}
+
+void write_varint(struct snapshot* snapshot, uint32_t value)
+{
+    unsigned char* p;
+    while (value >= 0x80) {
+        p = reserve(snapshot, 1);
+        if (p == NULL) return;
+        *p = (unsigned char)(value | 0x80);
+        value >>= 7;
+    }
+    p = reserve(snapshot, 1);
+    if (p != NULL) *p = (unsigned char)value;
+}
+
+void write_bytes(struct snapshot* snapshot, const void* data, size_t size)
+{
+    unsigned char* p = reserve(snapshot, size);
+    if (p != NULL && size > 0) memcpy(p, data, size);
+}
+
+void write_string(struct snapshot* snapshot, const char* str)
+{
+    size_t length = strlen(str);
+    write_varint(snapshot, (uint32_t)length);
+    write_bytes(snapshot, str, length);
+}
+
+uint8_t read_u8(struct snapshot* snapshot)
+{
+    const unsigned char* p = take(snapshot, 1);
+    return p == NULL ? 0 : *p;
+}
+
+uint16_t read_u16(struct snapshot* snapshot)
+{
+    const unsigned char* p = take(snapshot, 2);
+    return p == NULL ? 0 : (uint16_t)(p[0] | p[1] << 8);
+}
+
+uint32_t read_u32(struct snapshot* snapshot)
+{
+    const unsigned char* p = take(snapshot, 4);
+    return p == NULL ? 0 : get32(p);
+}
+
+uint64_t read_u64(struct snapshot* snapshot)
+{
+    const unsigned char* p = take(snapshot, 8);
+    return p == NULL ? 0 : (uint64_t)get32(p) | (uint64_t)get32(p + 4) << 32;
+}
+
+int32_t read_i32(struct snapshot* snapshot)
+{
+    uint32_t value = read_u32(snapshot);
+    int32_t result;
+    memcpy(&result, &value, sizeof(result));
+    return result;
+}
+
+float read_float(struct snapshot* snapshot)
+{
+    uint32_t bits = read_u32(snapshot);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+double read_double(struct snapshot* snapshot)
+{
+    uint64_t bits = read_u64(snapshot);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+uint32_t read_varint(struct snapshot* snapshot)
+{
+    const unsigned char* p;
+    uint32_t value = 0;
+    int shift;
+    for (shift = 0; shift < 35; shift += 7) {
+        p = take(snapshot, 1);
+        if (p == NULL) return 0;
+        value |= (uint32_t)(*p & 0x7F) << shift;
+        if ((*p & 0x80) == 0) return value;
+    }
+    snapshot->failed = true;
+    return 0;
+}
+
+int read_bytes(struct snapshot* snapshot, void* data, size_t size)
+{
+    const unsigned char* p = take(snapshot, size);
+    if (p == NULL) {
+        memset(data, 0, size);
+        return -1;
+    }
+    if (size > 0) memcpy(data, p, size);
+    return 0;
+}
+
+int read_string(struct snapshot* snapshot, char* str, size_t size)
+{
+    size_t length = read_varint(snapshot);
+    const unsigned char* p = take(snapshot, length);
+    size_t n;
+    if (size == 0) return -1;
+    str[0] = '\0';
+    if (p == NULL) return -1;
+    n = length < size ? length : size - 1;
+    memcpy(str, p, n);
+    str[n] = '\0';
+    return n == length ? 0 : -1;
+}
+
+#include "end_prefix.h"
@@ -0,0 +1,334 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#ifndef SNAPSHOT_H_T5JW2NXC
+#define SNAPSHOT_H_T5JW2NXC
+
+#include <stdint.h>
+#include <stddef.h>
+#include "types.h"
+#include "file.h"
+
+#include "begin_prefix.h"
+/**
+ * Snapshots serialize game state into a single contiguous buffer, for
+ * save games and for rewind or rollback, where a snapshot is taken
+ * every frame. Write the state between begin_snapshot() and
+ * end_snapshot(), tagging it with the version of your own state layout:
+ *
+ *     begin_snapshot(snap, 2);
+ *     write_i32(snap, player.x);
+ *     write_i32(snap, player.y);
+ *     write_u16(snap, player.health);
+ *     end_snapshot(snap);
+ *
+ * Read it back in the same order. rewind_snapshot() returns the layout
+ * version the snapshot was written with, so older saves keep loading:
+ *
+ *     int version = rewind_snapshot(snap);
+ *     player.x = read_i32(snap);
+ *     player.y = read_i32(snap);
+ *     player.health = version >= 2 ? read_u16(snap) : 100;
+ *     if (snap->failed) // corrupt or truncated snapshot
+ *
+ * Values are stored little endian, so snapshots move between platforms.
+ * A snapshot keeps its buffer between uses, so once it has grown to the
+ * size of the state, taking a new one does not allocate.
+ *
+ * Consecutive frames differ in a few bytes, so rollback buffers keep a
+ * full snapshot every now and then and the frames in between as deltas,
+ * see make_snapshot_delta().
+ */
+struct snapshot {
+    /** snapshot bytes, header included */
+    unsigned char* data;
+    /** number of bytes in data */
+    size_t size;
+    /* allocated size of data */
+    size_t capacity;
+    /** read position in data */
+    size_t position;
+    /** set when a write runs out of memory or a read goes past the end
+     * of the data. Reads and writes do nothing once it is set. */
+    bool failed;
+};
+
+/**
+ * Allocate a new snapshot
+ * @param capacity initial buffer size in bytes. The buffer grows as
+ * needed, so this is only a hint.
+ *
+ * @return a new snapshot or NULL on error
+ */
+struct snapshot* create_snapshot(size_t capacity);
+
+/**
+ * Destroy a snapshot created using create_snapshot()
+ * @param snapshot snapshot to destroy
+ */
+void destroy_snapshot(struct snapshot* snapshot);
+
+/**
+ * Start writing a snapshot, discarding its previous content
+ * @param snapshot snapshot to write
+ * @param version version of the state layout, stored in the snapshot
+ * header and returned by rewind_snapshot()
+ */
+void begin_snapshot(struct snapshot* snapshot, int version);
+
+/**
+ * Finish writing a snapshot started using begin_snapshot()
+ * @param snapshot snapshot to finish
+ *
+ * @return snapshot size in bytes or -1 if a write failed
+ */
+int end_snapshot(struct snapshot* snapshot);
+
+/**
+ * Start reading a snapshot from its beginning
+ * @param snapshot snapshot to read
+ *
+ * @return the state layout version passed to begin_snapshot() or -1 if
+ * the snapshot data is invalid
+ */
+int rewind_snapshot(struct snapshot* snapshot);
+
+/**
+ * Replace the content of a snapshot with a copy of data, and start
+ * reading it
+ * @param snapshot snapshot to fill
+ * @param data snapshot bytes, such as the data of a \ref snapshot
+ * written elsewhere
+ * @param size number of bytes in data
+ *
+ * @return the state layout version or -1 if data is not a valid snapshot
+ */
+int set_snapshot_data(struct snapshot* snapshot,
+                      const void* data,
+                      size_t size);
+
+/**
+ * Save a snapshot to a file, replacing it atomically
+ * @param snapshot finished snapshot to save
+ * @param file_spec file specifier to use for writing
+ *
+ * @return number of bytes written or -1 on error
+ */
+int save_snapshot(const struct snapshot* snapshot, struct file_spec file_spec);
+
+/**
+ * Load a snapshot saved using save_snapshot(), and start reading it
+ * @param snapshot snapshot to fill
+ * @param file_spec file specifier to use for reading
+ *
+ * @return the state layout version or -1 on error
+ */
+int load_snapshot(struct snapshot* snapshot, struct file_spec file_spec);
+
+/**
+ * Encode the difference between two snapshots
+ * @param delta snapshot to write the delta to
+ * @param base finished snapshot to compare against
+ * @param current finished snapshot to encode
+ *
+ * The delta holds the ranges of current that differ from base, so it
+ * is a few bytes long when little changed between the two. Rebuild
+ * current using apply_snapshot_delta() and the same base.
+ *
+ * @return delta size in bytes or -1 on error
+ */
+int make_snapshot_delta(struct snapshot* delta,
+                        const struct snapshot* base,
+                        const struct snapshot* current);
+
+/**
+ * Rebuild a snapshot from its base and a delta made using
+ * make_snapshot_delta(), and start reading it
+ * @param snapshot snapshot to rebuild, other than base
+ * @param base the snapshot the delta was made against
+ * @param delta delta to apply
+ *
+ * @return the state layout version or -1 if delta is invalid or was not
+ * made against base
+ */
+int apply_snapshot_delta(struct snapshot* snapshot,
+                         const struct snapshot* base,
+                         const struct snapshot* delta);
+
+/**
+ * Write an unsigned 8 bit value
+ * @param snapshot snapshot to write
+ * @param value value to write
+ */
+void write_u8(struct snapshot* snapshot, uint8_t value);
+
+/**
+ * Write an unsigned 16 bit value
+ * @param snapshot snapshot to write
+ * @param value value to write
+ */
+void write_u16(struct snapshot* snapshot, uint16_t value);
+
+/**
+ * Write an unsigned 32 bit value
+ * @param snapshot snapshot to write
+ * @param value value to write
+ */
+void write_u32(struct snapshot* snapshot, uint32_t value);
+
+/**
+ * Write an unsigned 64 bit value
+ * @param snapshot snapshot to write
+ * @param value value to write
+ */
+void write_u64(struct snapshot* snapshot, uint64_t value);
+
+/**
+ * Write a signed 32 bit value
+ * @param snapshot snapshot to write
+ * @param value value to write
+ */
+void write_i32(struct snapshot* snapshot, int32_t value);
+
+/**
+ * Write a float value
+ * @param snapshot snapshot to write
+ * @param value value to write
+ */
+void write_float(struct snapshot* snapshot, float value);
+
+/**
+ * Write a double value
+ * @param snapshot snapshot to write
+ * @param value value to write
+ */
+void write_double(struct snapshot* snapshot, double value);
+
+/**
+ * Write an unsigned value using 1 to 5 bytes, fewer for smaller values
+ * @param snapshot snapshot to write
+ * @param value value to write
+ */
+void write_varint(struct snapshot* snapshot, uint32_t value);
+
+/**
+ * Write raw bytes, such as an array of bytes or tile indices
+ * @param snapshot snapshot to write
+ * @param data bytes to write
+ * @param size number of bytes to write
+ */
+void write_bytes(struct snapshot* snapshot, const void* data, size_t size);
+
+/**
+ * Write a NUL terminated string
+ * @param snapshot snapshot to write
+ * @param str string to write
+ */
+void write_string(struct snapshot* snapshot, const char* str);
+
+/**
+ * Read an unsigned 8 bit value
+ * @param snapshot snapshot to read
+ *
+ * @return the value or 0 if the snapshot has no more data
+ */
+uint8_t read_u8(struct snapshot* snapshot);
+
+/**
+ * Read an unsigned 16 bit value
+ * @param snapshot snapshot to read
+ *
+ * @return the value or 0 if the snapshot has no more data
+ */
+uint16_t read_u16(struct snapshot* snapshot);
+
+/**
+ * Read an unsigned 32 bit value
+ * @param snapshot snapshot to read
+ *
+ * @return the value or 0 if the snapshot has no more data
+ */
+uint32_t read_u32(struct snapshot* snapshot);
+
+/**
+ * Read an unsigned 64 bit value
+ * @param snapshot snapshot to read
+ *
+ * @return the value or 0 if the snapshot has no more data
+ */
+uint64_t read_u64(struct snapshot* snapshot);
+
+/**
+ * Read a signed 32 bit value
+ * @param snapshot snapshot to read
+ *
+ * @return the value or 0 if the snapshot has no more data
+ */
+int32_t read_i32(struct snapshot* snapshot);
+
+/**
+ * Read a float value
+ * @param snapshot snapshot to read
+ *
+ * @return the value or 0 if the snapshot has no more data
+ */
+float read_float(struct snapshot* snapshot);
+
+/**
+ * Read a double value
+ * @param snapshot snapshot to read
+ *
+ * @return the value or 0 if the snapshot has no more data
+ */
+double read_double(struct snapshot* snapshot);
+
+/**
+ * Read a value written using write_varint()
+ * @param snapshot snapshot to read
+ *
+ * @return the value or 0 if the snapshot has no more data
+ */
+uint32_t read_varint(struct snapshot* snapshot);
+
+/**
+ * Read raw bytes written using write_bytes()
+ * @param snapshot snapshot to read
+ * @param data buffer to fill
+ * @param size number of bytes to read
+ *
+ * @return 0 on success or -1 if the snapshot has not enough data, in
+ * which case data is zeroed
+ */
+int read_bytes(struct snapshot* snapshot, void* data, size_t size);
+
+/**
+ * Read a string written using write_string()
+ * @param snapshot snapshot to read
+ * @param str buffer to fill, always NUL terminated
+ * @param size size of the str buffer
+ *
+ * @return 0 on success or -1 if the snapshot has no more data or the
+ * string does not fit str, in which case str is truncated
+ */
+int read_string(struct snapshot* snapshot, char* str, size_t size);
+
+#include "end_prefix.h"
+#endif /* end of include guard: SNAPSHOT_H_T5JW2NXC */
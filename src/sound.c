@@ -22,17 +22,20 @@
 #include "sound.h"
 #include <stdlib.h>
 
+#include "internals.h"
+#include "pack.h"
 #include "begin_prefix.h"
 struct sound* create_sound(const char* filepath)
 {
-    struct sound* sound = (struct sound*)malloc(sizeof(struct sound));
+    struct sound* sound = (struct sound*)MALLOC(
+    sizeof(struct sound), MEMORY_SOUNDS);
     if (sound != NULL) {
         if (load_sound(sound, filepath) == -1) goto error;
         sound->channel = -1;
     }
     return sound;
 error:
-    free(sound);
+    FREE(sound);
     return NULL;
 }
 
@@ -40,16 +43,18 @@ void destroy_sound(struct sound* sound)
 {
     if (sound != NULL) {
         cleanup_sound(sound);
-        free(sound);
+        FREE(sound);
     }
 }
 
 int load_sound(struct sound* sound, const char* pathname)
 {
-    if ((sound->sound = Mix_LoadWAV(pathname)) != NULL)
+    if ((sound->sound = Mix_LoadWAV_RW(open_asset(pathname), 1)) != NULL) {
+        TRACK_ASSET(sound->sound, MEMORY_AUDIO, pathname, sound->sound->alen);
         return 0;
-    else
+    } else {
         return -1;
+    }
 }
 
 int play_sound(struct sound* sound, int loops)
@@ -70,6 +75,8 @@ void stop_sound(struct sound* sound)
 
 void cleanup_sound(struct sound* sound)
 {
+    if (sound->sound != NULL)
+        UNTRACK_ASSET(sound->sound, MEMORY_AUDIO, sound->sound->alen);
     Mix_FreeChunk(sound->sound);
 }
 
@@ -21,6 +21,7 @@
  */
 #include "sprite.h"
 #include "utils.h"
+#include "internals.h"
 #include "begin_prefix.h"
 
 int prepare_sprite(struct sprite* sprite,
@@ -39,8 +40,27 @@ int prepare_sprite(struct sprite* sprite,
     sprite->image = image;
     sprite->frame_width = frame_width;
     sprite->frame_height = frame_height;
+    sprite->columns = image->width / frame_width;
+    sprite->sheet = NULL;
     sprite->active_animation = NULL;
     sprite->next_animation = NULL;
+    sprite->current_frame = 0;
+    sprite->elapsed_frame = 0;
+    sprite->frame_step = 1;
+    return 0;
+}
+
+int prepare_sheet_sprite(struct sprite* sprite, struct sprite_sheet* sheet)
+{
+    if (sheet == NULL || sheet->n_frames == 0) {
+        ERROR("Sprite initialization failed, sprite sheet is empty");
+        return -1;
+    }
+    if (prepare_sprite(sprite, sheet->image, sheet->frames[0].width,
+                       sheet->frames[0].height) == -1) {
+        return -1;
+    }
+    sprite->sheet = sheet;
     return 0;
 }
 
@@ -49,35 +69,82 @@ void cleanup_sprite(struct sprite* sprite)
     sprite->active_animation = NULL;
 }
 
+static void sprite_frame_rect(struct sprite* sprite,
+                              int frame,
+                              struct rectangle* r)
+{
+    r->w = sprite->frame_width;
+    r->h = sprite->frame_height;
+    r->x = (frame % sprite->columns) * sprite->frame_width;
+    r->y = (frame / sprite->columns) * sprite->frame_height;
+}
+
 void draw_sprite_frame(struct sprite* sprite, int x, int y, int frame)
 {
     struct rectangle r;
-    r.w = sprite->frame_width;
-    r.h = sprite->frame_height;
-    int cols = sprite->image->width / sprite->frame_width;
+    if (sprite->sheet != NULL) {
+        draw_sheet_frame(sprite->sheet, frame, x, y);
+        return;
+    }
+    sprite_frame_rect(sprite, frame, &r);
+    draw_image(sprite->image, x, y, &r, 0.0);
+}
 
-    int col = frame % cols;
-    int row = frame / cols;
+void draw_sprite_frame_ex(struct sprite* sprite,
+                          int x,
+                          int y,
+                          int frame,
+                          const struct draw_params* params)
+{
+    struct rectangle r;
+    if (sprite->sheet != NULL) {
+        draw_sheet_frame_ex(sprite->sheet, frame, x, y, params);
+        return;
+    }
+    sprite_frame_rect(sprite, frame, &r);
+    draw_image_ex(sprite->image, x, y, &r, params);
+}
 
-    r.x = col * sprite->frame_width;
-    r.y = row * sprite->frame_height;
-    draw_image(sprite->image, x, y, &r, 0.0);
+static int active_frame(struct sprite* sprite)
+{
+    return sprite->active_animation == NULL ? 0
+        : sprite->active_animation->frames[sprite->current_frame].frame;
 }
 
 int draw_sprite(struct sprite* sprite, int x, int y)
 {
-    int frame;
-    frame = sprite->active_animation == NULL ? 0
-        : sprite->active_animation->frames[sprite->current_frame].frame;
+    int frame = active_frame(sprite);
     draw_sprite_frame(sprite, x, y, frame);
     return frame;
 }
 
+int draw_sprite_ex(struct sprite* sprite,
+                   int x,
+                   int y,
+                   const struct draw_params* params)
+{
+    int frame = active_frame(sprite);
+    draw_sprite_frame_ex(sprite, x, y, frame, params);
+    return frame;
+}
+
 struct sprite* create_sprite(struct image* image, int w, int h)
 {
-    struct sprite* sprite = (struct sprite*)malloc(sizeof(struct sprite));
+    struct sprite* sprite = (struct sprite*)MALLOC(
+    sizeof(struct sprite), MEMORY_SPRITES);
     if (sprite != NULL && prepare_sprite(sprite, image, w, h) == -1) {
-        free(sprite);
+        FREE(sprite);
+        return NULL;
+    }
+    return sprite;
+}
+
+struct sprite* create_sheet_sprite(struct sprite_sheet* sheet)
+{
+    struct sprite* sprite = (struct sprite*)MALLOC(
+    sizeof(struct sprite), MEMORY_SPRITES);
+    if (sprite != NULL && prepare_sheet_sprite(sprite, sheet) == -1) {
+        FREE(sprite);
         return NULL;
     }
     return sprite;
@@ -87,58 +154,24 @@ void destroy_sprite(struct sprite* sprite)
 {
     if (sprite != NULL) {
         cleanup_sprite(sprite);
-        free(sprite);
+        FREE(sprite);
     }
 }
 
-static void consume_elapsed_time(struct sprite* sprite,
-                                 void (*progression)(struct sprite*))
+static void consume_elapsed_time(struct sprite* sprite, bool finish)
 {
     struct animation* animation = sprite->active_animation;
     int cfd = animation->frames[sprite->current_frame].duration;
     while (sprite->elapsed_frame >= cfd && cfd > 0) {
+        int next = next_animation_frame(animation, sprite->current_frame,
+                                        &sprite->frame_step, finish);
         sprite->elapsed_frame -= cfd;
-        progression(sprite);
-        cfd = animation->frames[sprite->current_frame].duration;
-    }
-}
-
-static void progress_current_animation(struct sprite* sprite)
-{
-    struct animation* animation = sprite->active_animation;
-    switch (sprite->active_animation->mode) {
-        case LOOP_FRAMES:
-            sprite->current_frame = sprite->current_frame == animation->loop_to
-                                    ? animation->loop_from
-                                    : sprite->current_frame + 1;
-            break;
-        case FREEZE_LAST_FRAME:
-            sprite->current_frame =
-            (sprite->current_frame + 1 == animation->n_frames)
-            ? sprite->current_frame
-            : sprite->current_frame + 1;
-            break;
-        case PINGPONG_FRAMES:
-            break;
-        default:
-            sprite->current_frame = sprite->current_frame;
-    }
-}
-
-static void consume_current_animation(struct sprite* sprite)
-{
-    struct animation* animation = sprite->active_animation;
-    switch (sprite->active_animation->mode) {
-        case LOOP_FRAMES:
-            if (sprite->current_frame <= animation->loop_to)
-                sprite->current_frame = animation->loop_to + 1;
-            else
-                sprite->current_frame += 1;
-            break;
-        case FREEZE_LAST_FRAME:
-        case PINGPONG_FRAMES:
-        default:
+        if (next >= animation->n_frames) {
+            sprite->current_frame = animation->n_frames - 1;
             break;
+        }
+        sprite->current_frame = next;
+        cfd = animation->frames[sprite->current_frame].duration;
     }
 }
 
@@ -151,16 +184,17 @@ void* animate_sprite(struct sprite* sprite, uint32_t elapsed)
         if (sprite->elapsed_frame >=
             animation->frames[sprite->current_frame].duration) {
             if (sprite->next_animation == NULL) {
-                consume_elapsed_time(sprite, progress_current_animation);
+                consume_elapsed_time(sprite, false);
             } else {
                 if (sprite->current_frame + 1 < animation->n_frames) {
-                    consume_elapsed_time(sprite, consume_current_animation);
+                    consume_elapsed_time(sprite, true);
                 }
                 if (sprite->current_frame + 1 >= animation->n_frames) {
                     sprite->active_animation = sprite->next_animation;
                     sprite->next_animation = NULL;
                     sprite->current_frame = 0;
                     sprite->elapsed_frame = 0;
+                    sprite->frame_step = 1;
                 }
             }
             ret =
@@ -181,6 +215,7 @@ void play_animation(struct sprite* sprite, struct animation* animation)
             sprite->next_animation = NULL;
             sprite->current_frame = 0;
             sprite->elapsed_frame = 0;
+            sprite->frame_step = 1;
         }
     }
 }
@@ -191,5 +226,6 @@ void stop_animation(struct sprite* sprite)
     sprite->active_animation = NULL;
     sprite->current_frame = 0;
     sprite->elapsed_frame = 0;
+    sprite->frame_step = 1;
 }
 #include "end_prefix.h"
@@ -24,6 +24,7 @@
 
 #include "image.h"
 #include "animate.h"
+#include "sprite_sheet.h"
 
 #include "begin_prefix.h"
 /**
@@ -63,6 +64,11 @@ struct sprite {
     int frame_width;
     /** height of each frame of the sprite */
     int frame_height;
+    /** number of frame columns in the image */
+    int columns;
+    /** sprite sheet holding the frames or NULL for a fixed-size frames
+     * image */
+    struct sprite_sheet* sheet;
     /** the animation currently being played */
     struct animation* active_animation;
     /** the animation pending to be played in the next frame */
@@ -71,6 +77,9 @@ struct sprite {
     int current_frame;
     /** time the current frame is in display in milliseconds */
     int elapsed_frame;
+    /** playback direction, 1 or -1 when a PINGPONG_FRAMES animation
+     * plays in reverse */
+    int frame_step;
 };
 
 /**
@@ -83,6 +92,14 @@ struct sprite {
  */
 struct sprite* create_sprite(struct image* image, int w, int h);
 
+/**
+ * allocate and initialize a new sprite using the frames of a sprite sheet
+ * @param sheet \ref sprite_sheet holding the sprite frames
+ *
+ * @return valid sprite pointer or NULL on error
+ */
+struct sprite* create_sheet_sprite(struct sprite_sheet* sheet);
+
 /**
  * destroy an allocated sprite
  * @param sprite sprite created using create_sprite().
@@ -103,6 +120,16 @@ int prepare_sprite(struct sprite* sprite,
                    int frame_width,
                    int frame_height);
 
+/**
+ * Build a sprite from a sprite sheet.
+ * @param sprite sprite resource to generate
+ * @param sheet sprite sheet holding the frames. The sprite frame size is
+ * set to the size of the first untrimmed frame.
+ *
+ * @return -1 on error
+ */
+int prepare_sheet_sprite(struct sprite* sprite, struct sprite_sheet* sheet);
+
 /**
  * Free any internally allocated resources for the \ref sprite
  * @param sprite \ref sprite to cleanup
@@ -136,6 +163,36 @@ int draw_sprite(struct sprite* sprite, int x, int y);
  */
 void draw_sprite_frame(struct sprite* sprite, int x, int y, int frame);
 
+/**
+ * Draw the active frame of the sprite with flipping, scaling, rotation
+ * and color modulation.
+ * @param sprite sprite to use
+ * @param x x coordinates
+ * @param y y coordinates
+ * @param params \ref draw_params to apply
+ *
+ * @return rendered sprite frame index
+ */
+int draw_sprite_ex(struct sprite* sprite,
+                   int x,
+                   int y,
+                   const struct draw_params* params);
+
+/**
+ * Draw the specified frame of the sprite with flipping, scaling, rotation
+ * and color modulation.
+ * @param sprite sprite to use
+ * @param x x coordinates
+ * @param y y coordinates
+ * @param frame frame index to draw from the sprite sheet
+ * @param params \ref draw_params to apply
+ */
+void draw_sprite_frame_ex(struct sprite* sprite,
+                          int x,
+                          int y,
+                          int frame,
+                          const struct draw_params* params);
+
 /**
  * Update the sprite animation state
  * @param sprite sprite to animate
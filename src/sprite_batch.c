@@ -0,0 +1,285 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "sprite_batch.h"
+#include "utils.h"
+#include <stdlib.h>
+#include "internals.h"
+#include "begin_prefix.h"
+
+#define MIN_EVENTS_CAPACITY 16
+
+struct sprite_batch* create_sprite_batch(int capacity)
+{
+    struct sprite_batch* batch;
+    char* block;
+    int i;
+    size_t pointers = sizeof(void*) * 3 * capacity;
+    size_t ints = sizeof(int) * 8 * capacity;
+
+    if (capacity <= 0) {
+        ERROR("Sprite batch capacity must be positive");
+        return NULL;
+    }
+    batch = (struct sprite_batch*)MALLOC(
+    sizeof(struct sprite_batch), MEMORY_SPRITES);
+    if (batch == NULL) goto error;
+    /* all per-entry arrays share a single allocation */
+    block = (char*)CALLOC(1, pointers + ints, MEMORY_SPRITES);
+    if (block == NULL) goto free_batch;
+    batch->sprites = (struct sprite**)block;
+    batch->active = (struct animation**)(block + sizeof(void*) * capacity);
+    batch->pending = (struct animation**)(block + sizeof(void*) * 2 * capacity);
+    batch->current = (int*)(block + pointers);
+    batch->step = batch->current + capacity;
+    batch->elapsed = batch->step + capacity;
+    batch->duration = batch->elapsed + capacity;
+    batch->sheet_index = batch->duration + capacity;
+    batch->slots = batch->sheet_index + capacity;
+    batch->handles = batch->slots + capacity;
+    batch->free_handles = batch->handles + capacity;
+
+    batch->events_capacity = max(capacity, MIN_EVENTS_CAPACITY);
+    batch->events = (struct sprite_event*)MALLOC(sizeof(struct sprite_event) *
+                                                 batch->events_capacity,
+                                                 MEMORY_SPRITES);
+    if (batch->events == NULL) goto free_block;
+
+    batch->capacity = capacity;
+    batch->count = 0;
+    batch->n_events = 0;
+    /* hand out low handles first */
+    for (i = 0; i < capacity; i++) {
+        batch->slots[i] = -1;
+        batch->free_handles[i] = capacity - 1 - i;
+    }
+    batch->n_free = capacity;
+    return batch;
+
+free_block:
+    FREE(block);
+free_batch:
+    FREE(batch);
+error:
+    ERROR("Unable to allocate a sprite batch");
+    return NULL;
+}
+
+void destroy_sprite_batch(struct sprite_batch* batch)
+{
+    if (batch != NULL) {
+        FREE(batch->events);
+        FREE(batch->sprites);
+        FREE(batch);
+    }
+}
+
+static void push_event(struct sprite_batch* batch, int slot, void* userdata)
+{
+    if (batch->n_events == batch->events_capacity) {
+        int capacity = batch->events_capacity * 2;
+        struct sprite_event* events = (struct sprite_event*)REALLOC(
+        batch->events, sizeof(struct sprite_event) * capacity, MEMORY_SPRITES);
+        if (events == NULL) {
+            ERROR("Unable to grow the sprite batch events queue");
+            return;
+        }
+        batch->events = events;
+        batch->events_capacity = capacity;
+    }
+    batch->events[batch->n_events].handle = batch->handles[slot];
+    batch->events[batch->n_events].userdata = userdata;
+    batch->n_events++;
+}
+
+static void enter_frame(struct sprite_batch* batch,
+                        int slot,
+                        int index,
+                        bool emit)
+{
+    struct frame* f = &batch->active[slot]->frames[index];
+    batch->current[slot] = index;
+    batch->duration[slot] = f->duration;
+    batch->sheet_index[slot] = f->frame;
+    if (emit && f->userdata != NULL) push_event(batch, slot, f->userdata);
+}
+
+static void start_animation(struct sprite_batch* batch,
+                            int slot,
+                            struct animation* animation,
+                            bool emit)
+{
+    batch->active[slot] = animation;
+    batch->pending[slot] = NULL;
+    batch->step[slot] = 1;
+    batch->elapsed[slot] = 0;
+    if (animation != NULL && animation->n_frames > 0) {
+        enter_frame(batch, slot, 0, emit);
+    } else {
+        batch->active[slot] = NULL;
+        batch->current[slot] = 0;
+        batch->duration[slot] = 0;
+        batch->sheet_index[slot] = 0;
+    }
+}
+
+int add_to_sprite_batch(struct sprite_batch* batch, struct sprite* sprite)
+{
+    int handle;
+    int slot;
+    if (batch->n_free == 0) {
+        ERROR("Reached sprite batch capacity limit");
+        return -1;
+    }
+    handle = batch->free_handles[--batch->n_free];
+    slot = batch->count++;
+    batch->slots[handle] = slot;
+    batch->handles[slot] = handle;
+    batch->sprites[slot] = sprite;
+    start_animation(batch, slot, NULL, false);
+    return handle;
+}
+
+static void move_slot(struct sprite_batch* batch, int to, int from)
+{
+    batch->sprites[to] = batch->sprites[from];
+    batch->active[to] = batch->active[from];
+    batch->pending[to] = batch->pending[from];
+    batch->current[to] = batch->current[from];
+    batch->step[to] = batch->step[from];
+    batch->elapsed[to] = batch->elapsed[from];
+    batch->duration[to] = batch->duration[from];
+    batch->sheet_index[to] = batch->sheet_index[from];
+    batch->handles[to] = batch->handles[from];
+    batch->slots[batch->handles[to]] = to;
+}
+
+void remove_from_sprite_batch(struct sprite_batch* batch, int handle)
+{
+    int slot;
+    if (handle < 0 || handle >= batch->capacity || batch->slots[handle] < 0) {
+        ERROR("Invalid sprite batch handle");
+        return;
+    }
+    slot = batch->slots[handle];
+    /* keep the entries packed by moving the last one into the hole */
+    batch->count--;
+    if (slot != batch->count) move_slot(batch, slot, batch->count);
+    batch->slots[handle] = -1;
+    batch->free_handles[batch->n_free++] = handle;
+}
+
+void play_batch_animation(struct sprite_batch* batch,
+                          int handle,
+                          struct animation* animation)
+{
+    int slot = batch->slots[handle];
+    if (batch->active[slot] != animation &&
+        batch->pending[slot] != animation) {
+        if (batch->active[slot] != NULL) {
+            batch->pending[slot] = animation;
+        } else {
+            start_animation(batch, slot, animation, false);
+        }
+    }
+}
+
+void stop_batch_animation(struct sprite_batch* batch, int handle)
+{
+    start_animation(batch, batch->slots[handle], NULL, false);
+}
+
+/* Called only once the current frame duration has passed, so
+ * this is the only place the animation itself is touched.
+ */
+static void advance_slot(struct sprite_batch* batch, int slot)
+{
+    struct animation* animation = batch->active[slot];
+    int elapsed = batch->elapsed[slot];
+    int duration = batch->duration[slot];
+    while (elapsed >= duration) {
+        bool finish = batch->pending[slot] != NULL;
+        int current = batch->current[slot];
+        int next;
+        if (duration <= 0) {
+            /* hold the frame, as animate_sprite() does, unless it is
+             * the last one and another animation is waiting */
+            if (finish && current + 1 >= animation->n_frames) {
+                start_animation(batch, slot, batch->pending[slot], true);
+                return;
+            }
+            elapsed = 0;
+            break;
+        }
+        next = next_animation_frame(animation, current, &batch->step[slot],
+                                    finish);
+        elapsed -= duration;
+        if (next >= animation->n_frames) {
+            start_animation(batch, slot, batch->pending[slot], true);
+            return;
+        }
+        if (next == current) {
+            /* frozen on this frame until another animation is played */
+            elapsed %= duration;
+            break;
+        }
+        enter_frame(batch, slot, next, true);
+        duration = batch->duration[slot];
+    }
+    batch->elapsed[slot] = elapsed;
+}
+
+void animate_sprites(struct sprite_batch* batch, uint32_t elapsed_ms)
+{
+    int i;
+    batch->n_events = 0;
+    for (i = 0; i < batch->count; i++) {
+        if (batch->active[i] == NULL) continue;
+        batch->elapsed[i] += elapsed_ms;
+        if (batch->elapsed[i] >= batch->duration[i]) advance_slot(batch, i);
+    }
+}
+
+int get_batch_frame(struct sprite_batch* batch, int handle)
+{
+    return batch->sheet_index[batch->slots[handle]];
+}
+
+int draw_batch_sprite(struct sprite_batch* batch, int handle, int x, int y)
+{
+    int slot = batch->slots[handle];
+    int index = batch->sheet_index[slot];
+    draw_sprite_frame(batch->sprites[slot], x, y, index);
+    return index;
+}
+
+int draw_batch_sprite_ex(struct sprite_batch* batch,
+                         int handle,
+                         int x,
+                         int y,
+                         const struct draw_params* params)
+{
+    int slot = batch->slots[handle];
+    int index = batch->sheet_index[slot];
+    draw_sprite_frame_ex(batch->sprites[slot], x, y, index, params);
+    return index;
+}
+#include "end_prefix.h"
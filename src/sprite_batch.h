@@ -0,0 +1,196 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#ifndef SPRITE_BATCH_H_K2MWQ7RD
+#define SPRITE_BATCH_H_K2MWQ7RD
+
+#include <stdint.h>
+#include "sprite.h"
+
+#include "begin_prefix.h"
+/**
+ * A frame event emitted by animate_sprites() when a batch entry
+ * enters a frame that has user data associated with it.
+ */
+struct sprite_event {
+    /** handle of the batch entry that played the frame */
+    int handle;
+    /** the frame user data */
+    void* userdata;
+};
+
+/**
+ * Sprite batches animate many sprites in a single pass.
+ * Where each \ref sprite keeps its own animation state, a batch keeps the
+ * playback state of all its entries in contiguous arrays, so advancing
+ * thousands of animated game entities stays cache friendly.
+ * Entries only reference a \ref sprite for its image and frame size, so any
+ * number of entries can share the same sprite:
+ *
+ *     struct sprite_batch* zombies = create_sprite_batch(1000);
+ *     int z = add_to_sprite_batch(zombies, zombie_sprite);
+ *     play_batch_animation(zombies, z, walk);
+ *
+ * Then, once per frame, animate and draw the entries:
+ *
+ *     int i;
+ *     animate_sprites(zombies, elapsed_ms);
+ *     for (i = 0; i < zombies->n_events; i++) {
+ *         // zombies->events[i].handle entered a frame
+ *         // with zombies->events[i].userdata
+ *     }
+ *     draw_batch_sprite(zombies, z, x, y);
+ *
+ * Entry handles stay valid until the entry is removed using
+ * remove_from_sprite_batch().
+ */
+struct sprite_batch {
+    /** maximum number of entries */
+    int capacity;
+    /** number of entries currently in the batch */
+    int count;
+    /* Per-entry state, densely packed by slot. Slots [0, count) are
+     * in use. */
+    struct sprite** sprites;
+    struct animation** active;
+    struct animation** pending;
+    int* current;
+    int* step;
+    int* elapsed;
+    /* duration and sprite sheet index of the current frame, cached so
+     * the update pass only touches the animation on frame changes */
+    int* duration;
+    int* sheet_index;
+    /* handle to slot mapping and its inverse */
+    int* slots;
+    int* handles;
+    /* unused handles stack */
+    int* free_handles;
+    int n_free;
+    /** frame events emitted by the last animate_sprites() call */
+    struct sprite_event* events;
+    /** number of events in \ref events */
+    int n_events;
+    /* allocated size of the events queue */
+    int events_capacity;
+};
+
+/**
+ * Allocate a new sprite batch
+ * @param capacity maximum number of entries the batch can hold
+ *
+ * @return a new sprite batch or NULL on error
+ */
+struct sprite_batch* create_sprite_batch(int capacity);
+
+/**
+ * Destroy a sprite batch created using create_sprite_batch()
+ * @param batch batch to destroy
+ *
+ * The sprites referenced by the batch entries are not destroyed.
+ */
+void destroy_sprite_batch(struct sprite_batch* batch);
+
+/**
+ * Add an entry to a sprite batch
+ * @param batch batch to add the entry to
+ * @param sprite sprite providing the image and frame size of the entry
+ *
+ * @return the new entry handle or -1 if the batch is full
+ */
+int add_to_sprite_batch(struct sprite_batch* batch, struct sprite* sprite);
+
+/**
+ * Remove an entry from a sprite batch
+ * @param batch batch holding the entry
+ * @param handle entry handle returned by add_to_sprite_batch()
+ */
+void remove_from_sprite_batch(struct sprite_batch* batch, int handle);
+
+/**
+ * Play an animation on a batch entry.
+ * @param batch batch holding the entry
+ * @param handle entry handle
+ * @param animation \ref animation to play
+ *
+ * Just like play_animation(), a new animation will wait for the
+ * currently playing one to complete.
+ */
+void play_batch_animation(struct sprite_batch* batch,
+                          int handle,
+                          struct animation* animation);
+
+/**
+ * Stop any playing or pending animation on a batch entry.
+ * @param batch batch holding the entry
+ * @param handle entry handle
+ */
+void stop_batch_animation(struct sprite_batch* batch, int handle);
+
+/**
+ * Advance the animation of all batch entries.
+ * @param batch batch to animate
+ * @param elapsed_ms time since last rendered frame (usually elapsed_ms)
+ *
+ * Events from the previous call are discarded. Every frame with
+ * user data entered during this call is queued in batch->events.
+ */
+void animate_sprites(struct sprite_batch* batch, uint32_t elapsed_ms);
+
+/**
+ * Get the sprite sheet frame a batch entry is currently showing.
+ * @param batch batch holding the entry
+ * @param handle entry handle
+ *
+ * @return frame index in the sprite image
+ */
+int get_batch_frame(struct sprite_batch* batch, int handle);
+
+/**
+ * Draw the current frame of a batch entry.
+ * @param batch batch holding the entry
+ * @param handle entry handle
+ * @param x x coordinates
+ * @param y y coordinates
+ *
+ * @return rendered sprite frame index
+ */
+int draw_batch_sprite(struct sprite_batch* batch, int handle, int x, int y);
+
+/**
+ * Draw the current frame of a batch entry with flipping, scaling,
+ * rotation and color modulation.
+ * @param batch batch holding the entry
+ * @param handle entry handle
+ * @param x x coordinates
+ * @param y y coordinates
+ * @param params \ref draw_params to apply
+ *
+ * @return rendered sprite frame index
+ */
+int draw_batch_sprite_ex(struct sprite_batch* batch,
+                         int handle,
+                         int x,
+                         int y,
+                         const struct draw_params* params);
+
+#include "end_prefix.h"
+#endif /* end of include guard: SPRITE_BATCH_H_K2MWQ7RD */
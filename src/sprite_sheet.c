@@ -0,0 +1,371 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "sprite_sheet.h"
+#include "internals.h"
+#include "types.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include "SDL.h"
+
+#define MAX_PATH_LEN 1024
+
+#include "begin_prefix.h"
+/* -----------------------------------------------
+ * A minimal JSON tokenizer, in the spirit of jsmn:
+ * it splits the text into a flat, pre-ordered array
+ * of tokens without allocating anything per value.
+ * Object sizes count both keys and values.
+ * -----------------------------------------------
+ */
+enum json_type { JSON_OBJECT, JSON_ARRAY, JSON_STRING, JSON_PRIMITIVE };
+
+struct json_token {
+    enum json_type type;
+    int start;
+    int end;
+    int size;
+    int parent;
+};
+
+static int add_token(struct json_token* tokens,
+                     int n,
+                     int parent,
+                     enum json_type type,
+                     int start,
+                     int end)
+{
+    if (tokens != NULL) {
+        tokens[n].type = type;
+        tokens[n].start = start;
+        tokens[n].end = end;
+        tokens[n].size = 0;
+        tokens[n].parent = parent;
+        if (parent != -1) tokens[parent].size++;
+    }
+    return n + 1;
+}
+
+/* Tokenize js into tokens, or only count the tokens when
+ * tokens is NULL. Returns the number of tokens or -1 on
+ * malformed input.
+ */
+static int parse_json(const char* js, int len, struct json_token* tokens)
+{
+    int pos;
+    int n = 0;
+    int parent = -1;
+    int depth = 0;
+    for (pos = 0; pos < len; pos++) {
+        int start;
+        switch (js[pos]) {
+            case '{':
+            case '[':
+                n = add_token(tokens, n, parent,
+                              js[pos] == '{' ? JSON_OBJECT : JSON_ARRAY, pos,
+                              -1);
+                parent = n - 1;
+                depth++;
+                break;
+            case '}':
+            case ']':
+                if (depth-- == 0) return -1;
+                if (tokens != NULL) {
+                    tokens[parent].end = pos + 1;
+                    parent = tokens[parent].parent;
+                }
+                break;
+            case '"':
+                start = pos + 1;
+                for (pos = start; pos < len && js[pos] != '"'; pos++) {
+                    if (js[pos] == '\\') pos++;
+                }
+                if (pos >= len) return -1;
+                n = add_token(tokens, n, parent, JSON_STRING, start, pos);
+                break;
+            case ' ':
+            case '\t':
+            case '\r':
+            case '\n':
+            case ':':
+            case ',':
+                break;
+            default:
+                start = pos;
+                while (pos < len && strchr(",]} \t\r\n", js[pos]) == NULL) {
+                    pos++;
+                }
+                n = add_token(tokens, n, parent, JSON_PRIMITIVE, start, pos);
+                pos--;
+        }
+    }
+    return depth == 0 ? n : -1;
+}
+
+/* index of the token following t[i] and all its children */
+static int skip_json(const struct json_token* t, int n, int i)
+{
+    int j = i + 1;
+    while (j < n && t[j].start < t[i].end) j++;
+    return j;
+}
+
+static bool json_equals(const char* js, const struct json_token* t,
+                        const char* s)
+{
+    int len = t->end - t->start;
+    return t->type == JSON_STRING && (int)strlen(s) == len &&
+           strncmp(js + t->start, s, len) == 0;
+}
+
+/* index of the value for key in the object t[i] or -1 */
+static int find_json_key(const char* js,
+                         const struct json_token* t,
+                         int n,
+                         int i,
+                         const char* key)
+{
+    int k;
+    if (i < 0 || t[i].type != JSON_OBJECT) return -1;
+    for (k = i + 1; k + 1 < n && t[k].start < t[i].end;
+         k = skip_json(t, n, k + 1)) {
+        if (json_equals(js, &t[k], key)) return k + 1;
+    }
+    return -1;
+}
+
+static float json_number(const char* js,
+                         const struct json_token* t,
+                         int n,
+                         int object,
+                         const char* key,
+                         float fallback)
+{
+    int i = find_json_key(js, t, n, object, key);
+    if (i == -1 || t[i].type != JSON_PRIMITIVE) return fallback;
+    return (float)strtod(js + t[i].start, NULL);
+}
+
+/* -----------------------------------------------
+ * Sprite sheets
+ * -----------------------------------------------
+ */
+static int read_frame(struct sprite_sheet* sheet,
+                      int index,
+                      const char* js,
+                      const struct json_token* t,
+                      int n,
+                      int object)
+{
+    struct sheet_frame* f = &sheet->frames[index];
+    int clip = find_json_key(js, t, n, object, "frame");
+    int trim = find_json_key(js, t, n, object, "spriteSourceSize");
+    int source = find_json_key(js, t, n, object, "sourceSize");
+    int pivot = find_json_key(js, t, n, object, "pivot");
+    int rotated = find_json_key(js, t, n, object, "rotated");
+
+    if (clip == -1) {
+        ERROR("Sprite sheet frame has no frame rectangle");
+        return -1;
+    }
+    if (rotated != -1 && strncmp(js + t[rotated].start, "true", 4) == 0) {
+        ERROR("Rotated sprite sheet frames are not supported");
+        return -1;
+    }
+    f->clip.x = json_number(js, t, n, clip, "x", 0);
+    f->clip.y = json_number(js, t, n, clip, "y", 0);
+    f->clip.w = json_number(js, t, n, clip, "w", 0);
+    f->clip.h = json_number(js, t, n, clip, "h", 0);
+    f->offset_x = json_number(js, t, n, trim, "x", 0);
+    f->offset_y = json_number(js, t, n, trim, "y", 0);
+    f->width = json_number(js, t, n, source, "w", f->clip.w);
+    f->height = json_number(js, t, n, source, "h", f->clip.h);
+    f->pivot_x = json_number(js, t, n, pivot, "x", 0.5f) * f->width;
+    f->pivot_y = json_number(js, t, n, pivot, "y", 0.5f) * f->height;
+    f->u1 = (float)f->clip.x / sheet->image->width;
+    f->v1 = (float)f->clip.y / sheet->image->height;
+    f->u2 = (float)(f->clip.x + f->clip.w) / sheet->image->width;
+    f->v2 = (float)(f->clip.y + f->clip.h) / sheet->image->height;
+    f->duration = json_number(js, t, n, object, "duration", 0);
+    return 0;
+}
+
+static int read_sheet(struct sprite_sheet* sheet,
+                      const char* filepath,
+                      const char* js,
+                      const struct json_token* t,
+                      int n)
+{
+    char image_path[MAX_PATH_LEN + 1] = "";
+    const char* slash;
+    int dir_len = 0;
+    int image_len;
+    size_t names_len = 0;
+    char* names_buffer;
+    int frames = find_json_key(js, t, n, 0, "frames");
+    int meta = find_json_key(js, t, n, 0, "meta");
+    int image = find_json_key(js, t, n, meta, "image");
+    int i, k, index;
+
+    if (frames == -1 || image == -1) {
+        ERROR("Sprite sheet descriptor has no frames or meta.image");
+        return -1;
+    }
+
+    /* the image path is relative to the descriptor */
+    slash = strrchr(filepath, '/');
+    if (slash != NULL) dir_len = (int)(slash - filepath) + 1;
+    image_len = t[image].end - t[image].start;
+    if (dir_len + image_len > MAX_PATH_LEN) {
+        ERROR("Sprite sheet image path is too long");
+        return -1;
+    }
+    memcpy(image_path, filepath, dir_len);
+    memcpy(image_path + dir_len, js + t[image].start, image_len);
+    sheet->image = create_image(image_path);
+    if (sheet->image == NULL) return -1;
+
+    /* the hash layout maps names to frames, the array
+     * layout keeps the name in a filename field */
+    sheet->n_frames = t[frames].type == JSON_OBJECT ? t[frames].size / 2
+                                                    : t[frames].size;
+    for (i = frames + 1; i < n && t[i].start < t[frames].end;
+         i = skip_json(t, n, i)) {
+        k = t[frames].type == JSON_OBJECT ? i
+            : find_json_key(js, t, n, i, "filename");
+        if (k != -1) names_len += t[k].end - t[k].start + 1;
+        if (t[frames].type == JSON_OBJECT) i++;
+    }
+    sheet->frames = (struct sheet_frame*)CALLOC(
+    sheet->n_frames, sizeof(struct sheet_frame), MEMORY_SPRITES);
+    sheet->names = (char**)CALLOC(
+    sheet->n_frames + 1, sizeof(char*), MEMORY_SPRITES);
+    names_buffer = (char*)CALLOC(names_len + 1, 1, MEMORY_SPRITES);
+    if (sheet->frames == NULL || sheet->names == NULL || names_buffer == NULL) {
+        FREE(names_buffer);
+        ERROR("Unable to allocate the sprite sheet frames");
+        return -1;
+    }
+    sheet->names[0] = names_buffer;
+
+    /* all names share a single buffer, held by names[0] */
+    for (index = 0, i = frames + 1; i < n && t[i].start < t[frames].end;
+         index++, i = skip_json(t, n, i)) {
+        int object = i;
+        k = -1;
+        if (t[frames].type == JSON_OBJECT) {
+            k = i;
+            object = i = i + 1;
+        } else {
+            k = find_json_key(js, t, n, i, "filename");
+        }
+        sheet->names[index] = names_buffer;
+        if (k != -1) {
+            int len = t[k].end - t[k].start;
+            memcpy(names_buffer, js + t[k].start, len);
+            names_buffer += len;
+        }
+        names_buffer++;
+        if (read_frame(sheet, index, js, t, n, object) == -1) return -1;
+    }
+    return 0;
+}
+
+struct sprite_sheet* create_sprite_sheet(const char* filepath)
+{
+    struct sprite_sheet* sheet = NULL;
+    struct json_token* tokens = NULL;
+    char* js;
+    size_t len = 0;
+    int n;
+
+    js = read_text_asset(filepath, &len, MEMORY_SPRITES);
+    if (js == NULL) {
+        ERROR("Unable to read the sprite sheet descriptor");
+        goto exit;
+    }
+    n = parse_json(js, (int)len, NULL);
+    if (n <= 0) goto invalid;
+    tokens = (struct json_token*)MALLOC(
+    sizeof(struct json_token) * n, MEMORY_SPRITES);
+    if (tokens == NULL) goto free_js;
+    if (parse_json(js, (int)len, tokens) != n || tokens[0].type != JSON_OBJECT)
+        goto invalid;
+
+    sheet = (struct sprite_sheet*)CALLOC(
+    1, sizeof(struct sprite_sheet), MEMORY_SPRITES);
+    if (sheet != NULL && read_sheet(sheet, filepath, js, tokens, n) == -1) {
+        destroy_sprite_sheet(sheet);
+        sheet = NULL;
+    }
+    goto free_tokens;
+
+invalid:
+    ERROR("Sprite sheet descriptor is not valid JSON");
+free_tokens:
+    FREE(tokens);
+free_js:
+    FREE(js);
+exit:
+    return sheet;
+}
+
+void destroy_sprite_sheet(struct sprite_sheet* sheet)
+{
+    if (sheet != NULL) {
+        if (sheet->image != NULL) destroy_image(sheet->image);
+        if (sheet->names != NULL) FREE(sheet->names[0]);
+        FREE(sheet->names);
+        FREE(sheet->frames);
+        FREE(sheet);
+    }
+}
+
+int find_sheet_frame(const struct sprite_sheet* sheet, const char* name)
+{
+    int i;
+    for (i = 0; i < sheet->n_frames; i++) {
+        if (strcmp(sheet->names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+void draw_sheet_frame(const struct sprite_sheet* sheet,
+                      int index,
+                      int x,
+                      int y)
+{
+    const struct sheet_frame* f = &sheet->frames[index];
+    draw_image(sheet->image, x + f->offset_x, y + f->offset_y, &f->clip, 0.0);
+}
+
+void draw_sheet_frame_ex(const struct sprite_sheet* sheet,
+                         int index,
+                         int x,
+                         int y,
+                         const struct draw_params* params)
+{
+    const struct sheet_frame* f = &sheet->frames[index];
+    render_image_ex(sheet->image, &f->clip, x, y, f->offset_x, f->offset_y,
+                    f->pivot_x, f->pivot_y, params);
+}
+#include "end_prefix.h"
@@ -0,0 +1,137 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#ifndef SPRITE_SHEET_H_R4XN8TQB
+#define SPRITE_SHEET_H_R4XN8TQB
+
+#include "image.h"
+#include "geometry.h"
+
+#include "begin_prefix.h"
+/**
+ * A single frame in a \ref sprite_sheet.
+ * Packing tools trim the transparent border around each frame, so a
+ * sheet frame remembers both the packed area in the sheet image and
+ * where that area sits inside the original, untrimmed frame.
+ */
+struct sheet_frame {
+    /** frame area inside the sheet image */
+    struct rectangle clip;
+    /** x position of the trimmed area inside the untrimmed frame */
+    int offset_x;
+    /** y position of the trimmed area inside the untrimmed frame */
+    int offset_y;
+    /** untrimmed frame width */
+    int width;
+    /** untrimmed frame height */
+    int height;
+    /** pivot x position in pixels, relative to the untrimmed frame */
+    float pivot_x;
+    /** pivot y position in pixels, relative to the untrimmed frame */
+    float pivot_y;
+    /** normalized texture coordinates of the clip area */
+    float u1, v1, u2, v2;
+    /** frame duration in milliseconds or 0 if the descriptor has none */
+    int duration;
+};
+
+/**
+ * Sprite sheets hold frames of any size, packed into a single image
+ * by tools like Aseprite or TexturePacker. Export the sheet using the
+ * JSON format (both the hash and the array layouts will do) and load
+ * it using create_sprite_sheet():
+ *
+ *     struct sprite_sheet* sheet;
+ *     sheet = create_sprite_sheet("res/hero.json");
+ *
+ * The sheet image is read from the path found in the descriptor
+ * ``meta.image`` field, relative to the descriptor itself.
+ * Every frame rectangle, trim offset and pivot is computed once when
+ * the sheet loads, so drawing a frame is a table lookup:
+ *
+ *     draw_sheet_frame(sheet, find_sheet_frame(sheet, "idle.png"), x, y);
+ *
+ * To animate sheet frames, create a sprite using create_sheet_sprite()
+ * and use it like any other \ref sprite.
+ */
+struct sprite_sheet {
+    /** image holding the packed frames */
+    struct image* image;
+    /** number of frames in the sheet */
+    int n_frames;
+    /** frame table */
+    struct sheet_frame* frames;
+    /** frame names, as found in the descriptor */
+    char** names;
+};
+
+/**
+ * Create a sprite sheet from a JSON descriptor
+ * @param filepath path to the JSON file
+ *
+ * @return \ref sprite_sheet pointer or NULL on failure
+ */
+struct sprite_sheet* create_sprite_sheet(const char* filepath);
+
+/**
+ * Destroy a sprite sheet created using create_sprite_sheet()
+ * @param sheet sheet to destroy, including its image
+ */
+void destroy_sprite_sheet(struct sprite_sheet* sheet);
+
+/**
+ * Find a frame by its name
+ * @param sheet sheet to search
+ * @param name frame name as found in the descriptor
+ *
+ * @return frame index or -1 if not found
+ */
+int find_sheet_frame(const struct sprite_sheet* sheet, const char* name);
+
+/**
+ * Draw a sheet frame
+ * @param sheet sheet to use
+ * @param index frame index
+ * @param x x coordinates of the untrimmed frame top-left corner
+ * @param y y coordinates of the untrimmed frame top-left corner
+ */
+void draw_sheet_frame(const struct sprite_sheet* sheet,
+                      int index,
+                      int x,
+                      int y);
+
+/**
+ * Draw a sheet frame with flipping, scaling, rotation and color modulation
+ * @param sheet sheet to use
+ * @param index frame index
+ * @param x x coordinates of the untrimmed frame top-left corner
+ * @param y y coordinates of the untrimmed frame top-left corner
+ * @param params \ref draw_params to apply. The frame pivot from the
+ * sheet descriptor is used instead of the params pivot.
+ */
+void draw_sheet_frame_ex(const struct sprite_sheet* sheet,
+                         int index,
+                         int x,
+                         int y,
+                         const struct draw_params* params);
+
+#include "end_prefix.h"
+#endif /* end of include guard: SPRITE_SHEET_H_R4XN8TQB */
@@ -0,0 +1,170 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "tile_animation.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+
+#include "internals.h"
+#include "begin_prefix.h"
+
+#define MIN_ANIMATIONS_CAPACITY 8
+#define MIN_FRAMES_CAPACITY 32
+
+struct animated_tile {
+    int tile;
+    int first_frame;
+    int n_frames;
+    int total_duration;
+};
+
+struct tile_animator* create_tile_animator(int n_tiles)
+{
+    struct tile_animator* animator;
+    int i;
+
+    if (n_tiles <= 0) {
+        ERROR("Tile animator size must be positive");
+        return NULL;
+    }
+    animator = (struct tile_animator*)CALLOC(
+    1, sizeof(struct tile_animator), MEMORY_TILES);
+    if (animator == NULL) goto error;
+    animator->remap = (int*)MALLOC(sizeof(int) * n_tiles, MEMORY_TILES);
+    if (animator->remap == NULL) goto free_animator;
+    animator->animated = (bool*)CALLOC(n_tiles, sizeof(bool), MEMORY_TILES);
+    if (animator->animated == NULL) goto free_remap;
+    animator->stamps = (unsigned long*)CALLOC(n_tiles, sizeof(unsigned long),
+                                              MEMORY_TILES);
+    if (animator->stamps == NULL) goto free_animated;
+    for (i = 0; i < n_tiles; i++) animator->remap[i] = i;
+    animator->n_tiles = n_tiles;
+    return animator;
+
+free_animated:
+    FREE(animator->animated);
+free_remap:
+    FREE(animator->remap);
+free_animator:
+    FREE(animator);
+error:
+    ERROR("Unable to allocate tile animator");
+    return NULL;
+}
+
+void destroy_tile_animator(struct tile_animator* animator)
+{
+    if (animator == NULL) return;
+    FREE(animator->frames);
+    FREE(animator->animations);
+    FREE(animator->stamps);
+    FREE(animator->animated);
+    FREE(animator->remap);
+    FREE(animator);
+}
+
+int add_tile_animation(struct tile_animator* animator,
+                       int tile,
+                       const struct tile_frame* frames,
+                       int n_frames)
+{
+    struct animated_tile* animation;
+    int total = 0;
+    int i;
+
+    if (tile < 0 || tile >= animator->n_tiles || animator->animated[tile] ||
+        n_frames <= 0) {
+        ERROR("Invalid tile animation");
+        return -1;
+    }
+    for (i = 0; i < n_frames; i++) total += frames[i].duration;
+    if (total <= 0) {
+        ERROR("Tile animation has no duration");
+        return -1;
+    }
+
+    if (animator->n_animations == animator->animations_capacity) {
+        int capacity = animator->animations_capacity * 2;
+        struct animated_tile* animations;
+        if (capacity < MIN_ANIMATIONS_CAPACITY)
+            capacity = MIN_ANIMATIONS_CAPACITY;
+        animations = (struct animated_tile*)REALLOC(
+        animator->animations, sizeof(struct animated_tile) * capacity,
+        MEMORY_TILES);
+        if (animations == NULL) goto error;
+        animator->animations = animations;
+        animator->animations_capacity = capacity;
+    }
+    if (animator->n_frames + n_frames > animator->frames_capacity) {
+        int capacity = animator->frames_capacity * 2;
+        struct tile_frame* all_frames;
+        if (capacity < MIN_FRAMES_CAPACITY) capacity = MIN_FRAMES_CAPACITY;
+        if (capacity < animator->n_frames + n_frames)
+            capacity = animator->n_frames + n_frames;
+        all_frames = (struct tile_frame*)REALLOC(
+        animator->frames, sizeof(struct tile_frame) * capacity, MEMORY_TILES);
+        if (all_frames == NULL) goto error;
+        animator->frames = all_frames;
+        animator->frames_capacity = capacity;
+    }
+
+    animation = &animator->animations[animator->n_animations++];
+    animation->tile = tile;
+    animation->first_frame = animator->n_frames;
+    animation->n_frames = n_frames;
+    animation->total_duration = total;
+    memcpy(&animator->frames[animator->n_frames], frames,
+           sizeof(struct tile_frame) * n_frames);
+    animator->n_frames += n_frames;
+    animator->animated[tile] = true;
+    /* show the right frame right away */
+    update_tile_animator(animator, 0);
+    return 0;
+
+error:
+    ERROR("Unable to allocate tile animation");
+    return -1;
+}
+
+void update_tile_animator(struct tile_animator* animator, uint32_t elapsed_ms)
+{
+    int i, f;
+    animator->clock += elapsed_ms;
+    for (i = 0; i < animator->n_animations; i++) {
+        const struct animated_tile* animation = &animator->animations[i];
+        const struct tile_frame* frames =
+        &animator->frames[animation->first_frame];
+        int t = (int)(animator->clock % (uint32_t)animation->total_duration);
+        for (f = 0; t >= frames[f].duration; f++) t -= frames[f].duration;
+        if (animator->remap[animation->tile] != frames[f].tile) {
+            animator->remap[animation->tile] = frames[f].tile;
+            animator->stamps[animation->tile] = ++animator->changes;
+        }
+    }
+}
+
+int get_animated_tile(const struct tile_animator* animator, int tile)
+{
+    if (tile < 0 || tile >= animator->n_tiles) return tile;
+    return animator->remap[tile];
+}
+#include "end_prefix.h"
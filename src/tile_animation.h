@@ -0,0 +1,128 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#ifndef TILE_ANIMATION_H_M8BCK4PU
+#define TILE_ANIMATION_H_M8BCK4PU
+
+#include <stdint.h>
+#include "types.h"
+
+#include "begin_prefix.h"
+/**
+ * A single frame of an animated tile
+ */
+struct tile_frame {
+    /** tile to show */
+    int tile;
+    /** frame duration in milliseconds */
+    int duration;
+};
+
+/**
+ * Tile animators play animated tiles, such as water or torches, for a
+ * whole map at once.
+ * Every animated tile is defined once. A single clock then picks the
+ * current frame of every definition, and writes it to a remap table
+ * that tile renderers read when they draw a tile:
+ *
+ *     struct tile_frame water[] = { { 12, 200 }, { 13, 200 }, { 14, 200 } };
+ *     struct tile_animator* animator = create_tile_animator(256);
+ *     add_tile_animation(animator, 12, water, 3);
+ *     ground->animator = animator;
+ *
+ * Then, once per frame:
+ *
+ *     update_tile_animator(animator, elapsed_ms);
+ *
+ * Updating costs the same whether a tile shows up once or all over the
+ * map, and tile layers only render again the animated tiles whose
+ * frame changed.
+ */
+struct tile_animator {
+    /** number of tile ids the remap table covers */
+    int n_tiles;
+    /** tile to draw for every tile id */
+    int* remap;
+    /** set for tile ids that have an animation */
+    bool* animated;
+    /** time since the animator was created, in milliseconds */
+    uint32_t clock;
+    /** incremented whenever a remap table entry changes */
+    unsigned long changes;
+    /** value of changes when the remap entry of every tile id last
+     * changed, or 0 if it never did */
+    unsigned long* stamps;
+    /* animation definitions and their frames */
+    struct animated_tile* animations;
+    int n_animations;
+    int animations_capacity;
+    struct tile_frame* frames;
+    int n_frames;
+    int frames_capacity;
+};
+
+/**
+ * Create a tile animator
+ * @param n_tiles number of tile ids, e.g. the number of frames in the
+ * tileset
+ *
+ * @return a new \ref tile_animator or NULL on error
+ */
+struct tile_animator* create_tile_animator(int n_tiles);
+
+/**
+ * Destroy a tile animator
+ * @param animator tile animator to destroy
+ */
+void destroy_tile_animator(struct tile_animator* animator);
+
+/**
+ * Animate a tile
+ * @param animator tile animator to add the animation to
+ * @param tile tile id that shows the animation wherever it is placed
+ * @param frames animation frames, copied by the animator
+ * @param n_frames number of frames
+ *
+ * @return 0 on success or -1 on error
+ */
+int add_tile_animation(struct tile_animator* animator,
+                       int tile,
+                       const struct tile_frame* frames,
+                       int n_frames);
+
+/**
+ * Advance the clock and update the remap table
+ * @param animator tile animator to update
+ * @param elapsed_ms time since last rendered frame (usually elapsed_ms)
+ */
+void update_tile_animator(struct tile_animator* animator, uint32_t elapsed_ms);
+
+/**
+ * Get the tile to draw for a tile id
+ * @param animator tile animator to query
+ * @param tile tile id
+ *
+ * @return the current animation frame tile, or tile if it is not animated
+ */
+int get_animated_tile(const struct tile_animator* animator, int tile);
+
+#include "end_prefix.h"
+#endif /* end of include guard: TILE_ANIMATION_H_M8BCK4PU */
@@ -0,0 +1,328 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "tile_layer.h"
+#include "internals.h"
+#include "utils.h"
+#include <stdlib.h>
+#include "SDL.h"
+
+#include "begin_prefix.h"
+
+#define DEFAULT_MAX_CHUNKS 64
+
+struct tile_layer* create_tile_layer(struct sprite* tileset,
+                                     int cols,
+                                     int rows)
+{
+    struct tile_layer* layer;
+    int i;
+
+    if (cols <= 0 || rows <= 0) {
+        ERROR("Tile layer size must be positive");
+        return NULL;
+    }
+    layer = (struct tile_layer*)MALLOC(sizeof(struct tile_layer), MEMORY_TILES);
+    if (layer == NULL) goto error;
+    layer->tiles = (int*)MALLOC(sizeof(int) * cols * rows, MEMORY_TILES);
+    if (layer->tiles == NULL) goto free_layer;
+    for (i = 0; i < cols * rows; i++) layer->tiles[i] = -1;
+    layer->chunk_cols = (cols + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+    layer->chunk_rows = (rows + TILE_CHUNK_SIZE - 1) / TILE_CHUNK_SIZE;
+    layer->chunks = (struct tile_chunk*)CALLOC(
+    layer->chunk_cols * layer->chunk_rows, sizeof(struct tile_chunk),
+    MEMORY_TILES);
+    if (layer->chunks == NULL) goto free_tiles;
+    layer->tileset = tileset;
+    layer->cols = cols;
+    layer->rows = rows;
+    layer->max_chunks = DEFAULT_MAX_CHUNKS;
+    layer->n_baked = 0;
+    layer->blend = BLEND;
+    layer->animator = NULL;
+    layer->draws = 0;
+    return layer;
+
+free_tiles:
+    FREE(layer->tiles);
+free_layer:
+    FREE(layer);
+error:
+    ERROR("Unable to allocate tile layer");
+    return NULL;
+}
+
+void destroy_tile_layer(struct tile_layer* layer)
+{
+    int i;
+    if (layer == NULL) return;
+    for (i = 0; i < layer->chunk_cols * layer->chunk_rows; i++) {
+        if (layer->chunks[i].image != NULL)
+            destroy_image(layer->chunks[i].image);
+        FREE(layer->chunks[i].animated);
+    }
+    FREE(layer->chunks);
+    FREE(layer->tiles);
+    FREE(layer);
+}
+
+void set_tile(struct tile_layer* layer, int col, int row, int tile)
+{
+    int* t;
+    if (col < 0 || row < 0 || col >= layer->cols || row >= layer->rows)
+        return;
+    t = &layer->tiles[row * layer->cols + col];
+    if (*t == tile) return;
+    *t = tile;
+    layer->chunks[(row / TILE_CHUNK_SIZE) * layer->chunk_cols +
+                  col / TILE_CHUNK_SIZE].dirty = true;
+}
+
+int get_tile(const struct tile_layer* layer, int col, int row)
+{
+    if (col < 0 || row < 0 || col >= layer->cols || row >= layer->rows)
+        return -1;
+    return layer->tiles[row * layer->cols + col];
+}
+
+void invalidate_tile_layer(struct tile_layer* layer)
+{
+    int i;
+    for (i = 0; i < layer->chunk_cols * layer->chunk_rows; i++)
+        layer->chunks[i].dirty = true;
+}
+
+/* Find an image for a chunk to bake into. Below max_chunks a new one
+ * is created, otherwise the least recently drawn chunk that is not
+ * part of the current draw gives up its image. */
+static struct image* take_chunk_image(struct tile_layer* layer)
+{
+    struct tile_chunk* lru = NULL;
+    struct image* image;
+    int i;
+
+    if (layer->n_baked >= layer->max_chunks) {
+        for (i = 0; i < layer->chunk_cols * layer->chunk_rows; i++) {
+            struct tile_chunk* chunk = &layer->chunks[i];
+            if (chunk->image == NULL || chunk->last_used == layer->draws)
+                continue;
+            if (lru == NULL || chunk->last_used < lru->last_used) lru = chunk;
+        }
+        if (lru != NULL) {
+            image = lru->image;
+            lru->image = NULL;
+            return image;
+        }
+    }
+    image = create_target_image(TILE_CHUNK_SIZE * layer->tileset->frame_width,
+                                TILE_CHUNK_SIZE * layer->tileset->frame_height,
+                                color_from_RGBA(0, 0, 0, 0));
+    if (image != NULL) layer->n_baked++;
+    return image;
+}
+
+/* Renderer state saved while drawing tiles on a chunk image */
+struct chunk_drawing {
+    struct image* previous;
+    float offset_x;
+    float offset_y;
+    int blend_state;
+};
+
+static int begin_chunk_drawing(struct tile_layer* layer,
+                               struct tile_chunk* chunk,
+                               struct chunk_drawing* saved)
+{
+    saved->previous = screen->target;
+    saved->offset_x = screen->offset_x;
+    saved->offset_y = screen->offset_y;
+    saved->blend_state = layer->tileset->image->blend_state;
+    if (set_render_target(chunk->image) != 0) {
+        ERROR("Unable to draw on a tile chunk image");
+        return -1;
+    }
+    /* Tiles are copied as they are, so a tile drawn again replaces the
+     * old one, and must not pick up the camera shake offset. */
+    screen->offset_x = 0;
+    screen->offset_y = 0;
+    set_texture_blend_mode(layer->tileset->image, SDL_BLENDMODE_NONE);
+    return 0;
+}
+
+static void end_chunk_drawing(struct tile_layer* layer,
+                              const struct chunk_drawing* saved)
+{
+    if (saved->blend_state != -1)
+        set_texture_blend_mode(layer->tileset->image,
+                               (SDL_BlendMode)saved->blend_state);
+    screen->offset_x = saved->offset_x;
+    screen->offset_y = saved->offset_y;
+    set_render_target(saved->previous);
+}
+
+/* Add a tile to the animated tiles of a chunk */
+static int list_animated_tile(struct tile_chunk* chunk, int row, int col)
+{
+    if (chunk->animated == NULL) {
+        chunk->animated = (uint16_t*)MALLOC(
+        sizeof(uint16_t) * TILE_CHUNK_SIZE * TILE_CHUNK_SIZE, MEMORY_TILES);
+        if (chunk->animated == NULL) {
+            ERROR("Unable to allocate the animated tiles of a chunk");
+            return -1;
+        }
+    }
+    chunk->animated[chunk->n_animated++] =
+    (uint16_t)(row * TILE_CHUNK_SIZE + col);
+    return 0;
+}
+
+static int bake_chunk(struct tile_layer* layer, int chunk_col, int chunk_row)
+{
+    struct tile_chunk* chunk =
+    &layer->chunks[chunk_row * layer->chunk_cols + chunk_col];
+    struct sprite* tileset = layer->tileset;
+    const struct tile_animator* animator = layer->animator;
+    struct chunk_drawing saved;
+    bool listed = true;
+    int first_col = chunk_col * TILE_CHUNK_SIZE;
+    int first_row = chunk_row * TILE_CHUNK_SIZE;
+    int last_col = (int)min(first_col + TILE_CHUNK_SIZE, layer->cols);
+    int last_row = (int)min(first_row + TILE_CHUNK_SIZE, layer->rows);
+    int r, c;
+
+    if (chunk->image == NULL) chunk->image = take_chunk_image(layer);
+    if (chunk->image == NULL) {
+        ERROR("Unable to create a tile chunk image");
+        return -1;
+    }
+    if (begin_chunk_drawing(layer, chunk, &saved) == -1) return -1;
+    /* Transparent white leaves the area under empty tiles unchanged in
+     * every blend mode, including MULTIPLY. */
+    set_render_draw_color(color_from_RGBA(255, 255, 255, 0));
+    SDL_RenderClear(screen->impl);
+
+    chunk->n_animated = 0;
+    for (r = first_row; r < last_row; r++) {
+        for (c = first_col; c < last_col; c++) {
+            int tile = layer->tiles[r * layer->cols + c];
+            if (tile < 0) continue;
+            if (animator != NULL && tile < animator->n_tiles) {
+                if (animator->animated[tile] &&
+                    list_animated_tile(chunk, r - first_row, c - first_col))
+                    listed = false;
+                tile = animator->remap[tile];
+            }
+            draw_sprite_frame(tileset,
+                              (c - first_col) * tileset->frame_width,
+                              (r - first_row) * tileset->frame_height,
+                              tile);
+        }
+    }
+    end_chunk_drawing(layer, &saved);
+
+    /* a chunk that could not list its animated tiles bakes again */
+    chunk->dirty = !listed;
+    if (animator != NULL) chunk->changes = animator->changes;
+    return listed ? 0 : -1;
+}
+
+/* Draw again the animated tiles of a chunk whose frame changed since
+ * they were last drawn, leaving the rest of the chunk as baked */
+static int patch_chunk(struct tile_layer* layer, int chunk_col, int chunk_row)
+{
+    struct tile_chunk* chunk =
+    &layer->chunks[chunk_row * layer->chunk_cols + chunk_col];
+    struct sprite* tileset = layer->tileset;
+    const struct tile_animator* animator = layer->animator;
+    const int* tiles = &layer->tiles[chunk_row * TILE_CHUNK_SIZE * layer->cols +
+                                     chunk_col * TILE_CHUNK_SIZE];
+    struct chunk_drawing saved;
+    bool drawing = false;
+    int i;
+
+    for (i = 0; i < chunk->n_animated; i++) {
+        int r = chunk->animated[i] / TILE_CHUNK_SIZE;
+        int c = chunk->animated[i] % TILE_CHUNK_SIZE;
+        int tile = tiles[r * layer->cols + c];
+        if (animator->stamps[tile] <= chunk->changes) continue;
+        if (!drawing) {
+            if (begin_chunk_drawing(layer, chunk, &saved) == -1) return -1;
+            drawing = true;
+        }
+        draw_sprite_frame(tileset, c * tileset->frame_width,
+                          r * tileset->frame_height, animator->remap[tile]);
+    }
+    if (drawing) end_chunk_drawing(layer, &saved);
+    chunk->changes = animator->changes;
+    return 0;
+}
+
+int draw_tile_layer(struct tile_layer* layer,
+                    int x,
+                    int y,
+                    int width,
+                    int height)
+{
+    int chunk_w = TILE_CHUNK_SIZE * layer->tileset->frame_width;
+    int chunk_h = TILE_CHUNK_SIZE * layer->tileset->frame_height;
+    int first_col = x > 0 ? x / chunk_w : 0;
+    int first_row = y > 0 ? y / chunk_h : 0;
+    int last_col = (int)min((x + width - 1) / chunk_w, layer->chunk_cols - 1);
+    int last_row = (int)min((y + height - 1) / chunk_h, layer->chunk_rows - 1);
+    struct tile_chunk* chunk;
+    struct rectangle clip;
+    int ret = 0;
+    int r, c;
+
+    if (x + width <= 0 || y + height <= 0) return 0;
+    layer->draws++;
+    /* Mark every visible chunk first, so baking one never takes the
+     * image of another visible chunk. */
+    for (r = first_row; r <= last_row; r++)
+        for (c = first_col; c <= last_col; c++)
+            layer->chunks[r * layer->chunk_cols + c].last_used = layer->draws;
+
+    for (r = first_row; r <= last_row; r++) {
+        for (c = first_col; c <= last_col; c++) {
+            chunk = &layer->chunks[r * layer->chunk_cols + c];
+            if (chunk->image == NULL || chunk->dirty) {
+                if (bake_chunk(layer, c, r) == -1) {
+                    ret = -1;
+                    continue;
+                }
+            } else if (chunk->n_animated > 0 && layer->animator != NULL &&
+                       chunk->changes != layer->animator->changes) {
+                if (patch_chunk(layer, c, r) == -1) ret = -1;
+            }
+            clip.x = 0;
+            clip.y = 0;
+            clip.w = (int)min(chunk_w, (layer->cols - c * TILE_CHUNK_SIZE) *
+                                       layer->tileset->frame_width);
+            clip.h = (int)min(chunk_h, (layer->rows - r * TILE_CHUNK_SIZE) *
+                                       layer->tileset->frame_height);
+            set_blend_mode(chunk->image, layer->blend);
+            draw_image(chunk->image, c * chunk_w - x, r * chunk_h - y, &clip,
+                       0);
+        }
+    }
+    return ret;
+}
+#include "end_prefix.h"
@@ -0,0 +1,167 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#ifndef TILE_LAYER_H_J5VPR2XE
+#define TILE_LAYER_H_J5VPR2XE
+
+#include <stdint.h>
+#include "sprite.h"
+#include "image.h"
+#include "tile_animation.h"
+#include "types.h"
+
+#include "begin_prefix.h"
+/** Width and height of a tile layer chunk, in tiles */
+#define TILE_CHUNK_SIZE 16
+
+/**
+ * A square of TILE_CHUNK_SIZE by TILE_CHUNK_SIZE tiles, pre-rendered
+ * into a target image.
+ */
+struct tile_chunk {
+    /** the pre-rendered tiles, or NULL if the chunk is not baked */
+    struct image* image;
+    /** set when a tile in the chunk changed since it was baked */
+    bool dirty;
+    /** draw_tile_layer() call count when the chunk was last drawn */
+    unsigned long last_used;
+    /* position of every animated tile in the chunk, as row *
+     * TILE_CHUNK_SIZE + col, or NULL if the chunk never held any */
+    uint16_t* animated;
+    /** number of animated tiles in the chunk */
+    int n_animated;
+    /** tile animator change count when the chunk animated tiles were
+     * last drawn */
+    unsigned long changes;
+};
+
+/**
+ * Tile layers draw large static tile grids in a few draw calls.
+ * The layer is split into chunks of TILE_CHUNK_SIZE by TILE_CHUNK_SIZE
+ * tiles. A chunk is rendered once into a target image and then drawn
+ * as a single image until one of its tiles changes:
+ *
+ *     struct tile_layer* ground = create_tile_layer(tileset, 200, 200);
+ *     set_tile(ground, col, row, frame);
+ *
+ * Then, once per frame:
+ *
+ *     draw_tile_layer(ground, camera_x, camera_y, screen_w, screen_h);
+ *
+ * Only chunks inside the view are baked. Once more than max_chunks
+ * chunks are baked, the chunk that was drawn least recently hands its
+ * image over to the next chunk that needs one.
+ */
+struct tile_layer {
+    /** sprite holding the tile frames */
+    struct sprite* tileset;
+    /** layer width in tiles */
+    int cols;
+    /** layer height in tiles */
+    int rows;
+    /** tileset frame of every tile, row by row, or -1 for no tile */
+    int* tiles;
+    /** layer width in chunks */
+    int chunk_cols;
+    /** layer height in chunks */
+    int chunk_rows;
+    /** chunks, row by row */
+    struct tile_chunk* chunks;
+    /** most chunks to keep baked, 64 by default */
+    int max_chunks;
+    /** number of chunks currently baked */
+    int n_baked;
+    /** blend mode to draw the layer with, BLEND by default */
+    enum blend_mode blend;
+    /**
+     * animator playing the layer animated tiles, or NULL. Call
+     * invalidate_tile_layer() after changing it.
+     */
+    struct tile_animator* animator;
+    /* draw_tile_layer() call count, used to find the least recently
+     * drawn chunk */
+    unsigned long draws;
+};
+
+/**
+ * Create a new tile layer with no tiles
+ * @param tileset sprite holding the tile frames
+ * @param cols layer width in tiles
+ * @param rows layer height in tiles
+ *
+ * @return a new \ref tile_layer or NULL on error
+ */
+struct tile_layer* create_tile_layer(struct sprite* tileset,
+                                     int cols,
+                                     int rows);
+
+/**
+ * Destroy a tile layer created using create_tile_layer()
+ * @param layer tile layer to destroy. The tileset is not destroyed.
+ */
+void destroy_tile_layer(struct tile_layer* layer);
+
+/**
+ * Set a single tile
+ * @param layer layer to change
+ * @param col tile column
+ * @param row tile row
+ * @param tile tileset frame to show or -1 for no tile
+ *
+ * The chunk holding the tile is rendered again next time it is drawn.
+ */
+void set_tile(struct tile_layer* layer, int col, int row, int tile);
+
+/**
+ * Get a single tile
+ * @param layer layer to query
+ * @param col tile column
+ * @param row tile row
+ *
+ * @return the tileset frame or -1 for no tile or a tile outside the layer
+ */
+int get_tile(const struct tile_layer* layer, int col, int row);
+
+/**
+ * Render all chunks again next time they are drawn, e.g. after
+ * drawing on the tileset image.
+ * @param layer layer to invalidate
+ */
+void invalidate_tile_layer(struct tile_layer* layer);
+
+/**
+ * Draw the part of a tile layer that is inside a view
+ * @param layer layer to draw
+ * @param x layer x coordinates shown at the left of the view
+ * @param y layer y coordinates shown at the top of the view
+ * @param width view width
+ * @param height view height
+ *
+ * @return 0 on success or -1 if a chunk could not be rendered
+ */
+int draw_tile_layer(struct tile_layer* layer,
+                    int x,
+                    int y,
+                    int width,
+                    int height);
+
+#include "end_prefix.h"
+#endif /* end of include guard: TILE_LAYER_H_J5VPR2XE */
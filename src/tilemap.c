@@ -0,0 +1,280 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#include "tilemap.h"
+#include "utils.h"
+#include <stdlib.h>
+#include <string.h>
+#include "SDL.h"
+
+#include "internals.h"
+#include "pack.h"
+#include "begin_prefix.h"
+
+#define CACHE_MAGIC "CAGEMAP"
+#define CACHE_BYTE_ORDER 0x01020304u
+#define HASH_CHUNK_SIZE 65536
+
+/* Cache files start with this header, followed by the tiles array and
+ * the per-layer blocked bitsets, all in native byte order. */
+struct cache_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t source_hash;
+    int32_t cols;
+    int32_t rows;
+    int32_t tile_width;
+    int32_t tile_height;
+    int32_t n_layers;
+};
+
+struct tilemap* create_tilemap(int cols,
+                               int rows,
+                               int n_layers,
+                               int tile_width,
+                               int tile_height)
+{
+    struct tilemap* map;
+    size_t n_tiles;
+    int words;
+
+    if (cols <= 0 || rows <= 0 || n_layers <= 0) {
+        ERROR("Tilemap size must be positive");
+        return NULL;
+    }
+    n_tiles = (size_t)cols * rows;
+    words = (int)((n_tiles + 31) / 32);
+    map = (struct tilemap*)MALLOC(sizeof(struct tilemap), MEMORY_TILES);
+    if (map == NULL) goto error;
+    map->tiles = (uint16_t*)CALLOC(
+    n_tiles * n_layers, sizeof(uint16_t), MEMORY_TILES);
+    if (map->tiles == NULL) goto free_map;
+    /* the per-layer bitsets and the merged one share an allocation */
+    map->blocked = (uint32_t*)CALLOC((size_t)words * (n_layers + 1),
+                                     sizeof(uint32_t), MEMORY_TILES);
+    if (map->blocked == NULL) goto free_tiles;
+    map->solid = map->blocked + (size_t)words * n_layers;
+    map->bitset_words = words;
+    map->cols = cols;
+    map->rows = rows;
+    map->n_layers = n_layers;
+    map->tile_width = tile_width;
+    map->tile_height = tile_height;
+    return map;
+
+free_tiles:
+    FREE(map->tiles);
+free_map:
+    FREE(map);
+error:
+    ERROR("Unable to allocate tilemap");
+    return NULL;
+}
+
+void destroy_tilemap(struct tilemap* map)
+{
+    if (map == NULL) return;
+    FREE(map->blocked);
+    FREE(map->tiles);
+    FREE(map);
+}
+
+static bool is_inside(const struct tilemap* map, int layer, int col, int row)
+{
+    return layer >= 0 && layer < map->n_layers && col >= 0 &&
+           col < map->cols && row >= 0 && row < map->rows;
+}
+
+uint16_t get_map_tile(const struct tilemap* map, int layer, int col, int row)
+{
+    if (!is_inside(map, layer, col, row)) return 0;
+    return map->tiles[((size_t)layer * map->rows + row) * map->cols + col];
+}
+
+void set_map_tile(struct tilemap* map,
+                  int layer,
+                  int col,
+                  int row,
+                  uint16_t tile)
+{
+    if (!is_inside(map, layer, col, row)) return;
+    map->tiles[((size_t)layer * map->rows + row) * map->cols + col] = tile;
+}
+
+/* Rebuild the merged bitset words in [first, last) */
+static void merge_blocked(struct tilemap* map, int first, int last)
+{
+    int w, l;
+    for (w = first; w < last; w++) {
+        uint32_t bits = 0;
+        for (l = 0; l < map->n_layers; l++)
+            bits |= map->blocked[(size_t)l * map->bitset_words + w];
+        map->solid[w] = bits;
+    }
+}
+
+void set_tile_blocked(struct tilemap* map,
+                      int layer,
+                      int col,
+                      int row,
+                      bool blocked)
+{
+    size_t i;
+    uint32_t* word;
+    if (!is_inside(map, layer, col, row)) return;
+    i = (size_t)row * map->cols + col;
+    word = &map->blocked[(size_t)layer * map->bitset_words + i / 32];
+    if (blocked)
+        *word |= 1u << (i % 32);
+    else
+        *word &= ~(1u << (i % 32));
+    merge_blocked(map, (int)(i / 32), (int)(i / 32) + 1);
+}
+
+void block_map_tiles(struct tilemap* map,
+                     int layer,
+                     const uint16_t* ids,
+                     int n_ids)
+{
+    /* one bit for each possible tile id */
+    uint32_t lookup[65536 / 32];
+    const uint16_t* tiles;
+    uint32_t* blocked;
+    size_t n_tiles = (size_t)map->cols * map->rows;
+    size_t i;
+    int k;
+
+    if (layer < 0 || layer >= map->n_layers) return;
+    memset(lookup, 0, sizeof(lookup));
+    for (k = 0; k < n_ids; k++) lookup[ids[k] / 32] |= 1u << (ids[k] % 32);
+
+    tiles = map->tiles + (size_t)layer * n_tiles;
+    blocked = map->blocked + (size_t)layer * map->bitset_words;
+    for (i = 0; i < n_tiles; i++) {
+        uint32_t hit = (lookup[tiles[i] / 32] >> (tiles[i] % 32)) & 1u;
+        blocked[i / 32] |= hit << (i % 32);
+    }
+    merge_blocked(map, 0, map->bitset_words);
+}
+
+bool is_map_walkable(const struct tilemap* map, int col, int row)
+{
+    size_t i;
+    if ((unsigned)col >= (unsigned)map->cols ||
+        (unsigned)row >= (unsigned)map->rows)
+        return false;
+    i = (size_t)row * map->cols + col;
+    return ((map->solid[i / 32] >> (i % 32)) & 1u) == 0;
+}
+
+uint32_t hash_map_source(const char* filepath)
+{
+    /* 32 bit FNV-1a */
+    uint32_t hash = 2166136261u;
+    unsigned char* chunk;
+    size_t n, i;
+    SDL_RWops* rw = open_asset(filepath);
+    if (rw == NULL) return 0;
+    chunk = (unsigned char*)MALLOC(HASH_CHUNK_SIZE, MEMORY_TILES);
+    if (chunk == NULL) {
+        SDL_RWclose(rw);
+        return 0;
+    }
+    while ((n = SDL_RWread(rw, chunk, 1, HASH_CHUNK_SIZE)) > 0) {
+        for (i = 0; i < n; i++) {
+            hash ^= chunk[i];
+            hash *= 16777619u;
+        }
+    }
+    FREE(chunk);
+    SDL_RWclose(rw);
+    return hash != 0 ? hash : 1;
+}
+
+int save_tilemap(const struct tilemap* map,
+                 const char* filepath,
+                 uint32_t source_hash)
+{
+    struct cache_header header;
+    size_t n_tiles = (size_t)map->cols * map->rows * map->n_layers;
+    size_t n_words = (size_t)map->bitset_words * map->n_layers;
+    int ret = -1;
+    SDL_RWops* rw = SDL_RWFromFile(filepath, "wb");
+    if (rw == NULL) {
+        ERROR("Unable to open the tilemap cache for writing");
+        return -1;
+    }
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = TILEMAP_CACHE_VERSION;
+    header.byte_order = CACHE_BYTE_ORDER;
+    header.source_hash = source_hash;
+    header.cols = map->cols;
+    header.rows = map->rows;
+    header.tile_width = map->tile_width;
+    header.tile_height = map->tile_height;
+    header.n_layers = map->n_layers;
+    if (SDL_RWwrite(rw, &header, sizeof(header), 1) != 1 ||
+        SDL_RWwrite(rw, map->tiles, sizeof(uint16_t), n_tiles) != n_tiles ||
+        SDL_RWwrite(rw, map->blocked, sizeof(uint32_t), n_words) != n_words) {
+        ERROR("Unable to write the tilemap cache");
+        goto done;
+    }
+    ret = 0;
+done:
+    SDL_RWclose(rw);
+    return ret;
+}
+
+struct tilemap* load_tilemap(const char* filepath, uint32_t source_hash)
+{
+    struct cache_header header;
+    struct tilemap* map = NULL;
+    size_t n_tiles, n_words;
+    SDL_RWops* rw = open_asset(filepath);
+    if (rw == NULL) return NULL;
+
+    if (SDL_RWread(rw, &header, sizeof(header), 1) != 1 ||
+        memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+        header.version != TILEMAP_CACHE_VERSION ||
+        header.byte_order != CACHE_BYTE_ORDER ||
+        header.source_hash != source_hash)
+        goto done;
+
+    map = create_tilemap(header.cols, header.rows, header.n_layers,
+                         header.tile_width, header.tile_height);
+    if (map == NULL) goto done;
+    n_tiles = (size_t)map->cols * map->rows * map->n_layers;
+    n_words = (size_t)map->bitset_words * map->n_layers;
+    if (SDL_RWread(rw, map->tiles, sizeof(uint16_t), n_tiles) != n_tiles ||
+        SDL_RWread(rw, map->blocked, sizeof(uint32_t), n_words) != n_words) {
+        ERROR("Tilemap cache is truncated");
+        destroy_tilemap(map);
+        map = NULL;
+        goto done;
+    }
+    merge_blocked(map, 0, map->bitset_words);
+done:
+    SDL_RWclose(rw);
+    return map;
+}
+#include "end_prefix.h"
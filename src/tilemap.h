@@ -0,0 +1,198 @@
+/* Copyright (c) 2014-2016 Ithai Levi @RLofC
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty. In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ *    1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ *
+ *    2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ *
+ *    3. This notice may not be removed or altered from any source
+ *    distribution.
+ */
+#ifndef TILEMAP_H_E3HLD8VM
+#define TILEMAP_H_E3HLD8VM
+
+#include <stdint.h>
+#include "types.h"
+
+#include "begin_prefix.h"
+/** Version of the binary tilemap cache format */
+#define TILEMAP_CACHE_VERSION 1
+
+/**
+ * Tilemaps hold the tile layers of a game map in dense arrays, along
+ * with which tiles block movement.
+ * Tiles are 16 bit ids, where 0 means no tile, just like the global
+ * tile ids of Tiled maps. Each layer also has a bitset of blocked
+ * tiles, and a merged bitset tells if any layer blocks a position:
+ *
+ *     struct tilemap* map = create_tilemap(cols, rows, 2, 16, 16);
+ *     set_map_tile(map, 0, col, row, 17);
+ *     set_tile_blocked(map, 0, col, row, true);
+ *     if (is_map_walkable(map, col, row)) {
+ *         // ...
+ *     }
+ *
+ * Parsing a map editor file can take a while for large maps, so a
+ * tilemap can be saved to a binary cache using save_tilemap() and read
+ * back using load_tilemap(). The cache records a hash of the source
+ * file, so a changed source map is detected and parsed again:
+ *
+ *     uint32_t hash = hash_map_source("res/level.tmx");
+ *     struct tilemap* map = load_tilemap("res/level.map", hash);
+ *     if (map == NULL) {
+ *         // parse res/level.tmx into a new tilemap, then
+ *         save_tilemap(map, "res/level.map", hash);
+ *     }
+ */
+struct tilemap {
+    /** map width in tiles */
+    int cols;
+    /** map height in tiles */
+    int rows;
+    /** tile width in pixels */
+    int tile_width;
+    /** tile height in pixels */
+    int tile_height;
+    /** number of layers */
+    int n_layers;
+    /**
+     * Tile ids of all layers, layer by layer and row by row. The tile
+     * of a layer at col, row is
+     * ``tiles[(layer * rows + row) * cols + col]``.
+     */
+    uint16_t* tiles;
+    /** number of 32 bit words in each bitset */
+    int bitset_words;
+    /** blocked tiles of every layer, layer by layer */
+    uint32_t* blocked;
+    /** tiles blocked by any layer */
+    uint32_t* solid;
+};
+
+/**
+ * Create a new tilemap with no tiles
+ * @param cols map width in tiles
+ * @param rows map height in tiles
+ * @param n_layers number of layers
+ * @param tile_width tile width in pixels
+ * @param tile_height tile height in pixels
+ *
+ * @return a new \ref tilemap or NULL on error
+ */
+struct tilemap* create_tilemap(int cols,
+                               int rows,
+                               int n_layers,
+                               int tile_width,
+                               int tile_height);
+
+/**
+ * Destroy a tilemap
+ * @param map tilemap to destroy
+ */
+void destroy_tilemap(struct tilemap* map);
+
+/**
+ * Get a tile id
+ * @param map tilemap to query
+ * @param layer layer index
+ * @param col tile column
+ * @param row tile row
+ *
+ * @return the tile id, or 0 outside the map
+ */
+uint16_t get_map_tile(const struct tilemap* map, int layer, int col, int row);
+
+/**
+ * Set a tile id
+ * @param map tilemap to change
+ * @param layer layer index
+ * @param col tile column
+ * @param row tile row
+ * @param tile tile id or 0 for no tile
+ */
+void set_map_tile(struct tilemap* map,
+                  int layer,
+                  int col,
+                  int row,
+                  uint16_t tile);
+
+/**
+ * Mark a tile as blocking movement or not
+ * @param map tilemap to change
+ * @param layer layer index
+ * @param col tile column
+ * @param row tile row
+ * @param blocked true if the tile blocks movement
+ */
+void set_tile_blocked(struct tilemap* map,
+                      int layer,
+                      int col,
+                      int row,
+                      bool blocked);
+
+/**
+ * Mark every tile with one of the given ids as blocking movement
+ * @param map tilemap to change
+ * @param layer layer index
+ * @param ids tile ids that block movement
+ * @param n_ids number of ids
+ */
+void block_map_tiles(struct tilemap* map,
+                     int layer,
+                     const uint16_t* ids,
+                     int n_ids);
+
+/**
+ * Test if no layer blocks a position
+ * @param map tilemap to query
+ * @param col tile column
+ * @param row tile row
+ *
+ * @return true if the position is inside the map and not blocked
+ */
+bool is_map_walkable(const struct tilemap* map, int col, int row);
+
+/**
+ * Hash the content of a map source file, for use with save_tilemap()
+ * and load_tilemap().
+ * @param filepath path to the source map file
+ *
+ * @return the file hash, or 0 if the file cannot be read
+ */
+uint32_t hash_map_source(const char* filepath);
+
+/**
+ * Write a tilemap to a binary cache file
+ * @param map tilemap to save
+ * @param filepath path to the cache file
+ * @param source_hash hash of the map source, see hash_map_source()
+ *
+ * @return 0 on success or -1 on error
+ */
+int save_tilemap(const struct tilemap* map,
+                 const char* filepath,
+                 uint32_t source_hash);
+
+/**
+ * Read a tilemap from a binary cache file
+ * @param filepath path to the cache file
+ * @param source_hash hash of the map source, see hash_map_source()
+ *
+ * @return a new \ref tilemap, or NULL if there is no cache file or it was
+ * written by another cache version or from another source
+ */
+struct tilemap* load_tilemap(const char* filepath, uint32_t source_hash);
+
+#include "end_prefix.h"
+#endif /* end of include guard: TILEMAP_H_E3HLD8VM */
@@ -22,11 +22,13 @@
 #include "timeline.h"
 #include "utils.h"
 #include <stdlib.h>
+#include "internals.h"
 #include "begin_prefix.h"
 
 struct timeline* create_timeline(void)
 {
-    struct timeline* timeline = (struct timeline*)malloc(sizeof(struct timeline));
+    struct timeline* timeline = (struct timeline*)MALLOC(
+    sizeof(struct timeline), MEMORY_TIMELINES);
     if (timeline != NULL)
         init_timeline(timeline);
     else
@@ -36,7 +38,7 @@ struct timeline* create_timeline(void)
 
 void destroy_timeline(struct timeline* timeline)
 {
-    free(timeline);
+    FREE(timeline);
 }
 
 int append_event(struct timeline* timeline,